@@ -0,0 +1,176 @@
+/**
+ * @file Benchmark.cpp
+ * @brief Запуск бенчмарков и вывод результатов в консоль/JSON
+ */
+
+#include "Benchmark.h"
+#include <algorithm>
+#include <cstdio>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <regex>
+#include <sstream>
+#include <thread>
+
+namespace Bench {
+
+namespace {
+
+struct Options {
+    std::string filter = ".*";
+    std::string format = "console";
+    std::string outFile;
+    double minTime = 0.5;
+    std::int64_t maxArg = 1000000;
+};
+
+struct Result {
+    std::string name;
+    std::size_t iterations;
+    double realNs;
+    double cpuNs;
+    double itemsPerSecond;
+    double bytesPerSecond;
+};
+
+bool parseFlag(const std::string& arg, const std::string& flag, std::string& value) {
+    std::string prefix = "--" + flag + "=";
+    if (arg.compare(0, prefix.size(), prefix) != 0) return false;
+    value = arg.substr(prefix.size());
+    return true;
+}
+
+/**
+ * @brief Прогоняет бенчмарк, увеличивая число итераций до достижения minTime
+ */
+Result runOne(const std::string& name, const Function& fn, std::int64_t arg, double minTime) {
+    std::size_t iterations = 1;
+    while (true) {
+        State state(arg, iterations);
+        fn(state);
+
+        double elapsed = state.getRealSeconds();
+        if (elapsed >= minTime || iterations >= 1000000000) {
+            double perIter = 1e9 / static_cast<double>(iterations);
+            return Result{
+                name, iterations,
+                elapsed * perIter,
+                state.getCpuSeconds() * perIter,
+                elapsed > 0 ? state.getItemsProcessed() / elapsed : 0.0,
+                elapsed > 0 ? state.getBytesProcessed() / elapsed : 0.0
+            };
+        }
+
+        double growth = elapsed > 0 ? minTime * 1.4 / elapsed : 10.0;
+        growth = std::clamp(growth, 2.0, 10.0);
+        iterations = static_cast<std::size_t>(static_cast<double>(iterations) * growth);
+    }
+}
+
+std::string jsonEscape(const std::string& s) {
+    std::string out;
+    for (char c : s) {
+        if (c == '"' || c == '\\') out += '\\';
+        out += c;
+    }
+    return out;
+}
+
+void writeJson(std::ostream& os, const std::vector<Result>& results) {
+    os << "{\n";
+    os << "  \"context\": {\n";
+    os << "    \"executable\": \"FinanceTrackerBench\",\n";
+    os << "    \"num_cpus\": " << std::thread::hardware_concurrency() << ",\n";
+    os << "    \"library_build_type\": \"release\"\n";
+    os << "  },\n";
+    os << "  \"benchmarks\": [\n";
+    for (std::size_t i = 0; i < results.size(); ++i) {
+        const auto& r = results[i];
+        os << "    {\n";
+        os << "      \"name\": \"" << jsonEscape(r.name) << "\",\n";
+        os << "      \"run_type\": \"iteration\",\n";
+        os << "      \"iterations\": " << r.iterations << ",\n";
+        os << "      \"real_time\": " << std::fixed << std::setprecision(3) << r.realNs << ",\n";
+        os << "      \"cpu_time\": " << r.cpuNs << ",\n";
+        os << "      \"time_unit\": \"ns\"";
+        if (r.itemsPerSecond > 0) os << ",\n      \"items_per_second\": " << r.itemsPerSecond;
+        if (r.bytesPerSecond > 0) os << ",\n      \"bytes_per_second\": " << r.bytesPerSecond;
+        os << "\n    }" << (i + 1 < results.size() ? "," : "") << "\n";
+    }
+    os << "  ]\n";
+    os << "}\n";
+}
+
+void writeConsoleRow(std::ostream& os, const Result& r) {
+    os << std::left << std::setw(44) << r.name << std::right
+       << std::setw(16) << std::fixed << std::setprecision(0) << r.realNs << " ns"
+       << std::setw(16) << r.cpuNs << " ns"
+       << std::setw(12) << r.iterations;
+    if (r.itemsPerSecond > 0) {
+        os << "  items/s=" << std::setprecision(0) << r.itemsPerSecond;
+    }
+    os << "\n";
+}
+
+} // namespace
+
+int runAll(int argc, char** argv) {
+    Options options;
+    for (int i = 1; i < argc; ++i) {
+        std::string arg = argv[i];
+        std::string value;
+        if (parseFlag(arg, "benchmark_filter", value)) options.filter = value;
+        else if (parseFlag(arg, "benchmark_format", value)) options.format = value;
+        else if (parseFlag(arg, "benchmark_out", value)) options.outFile = value;
+        else if (parseFlag(arg, "benchmark_min_time", value)) options.minTime = std::stod(value);
+        else if (parseFlag(arg, "benchmark_max_arg", value)) options.maxArg = std::stoll(value);
+        else {
+            std::cerr << "Unknown flag: " << arg << "\n";
+            return 1;
+        }
+    }
+
+    std::regex filter(options.filter);
+    std::ostream out(std::cout.rdbuf());
+    bool console = options.format != "json";
+    if (console) {
+        out << std::left << std::setw(44) << "Benchmark" << std::right
+            << std::setw(19) << "Time" << std::setw(19) << "CPU"
+            << std::setw(12) << "Iterations" << "\n";
+        out << std::string(94, '-') << "\n";
+    }
+
+    // Сообщения вида "Report saved to" не должны попадать в машиночитаемый вывод
+    std::stringstream sink;
+    auto* original = std::cout.rdbuf(sink.rdbuf());
+
+    std::vector<Result> results;
+    for (const auto& reg : registry()) {
+        for (std::int64_t arg : reg.args) {
+            if (arg > options.maxArg) continue;
+            std::string name = reg.name + (reg.args.size() > 1 || arg != 0 ? "/" + std::to_string(arg) : "");
+            if (!std::regex_search(name, filter)) continue;
+
+            results.push_back(runOne(name, reg.fn, arg, options.minTime));
+            sink.str("");
+            if (console) {
+                writeConsoleRow(out, results.back());
+                out.flush();
+            }
+        }
+    }
+
+    std::cout.rdbuf(original);
+
+    if (!console) {
+        writeJson(out, results);
+    }
+    if (!options.outFile.empty()) {
+        std::ofstream file(options.outFile);
+        writeJson(file, results);
+    }
+    return 0;
+}
+
+} // namespace Bench
@@ -0,0 +1,135 @@
+#pragma once
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <ctime>
+#include <functional>
+#include <string>
+#include <vector>
+
+/**
+ * @brief Минимальный каркас микробенчмарков в стиле Google Benchmark
+ *
+ * Не требует внешних зависимостей. Тело бенчмарка получает State и
+ * крутит цикл `for (auto _ : state)`; число итераций подбирается
+ * автоматически, пока суммарное время не превысит minTime.
+ * Результаты выводятся в консоль или в JSON того же формата,
+ * что и у Google Benchmark (--benchmark_format=json).
+ */
+namespace Bench {
+
+class State {
+    std::int64_t rangeArg;
+    std::size_t maxIterations;
+    std::size_t itemsProcessed = 0;
+    std::size_t bytesProcessed = 0;
+    bool timerRunning = false;
+    std::chrono::steady_clock::time_point realStart;
+    std::clock_t cpuStart = 0;
+    double realSeconds = 0.0;
+    double cpuSeconds = 0.0;
+
+public:
+    State(std::int64_t arg, std::size_t iterations) : rangeArg(arg), maxIterations(iterations) {}
+
+    // Нетривиальный деструктор подавляет предупреждение о неиспользуемой `_`
+    struct Value {
+        ~Value() {}
+    };
+
+    struct Iterator {
+        State* state;
+        std::size_t remaining;
+
+        bool operator!=(const Iterator&) const {
+            if (remaining != 0) return true;
+            state->stopTimer();
+            return false;
+        }
+        void operator++() { --remaining; }
+        Value operator*() const { return Value{}; }
+    };
+
+    Iterator begin() {
+        startTimer();
+        return Iterator{this, maxIterations};
+    }
+    Iterator end() { return Iterator{this, 0}; }
+
+    std::int64_t range(int = 0) const { return rangeArg; }
+    std::size_t iterations() const { return maxIterations; }
+
+    /**
+     * @brief Приостанавливает замер (например, на подготовку данных)
+     */
+    void pauseTiming() { stopTimer(); }
+    void resumeTiming() { startTimer(); }
+
+    void setItemsProcessed(std::size_t items) { itemsProcessed = items; }
+    void setBytesProcessed(std::size_t bytes) { bytesProcessed = bytes; }
+
+    double getRealSeconds() const { return realSeconds; }
+    double getCpuSeconds() const { return cpuSeconds; }
+    std::size_t getItemsProcessed() const { return itemsProcessed; }
+    std::size_t getBytesProcessed() const { return bytesProcessed; }
+
+private:
+    void startTimer() {
+        if (timerRunning) return;
+        timerRunning = true;
+        realStart = std::chrono::steady_clock::now();
+        cpuStart = std::clock();
+    }
+    void stopTimer() {
+        if (!timerRunning) return;
+        timerRunning = false;
+        realSeconds += std::chrono::duration<double>(std::chrono::steady_clock::now() - realStart).count();
+        cpuSeconds += static_cast<double>(std::clock() - cpuStart) / CLOCKS_PER_SEC;
+    }
+};
+
+using Function = std::function<void(State&)>;
+
+struct Registration {
+    std::string name;
+    Function fn;
+    std::vector<std::int64_t> args;
+};
+
+/**
+ * @brief Глобальный реестр бенчмарков
+ */
+inline std::vector<Registration>& registry() {
+    static std::vector<Registration> benchmarks;
+    return benchmarks;
+}
+
+/**
+ * @brief Регистрирует бенчмарк с набором значений аргумента
+ */
+inline bool registerBenchmark(const std::string& name, Function fn,
+                              std::vector<std::int64_t> args = {0}) {
+    registry().push_back({name, std::move(fn), std::move(args)});
+    return true;
+}
+
+/**
+ * @brief Запускает все зарегистрированные бенчмарки, разбирая аргументы командной строки
+ *
+ * Поддерживаемые флаги: --benchmark_filter=<regex>, --benchmark_format=console|json,
+ * --benchmark_out=<file>, --benchmark_min_time=<sec>, --benchmark_max_arg=<N>
+ * (по умолчанию 1000000: прогоны на 10M строк включаются явно).
+ * @return Код завершения процесса
+ */
+int runAll(int argc, char** argv);
+
+} // namespace Bench
+
+#define BENCH_CONCAT_INNER(a, b) a##b
+#define BENCH_CONCAT(a, b) BENCH_CONCAT_INNER(a, b)
+
+// Регистрация: BENCHMARK_ARGS(BM_Name, {1000, 1000000});
+#define BENCHMARK_ARGS(fn, ...) \
+    static bool BENCH_CONCAT(bench_reg_, __LINE__) = Bench::registerBenchmark(#fn, fn, __VA_ARGS__)
+#define BENCHMARK(fn) \
+    static bool BENCH_CONCAT(bench_reg_, __LINE__) = Bench::registerBenchmark(#fn, fn)
@@ -0,0 +1,75 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <random>
+#include <string>
+#include <vector>
+#include "../src/accounts/Account.h"
+#include "../src/categories/Category.h"
+#include "../src/transactions/Transaction.h"
+
+/**
+ * @brief Генератор синтетического журнала транзакций для бенчмарков
+ *
+ * Детерминирован по seed: одинаковые параметры дают одинаковый журнал,
+ * поэтому результаты разных прогонов сравнимы между собой.
+ */
+class LedgerGenerator {
+    std::mt19937_64 rng;
+    std::vector<std::shared_ptr<Account>> accounts;
+    std::vector<std::shared_ptr<Category>> categories;
+
+public:
+    explicit LedgerGenerator(std::uint64_t seed = 42, std::size_t accountCount = 16) : rng(seed) {
+        for (std::size_t i = 0; i < accountCount; ++i) {
+            std::string name = "Счёт " + std::to_string(i);
+            switch (i % 3) {
+                case 0: accounts.push_back(std::make_shared<DebitAccount>(name, 25000)); break;
+                case 1: accounts.push_back(std::make_shared<CreditAccount>(name, 10000, 50000)); break;
+                default: accounts.push_back(std::make_shared<SavingsAccount>(name, 75000)); break;
+            }
+        }
+        categories.push_back(std::make_shared<ExpenseCategory>("Продукты", 5000));
+        categories.push_back(std::make_shared<ExpenseCategory>("Транспорт", 3000));
+        categories.push_back(std::make_shared<IncomeCategory>("Зарплата"));
+        categories.push_back(std::make_shared<Category>("Разное"));
+    }
+
+    const std::vector<std::shared_ptr<Account>>& getAccounts() const { return accounts; }
+    const std::vector<std::shared_ptr<Category>>& getCategories() const { return categories; }
+
+    /**
+     * @brief Создаёт одну случайную транзакцию (70% списаний, 25% пополнений, 5% процентов)
+     */
+    std::shared_ptr<Transactions::Transaction> next() {
+        std::uniform_int_distribution<int> kind(0, 99);
+        std::uniform_real_distribution<double> amount(10.0, 5000.0);
+        auto& account = accounts[rng() % accounts.size()];
+        auto& category = categories[rng() % categories.size()];
+
+        int k = kind(rng);
+        if (k < 70) {
+            return std::make_shared<Transactions::WithdrawalTransaction>(
+                amount(rng), "Продукты в магазине", category, account);
+        }
+        if (k < 95) {
+            return std::make_shared<Transactions::DepositTransaction>(
+                amount(rng) * 4, "Зарплата за месяц", category, account);
+        }
+        return std::make_shared<Transactions::CompoundingTransaction>(
+            amount(rng) * 10, "Начисление процентов", 30, 5.0, category, account);
+    }
+
+    /**
+     * @brief Создаёт журнал из rows транзакций
+     */
+    std::vector<std::shared_ptr<Transactions::Transaction>> generate(std::size_t rows) {
+        std::vector<std::shared_ptr<Transactions::Transaction>> ledger;
+        ledger.reserve(rows);
+        for (std::size_t i = 0; i < rows; ++i) {
+            ledger.push_back(next());
+        }
+        return ledger;
+    }
+};
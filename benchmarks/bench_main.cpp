@@ -0,0 +1,219 @@
+/**
+ * @file bench_main.cpp
+ * @brief Бенчмарки загрузки журнала, агрегации и экспорта отчётов
+ */
+
+#include <algorithm>
+#include <cstdio>
+#include <filesystem>
+#include <map>
+#include "Benchmark.h"
+#include "LedgerGenerator.h"
+#include "../src/reports/Report.h"
+#include "../src/reports/ArrowReport.h"
+#include "../src/ledger/DedupIndex.h"
+#include "../src/users/User.h"
+#include "../src/utils/DateUtils.h"
+
+namespace {
+
+const std::vector<std::int64_t> LEDGER_SIZES = {1000, 1000000, 10000000};
+
+/**
+ * @brief Журнал заданного размера строится один раз и переиспользуется
+ */
+const std::vector<std::shared_ptr<Transactions::Transaction>>& ledger(std::int64_t rows) {
+    static std::map<std::int64_t, std::vector<std::shared_ptr<Transactions::Transaction>>> cache;
+    auto it = cache.find(rows);
+    if (it == cache.end()) {
+        LedgerGenerator generator;
+        it = cache.emplace(rows, generator.generate(static_cast<std::size_t>(rows))).first;
+    }
+    return it->second;
+}
+
+template<typename R>
+R& report(std::int64_t rows) {
+    static std::map<std::int64_t, std::unique_ptr<R>> cache;
+    auto& slot = cache[rows];
+    if (!slot) {
+        slot = std::make_unique<R>("Benchmark report");
+        slot->setTransactions(ledger(rows));
+    }
+    return *slot;
+}
+
+std::string tempPath(const std::string& name) {
+    return (std::filesystem::temp_directory_path() / name).string();
+}
+
+void BM_AccountDeposit(Bench::State& state) {
+    DebitAccount account("Основной", 0);
+    for (auto _ : state) {
+        account.deposit(1.0);
+    }
+    state.setItemsProcessed(state.iterations());
+}
+
+void BM_AccountWithdraw(Bench::State& state) {
+    CreditAccount account("Кредитка", 1e12, 50000);
+    for (auto _ : state) {
+        account.withdraw(1.0);
+    }
+    state.setItemsProcessed(state.iterations());
+}
+
+void BM_AccountHoldCapture(Bench::State& state) {
+    CreditAccount account("Кредитка", 1e12, 50000);
+    for (auto _ : state) {
+        Hold hold = account.placeHold(1.0);
+        hold.capture();
+    }
+    state.setItemsProcessed(state.iterations());
+}
+
+void BM_TransactionConstruct(Bench::State& state) {
+    LedgerGenerator generator;
+    auto account = generator.getAccounts()[0];
+    auto category = generator.getCategories()[0];
+    for (auto _ : state) {
+        auto t = std::make_shared<Transactions::WithdrawalTransaction>(
+            150.0, "Продукты в магазине", category, account);
+        (void)t;
+    }
+    state.setItemsProcessed(state.iterations());
+}
+
+void BM_LedgerIngest(Bench::State& state) {
+    const auto& rows = ledger(state.range());
+    for (auto _ : state) {
+        Reports::TextReport r("Ingest");
+        for (const auto& t : rows) {
+            r.addTransaction(t);
+        }
+    }
+    state.setItemsProcessed(state.iterations() * rows.size());
+}
+
+void BM_ReportTotalIncome(Bench::State& state) {
+    auto& r = report<Reports::TextReport>(state.range());
+    volatile double sink = 0;
+    for (auto _ : state) {
+        sink = r.getTotalIncome();
+    }
+    (void)sink;
+    state.setItemsProcessed(state.iterations() * state.range());
+}
+
+void BM_ReportTotalExpenses(Bench::State& state) {
+    auto& r = report<Reports::TextReport>(state.range());
+    volatile double sink = 0;
+    for (auto _ : state) {
+        sink = r.getTotalExpenses();
+    }
+    (void)sink;
+    state.setItemsProcessed(state.iterations() * state.range());
+}
+
+void BM_ReportNetBalance(Bench::State& state) {
+    auto& r = report<Reports::TextReport>(state.range());
+    volatile double sink = 0;
+    for (auto _ : state) {
+        sink = r.getNetBalance();
+    }
+    (void)sink;
+    state.setItemsProcessed(state.iterations() * state.range());
+}
+
+void BM_FormatTimePoint(Bench::State& state) {
+    auto now = std::chrono::system_clock::now();
+    std::size_t bytes = 0;
+    for (auto _ : state) {
+        bytes += DateUtils::formatTimePoint(now).size();
+    }
+    state.setItemsProcessed(state.iterations());
+    state.setBytesProcessed(bytes);
+}
+
+template<typename R>
+void saveBenchmark(Bench::State& state, const std::string& fileName) {
+    auto& r = report<R>(state.range());
+    r.setVerbose(false);
+    std::string path = tempPath(fileName);
+    for (auto _ : state) {
+        r.saveToFile(path);
+    }
+    std::error_code ec;
+    auto size = std::filesystem::file_size(path, ec);
+    state.setItemsProcessed(state.iterations() * state.range());
+    state.setBytesProcessed(ec ? 0 : state.iterations() * size);
+    std::remove(path.c_str());
+}
+
+void BM_TextReportSave(Bench::State& state) { saveBenchmark<Reports::TextReport>(state, "bench_report.txt"); }
+void BM_CSVReportSave(Bench::State& state) { saveBenchmark<Reports::CSVReport>(state, "bench_report.csv"); }
+void BM_JSONReportSave(Bench::State& state) { saveBenchmark<Reports::JSONReport>(state, "bench_report.json"); }
+void BM_ArrowReportSave(Bench::State& state) { saveBenchmark<Reports::ArrowReport>(state, "bench_report.arrow"); }
+
+// Выгрузка двух столбцов: остальные поля не вычисляются
+void BM_CSVReportSaveProjected(Bench::State& state) {
+    Reports::CSVReport r("Projected");
+    r.setVerbose(false);
+    Reports::ReportQuery query;
+    std::string error;
+    query.parse("columns=date,amount", error);
+    r.setQuery(query);
+    r.setTransactions(ledger(state.range()));
+    std::string path = tempPath("bench_report_projected.csv");
+    for (auto _ : state) {
+        r.saveToFile(path);
+    }
+    state.setItemsProcessed(state.iterations() * state.range());
+    std::remove(path.c_str());
+}
+
+// Поиск повторов пакета из 10000 строк (половина уже в истории) в истории заданного размера
+void BM_DedupFindDuplicates(Bench::State& state) {
+    const auto& rows = ledger(state.range());
+    User user("Dedup");
+    for (const auto& t : rows) {
+        user.addTransaction(t);
+    }
+    DedupIndex index;
+    index.sync(user);
+
+    LedgerGenerator fresh(7);
+    std::vector<std::shared_ptr<Transactions::Transaction>> batch = fresh.generate(5000);
+    for (std::size_t i = 0; i < 5000; ++i) {
+        batch.push_back(rows[(i * 7919) % rows.size()]);
+    }
+    std::size_t duplicates = 0;
+    for (auto _ : state) {
+        auto found = index.findDuplicates(batch);
+        duplicates = static_cast<std::size_t>(std::count(found.begin(), found.end(), true));
+    }
+    state.setItemsProcessed(state.iterations() * batch.size());
+    (void)duplicates;
+}
+
+} // namespace
+
+BENCHMARK(BM_AccountDeposit);
+BENCHMARK(BM_AccountWithdraw);
+BENCHMARK(BM_AccountHoldCapture);
+BENCHMARK(BM_TransactionConstruct);
+BENCHMARK(BM_FormatTimePoint);
+BENCHMARK_ARGS(BM_LedgerIngest, LEDGER_SIZES);
+BENCHMARK_ARGS(BM_ReportTotalIncome, LEDGER_SIZES);
+BENCHMARK_ARGS(BM_ReportTotalExpenses, LEDGER_SIZES);
+BENCHMARK_ARGS(BM_ReportNetBalance, LEDGER_SIZES);
+BENCHMARK_ARGS(BM_TextReportSave, LEDGER_SIZES);
+BENCHMARK_ARGS(BM_CSVReportSave, LEDGER_SIZES);
+BENCHMARK_ARGS(BM_JSONReportSave, LEDGER_SIZES);
+BENCHMARK_ARGS(BM_ArrowReportSave, LEDGER_SIZES);
+BENCHMARK_ARGS(BM_CSVReportSaveProjected, LEDGER_SIZES);
+BENCHMARK_ARGS(BM_DedupFindDuplicates, LEDGER_SIZES);
+
+int main(int argc, char** argv) {
+    return Bench::runAll(argc, argv);
+}
@@ -0,0 +1,169 @@
+/**
+ * @file LoadDriver.cpp
+ * @brief Открытый цикл проводки нагрузки с замером задержек от расписания
+ */
+
+#include "LoadDriver.h"
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <functional>
+#include <random>
+#include <thread>
+#include <vector>
+
+namespace Load {
+
+namespace {
+
+using Clock = std::chrono::steady_clock;
+
+// Ожидание короче этого крутится в цикле: sleep_for просыпается с опозданием
+constexpr std::int64_t SPIN_NANOS = 200000;
+
+void add(Metrics::HistogramSnapshot& histogram, std::uint64_t nanos) {
+    ++histogram.count;
+    histogram.sumNanos += nanos;
+    histogram.maxNanos = std::max(histogram.maxNanos, nanos);
+    ++histogram.buckets[Metrics::bucketIndex(nanos)];
+}
+
+void merge(Metrics::HistogramSnapshot& into, const Metrics::HistogramSnapshot& from) {
+    into.count += from.count;
+    into.sumNanos += from.sumNanos;
+    into.maxNanos = std::max(into.maxNanos, from.maxNanos);
+    for (std::size_t i = 0; i < into.buckets.size(); ++i) {
+        into.buckets[i] += from.buckets[i];
+    }
+}
+
+std::int64_t nanosSince(Clock::time_point start, Clock::time_point t) {
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(t - start).count();
+}
+
+/**
+ * @brief Моменты поступления событий от начала прогона, нс
+ */
+std::vector<std::int64_t> schedule(std::size_t count, const Settings& settings) {
+    std::vector<std::int64_t> offsets(count, 0);
+    if (settings.rate <= 0) {
+        return offsets;
+    }
+    std::mt19937_64 engine(settings.seed);
+    const double interval = 1e9 / settings.rate;
+    double t = 0.0;
+    for (std::size_t i = 0; i < count; ++i) {
+        offsets[i] = static_cast<std::int64_t>(t);
+        if (settings.poisson) {
+            double u = 1.0 - static_cast<double>(engine() >> 11) * 0x1.0p-53;
+            t += -std::log(u) * interval;
+        } else {
+            t += interval;
+        }
+    }
+    return offsets;
+}
+
+std::shared_ptr<Transactions::Transaction> makeTransaction(const User& user, const Workload& workload, const Event& event) {
+    const auto& account = user.getAccounts()[event.account];
+    std::shared_ptr<Category> category;
+    if (event.category >= 0) {
+        category = user.getCategories()[static_cast<std::size_t>(event.category)];
+    }
+    const std::string& description = workload.descriptions[event.description];
+    std::shared_ptr<Transactions::Transaction> trans;
+    switch (event.type) {
+        case 0:
+            trans = std::make_shared<Transactions::DepositTransaction>(event.amount, description, category, account);
+            break;
+        case 1:
+            trans = std::make_shared<Transactions::WithdrawalTransaction>(event.amount, description, category, account);
+            break;
+        default:
+            trans = std::make_shared<Transactions::CompoundingTransaction>(
+                event.amount, description, event.period, event.rate, category, account);
+            break;
+    }
+    if (event.date != 0) {
+        trans->setDate(std::chrono::system_clock::time_point(std::chrono::seconds(event.date)));
+    }
+    return trans;
+}
+
+struct Shard {
+    std::vector<std::size_t> events;   // номера событий потока в порядке поступления
+    Metrics::HistogramSnapshot response;
+    Metrics::HistogramSnapshot service;
+    std::size_t rejected = 0;
+    std::int64_t maxLag = 0;
+    Clock::time_point finished;
+};
+
+void drive(Shard& shard, const std::vector<std::shared_ptr<User>>& users, const Workload& workload,
+           const std::vector<std::int64_t>& offsets, bool openLoop, Clock::time_point start) {
+    for (std::size_t i : shard.events) {
+        const Event& event = workload.events[i];
+        Clock::time_point intended = start + std::chrono::nanoseconds(offsets[i]);
+        for (auto now = Clock::now(); now < intended; now = Clock::now()) {
+            if (nanosSince(now, intended) > SPIN_NANOS) {
+                std::this_thread::sleep_for(intended - now - std::chrono::nanoseconds(SPIN_NANOS / 2));
+            }
+        }
+
+        auto begin = Clock::now();
+        User& user = *users[event.user];
+        if (!user.post(makeTransaction(user, workload, event))) {
+            ++shard.rejected;
+        }
+        auto end = Clock::now();
+
+        if (!openLoop) {
+            intended = begin;
+        }
+        shard.maxLag = std::max(shard.maxLag, nanosSince(intended, begin));
+        add(shard.response, static_cast<std::uint64_t>(std::max<std::int64_t>(nanosSince(intended, end), 0)));
+        add(shard.service, static_cast<std::uint64_t>(nanosSince(begin, end)));
+    }
+    shard.finished = Clock::now();
+}
+
+} // namespace
+
+Result run(Ledger& ledger, const Workload& workload, const Settings& settings) {
+    const auto& users = ledger.getUsers();
+    const std::size_t threads = std::max<std::size_t>(settings.threads, 1);
+    std::vector<Shard> shards(threads);
+    for (std::size_t i = 0; i < workload.events.size(); ++i) {
+        shards[workload.events[i].user % threads].events.push_back(i);
+    }
+    const auto offsets = schedule(workload.events.size(), settings);
+    const bool openLoop = settings.rate > 0;
+
+    // Небольшой запас, чтобы все потоки успели стартовать до первого события
+    const Clock::time_point start = Clock::now() + std::chrono::milliseconds(10);
+    std::vector<std::thread> workers;
+    for (std::size_t t = 1; t < threads; ++t) {
+        workers.emplace_back(drive, std::ref(shards[t]), std::cref(users), std::cref(workload),
+                             std::cref(offsets), openLoop, start);
+    }
+    drive(shards[0], users, workload, offsets, openLoop, start);
+    for (auto& worker : workers) {
+        worker.join();
+    }
+
+    Result result;
+    result.events = workload.events.size();
+    Clock::time_point finished = start;
+    for (const auto& shard : shards) {
+        merge(result.response, shard.response);
+        merge(result.service, shard.service);
+        result.rejected += shard.rejected;
+        result.maxLagNanos = std::max(result.maxLagNanos, static_cast<std::uint64_t>(std::max<std::int64_t>(shard.maxLag, 0)));
+        finished = std::max(finished, shard.finished);
+    }
+    result.seconds = nanosSince(start, finished) / 1e9;
+    result.scheduledSeconds = offsets.empty() ? 0.0 : offsets.back() / 1e9;
+    return result;
+}
+
+} // namespace Load
@@ -0,0 +1,52 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include "../src/ledger/Ledger.h"
+#include "../src/metrics/Metrics.h"
+#include "Workload.h"
+
+namespace Load {
+
+/**
+ * @brief Параметры прогона нагрузки
+ */
+struct Settings {
+    double rate = 10000.0;      // целевая интенсивность, событий в секунду (0 — без расписания)
+    bool poisson = true;        // экспоненциальные интервалы между событиями, иначе равные
+    std::size_t threads = 1;    // пользователи делятся между потоками по номеру
+    std::uint64_t seed = 42;    // для интервалов пуассоновского потока
+};
+
+struct Result {
+    std::size_t events = 0;
+    std::size_t rejected = 0;              // списания, отклоненные счетом
+    double seconds = 0.0;                  // от начала расписания до последнего завершения
+    double scheduledSeconds = 0.0;         // длительность самого расписания
+    Metrics::HistogramSnapshot response;   // от запланированного начала до завершения
+    Metrics::HistogramSnapshot service;    // от фактического начала до завершения
+    std::uint64_t maxLagNanos = 0;         // наибольшее опоздание начала против расписания
+
+    double throughput() const { return seconds > 0 ? events / seconds : 0.0; }
+};
+
+/**
+ * @brief Проводит события нагрузки через User::post в открытом цикле
+ *
+ * Моменты поступления событий рассчитываются заранее по целевой
+ * интенсивности и не зависят от того, как быстро отвечает система:
+ * если проводка отстает, следующие события ждут в очереди, и их задержка
+ * отсчитывается от запланированного момента, а не от фактического начала
+ * (без «скоординированного упущения», при котором медленные ответы
+ * прореживают замеры). Время обслуживания замеряется отдельно.
+ *
+ * Пользователи делятся между потоками по номеру, поэтому каждый пользователь
+ * обслуживается одним потоком; общее расписание поступлений при этом
+ * не меняется. При rate == 0 события идут подряд (закрытый цикл), и задержка
+ * равна времени обслуживания.
+ *
+ * Пользователи журнала должны быть в памяти; журнал во время прогона
+ * не используется, проводки меняют балансы и историю пользователей.
+ */
+Result run(Ledger& ledger, const Workload& workload, const Settings& settings);
+
+} // namespace Load
@@ -0,0 +1,368 @@
+/**
+ * @file Workload.cpp
+ * @brief Синтез и повтор нагрузки для генератора нагрузки
+ */
+
+#include "Workload.h"
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <fstream>
+#include <ostream>
+#include <random>
+#include <unordered_map>
+#include "../src/utils/DateUtils.h"
+#include "../src/utils/Utils.h"
+
+namespace Load {
+
+namespace {
+
+constexpr std::uint8_t DEPOSIT = 0;
+constexpr std::uint8_t WITHDRAWAL = 1;
+constexpr std::uint8_t COMPOUNDING = 2;
+constexpr std::uint16_t COMPOUNDING_PERIOD = 30;
+constexpr double TWO_PI = 6.283185307179586;
+
+struct ExpenseKind {
+    const char* name;
+    double budget;
+    const char* merchants[3];
+};
+
+const ExpenseKind EXPENSES[] = {
+    {"Продукты", 15000, {"Супермаркет", "Магазин у дома", "Рынок"}},
+    {"Транспорт", 5000, {"Метро", "Такси", "АЗС"}},
+    {"Кафе", 8000, {"Кофейня", "Столовая", "Ресторан"}},
+    {"Дом", 10000, {"Хозтовары", "Коммунальные услуги", "Ремонт"}},
+    {"Здоровье", 6000, {"Аптека", "Клиника", "Анализы"}},
+    {"Развлечения", 7000, {"Кино", "Концерт", "Подписка"}},
+    {"Одежда", 9000, {"Обувь", "Универмаг", "Интернет-магазин"}},
+    {"Связь", 1500, {"Мобильная связь", "Интернет", "Телевидение"}},
+};
+constexpr std::size_t EXPENSE_KINDS = sizeof(EXPENSES) / sizeof(EXPENSES[0]);
+
+/**
+ * @brief Случайные величины поверх mt19937_64
+ *
+ * Последовательность mt19937_64 задана стандартом, а std::*_distribution —
+ * нет, поэтому преобразования написаны здесь.
+ */
+class Random {
+    std::mt19937_64 engine;
+
+public:
+    explicit Random(std::uint64_t seed) : engine(seed) {}
+
+    // Равномерно в [0, 1) с 53 значащими битами
+    double uniform() { return static_cast<double>(engine() >> 11) * 0x1.0p-53; }
+    std::uint64_t below(std::uint64_t n) { return n ? engine() % n : 0; }
+    // Стандартное нормальное (Бокс — Мюллер)
+    double normal() {
+        double u1 = 1.0 - uniform();
+        double u2 = uniform();
+        return std::sqrt(-2.0 * std::log(u1)) * std::cos(TWO_PI * u2);
+    }
+    double lognormal(double median, double sigma) { return median * std::exp(sigma * normal()); }
+    // Номер по накопленным весам
+    std::size_t pick(const std::vector<double>& cumulative) {
+        double x = uniform() * cumulative.back();
+        auto it = std::upper_bound(cumulative.begin(), cumulative.end(), x);
+        return std::min(static_cast<std::size_t>(it - cumulative.begin()), cumulative.size() - 1);
+    }
+};
+
+std::vector<double> cumulativeOf(const double* weights, std::size_t count) {
+    std::vector<double> cumulative(count);
+    double sum = 0.0;
+    for (std::size_t i = 0; i < count; ++i) {
+        sum += std::max(weights[i], 0.0);
+        cumulative[i] = sum;
+    }
+    return cumulative;
+}
+
+double roundCents(double amount) { return std::max(std::round(amount * 100.0) / 100.0, 0.01); }
+
+// Счета пользователя по назначению (номера в User::getAccounts)
+struct UserShape {
+    std::vector<std::uint16_t> spending;   // дебетовые и кредитные
+    std::vector<std::uint16_t> income;     // дебетовые, иначе кредитные
+    std::vector<std::uint16_t> savings;
+    std::int16_t salary = -1;              // номера категорий
+    std::int16_t interest = -1;
+};
+
+bool parseNumber(const std::string& text, double& value) {
+    if (text.empty()) return false;
+    char* end = nullptr;
+    value = std::strtod(text.c_str(), &end);
+    return end == text.c_str() + text.size() && std::isfinite(value);
+}
+
+} // namespace
+
+const char* typeName(std::uint8_t type) {
+    switch (type) {
+        case DEPOSIT: return "DEPOSIT";
+        case WITHDRAWAL: return "WITHDRAWAL";
+        default: return "COMPOUNDING";
+    }
+}
+
+bool parseType(const std::string& name, std::uint8_t& type) {
+    if (name == "DEPOSIT") type = DEPOSIT;
+    else if (name == "WITHDRAWAL") type = WITHDRAWAL;
+    else if (name == "COMPOUNDING") type = COMPOUNDING;
+    else return false;
+    return true;
+}
+
+Workload synthesize(const Profile& profile, Ledger& ledger) {
+    Random random(profile.seed);
+    Workload workload;
+
+    const std::size_t expenseCount = std::min<std::size_t>(std::max<std::uint32_t>(profile.categories, 1), EXPENSE_KINDS);
+    // Описания: три продавца на расходную категорию, затем зарплата и проценты
+    for (std::size_t k = 0; k < expenseCount; ++k) {
+        for (const char* merchant : EXPENSES[k].merchants) {
+            workload.descriptions.push_back(std::string(merchant) + ": " + EXPENSES[k].name);
+        }
+    }
+    const auto salaryDescription = static_cast<std::uint32_t>(workload.descriptions.size());
+    workload.descriptions.push_back("Зарплата за месяц");
+    const auto interestDescription = static_cast<std::uint32_t>(workload.descriptions.size());
+    workload.descriptions.push_back("Начисление процентов");
+
+    // Пользователи, счета и категории
+    static const char* const ACCOUNT_NAMES[] = {"Основной", "Кредитка", "Накопления"};
+    auto accountMix = cumulativeOf(profile.accountMix, 3);
+    const std::uint32_t minAccounts = std::max<std::uint32_t>(profile.minAccounts, 1);
+    const std::uint32_t maxAccounts = std::max(profile.maxAccounts, minAccounts);
+    std::vector<UserShape> shapes(profile.users);
+    for (std::size_t u = 0; u < profile.users; ++u) {
+        auto user = ledger.getOrCreateUser("user" + std::to_string(u + 1));
+        UserShape& shape = shapes[u];
+
+        auto count = minAccounts + static_cast<std::uint32_t>(random.below(maxAccounts - minAccounts + 1));
+        std::size_t perKind[3] = {0, 0, 0};
+        for (std::uint32_t a = 0; a < count; ++a) {
+            std::size_t kind = random.pick(accountMix);
+            std::string name = ACCOUNT_NAMES[kind];
+            if (++perKind[kind] > 1) {
+                name += " " + std::to_string(perKind[kind]);
+            }
+            double balance = roundCents(random.lognormal(profile.amountMedian * 30, 0.5));
+            std::shared_ptr<Account> account;
+            switch (kind) {
+                case 0: account = std::make_shared<DebitAccount>(name, balance); break;
+                case 1: account = std::make_shared<CreditAccount>(name, 0.0, roundCents(balance * 2)); break;
+                default: account = std::make_shared<SavingsAccount>(name, balance * 3); break;
+            }
+            auto index = static_cast<std::uint16_t>(user->getAccounts().size());
+            ledger.addAccount(*user, account);
+            (kind == 2 ? shape.savings : shape.spending).push_back(index);
+            if (kind == 0) {
+                shape.income.push_back(index);
+            }
+        }
+        if (shape.income.empty()) {
+            shape.income = shape.spending.empty() ? shape.savings : shape.spending;
+        }
+        if (shape.spending.empty()) {
+            shape.spending = shape.savings;
+        }
+
+        for (std::size_t k = 0; k < expenseCount; ++k) {
+            ledger.addCategory(*user, std::make_shared<ExpenseCategory>(EXPENSES[k].name, EXPENSES[k].budget));
+        }
+        shape.salary = static_cast<std::int16_t>(user->getCategories().size());
+        ledger.addCategory(*user, std::make_shared<IncomeCategory>("Зарплата"));
+        shape.interest = static_cast<std::int16_t>(user->getCategories().size());
+        ledger.addCategory(*user, std::make_shared<IncomeCategory>("Проценты"));
+        workload.accounts += count;
+    }
+    if (profile.users == 0) {
+        return workload;
+    }
+
+    // Активность по Zipf: вес ранга r — 1 / r^skew; ранги разбросаны по пользователям
+    std::vector<std::uint32_t> byRank(profile.users);
+    for (std::size_t r = 0; r < byRank.size(); ++r) {
+        byRank[r] = static_cast<std::uint32_t>(r);
+    }
+    for (std::size_t r = byRank.size(); r > 1; --r) {
+        std::swap(byRank[r - 1], byRank[random.below(r)]);
+    }
+    std::vector<double> activity(profile.users);
+    double sum = 0.0;
+    for (std::size_t r = 0; r < activity.size(); ++r) {
+        sum += std::pow(static_cast<double>(r + 1), -profile.userSkew);
+        activity[r] = sum;
+    }
+
+    // Пополнения в среднем покрывают списания: средний приход равен среднему расходу
+    auto typeMix = cumulativeOf(profile.typeMix, 3);
+    const double withdrawalShare = std::max(profile.typeMix[WITHDRAWAL], 0.0);
+    const double depositShare = std::max(profile.typeMix[DEPOSIT], 0.0);
+    const double depositMedian = depositShare > 0
+        ? profile.amountMedian * withdrawalShare / depositShare * std::exp(profile.amountSigma * profile.amountSigma * 3 / 8)
+        : profile.amountMedian;
+
+    std::chrono::system_clock::time_point start;
+    DateUtils::parseTimePoint("2026-01-01 00:00:00", start);
+    const std::int64_t startSeconds = std::chrono::duration_cast<std::chrono::seconds>(start.time_since_epoch()).count();
+    const std::int64_t span = static_cast<std::int64_t>(profile.days) * 86400;
+
+    workload.events.reserve(profile.events);
+    for (std::size_t i = 0; i < profile.events; ++i) {
+        Event event{};
+        event.user = byRank[random.pick(activity)];
+        event.date = startSeconds + static_cast<std::int64_t>(static_cast<double>(i) * span / profile.events);
+        const UserShape& shape = shapes[event.user];
+
+        event.type = static_cast<std::uint8_t>(random.pick(typeMix));
+        if (event.type == COMPOUNDING && shape.savings.empty()) {
+            event.type = DEPOSIT;
+        }
+        switch (event.type) {
+            case WITHDRAWAL: {
+                event.account = shape.spending[random.below(shape.spending.size())];
+                auto k = random.below(expenseCount);
+                event.category = static_cast<std::int16_t>(k);
+                event.description = static_cast<std::uint32_t>(k * 3 + random.below(3));
+                event.amount = roundCents(random.lognormal(profile.amountMedian, profile.amountSigma));
+                break;
+            }
+            case DEPOSIT:
+                event.account = shape.income[random.below(shape.income.size())];
+                event.category = shape.salary;
+                event.description = salaryDescription;
+                event.amount = roundCents(random.lognormal(depositMedian, profile.amountSigma / 2));
+                break;
+            default:
+                event.account = shape.savings[random.below(shape.savings.size())];
+                event.category = shape.interest;
+                event.description = interestDescription;
+                event.amount = roundCents(random.lognormal(profile.amountMedian * 10, profile.amountSigma / 2));
+                event.period = COMPOUNDING_PERIOD;
+                event.rate = profile.interestRate;
+                break;
+        }
+        workload.events.push_back(event);
+    }
+    return workload;
+}
+
+bool loadReplay(const std::string& path, Ledger& ledger, Workload& workload, std::string& error) {
+    std::ifstream in(path);
+    if (!in) {
+        error = "cannot open " + path;
+        return false;
+    }
+
+    const auto& users = ledger.getUsers();
+    std::unordered_map<std::string, std::uint32_t> userIndex;
+    for (std::size_t u = 0; u < users.size(); ++u) {
+        userIndex.emplace(users[u]->getName(), static_cast<std::uint32_t>(u));
+        workload.accounts += users[u]->getAccounts().size();
+    }
+    std::unordered_map<std::string, std::uint32_t> descriptionIndex;
+    auto indexOf = [](const auto& items, const std::string& name) {
+        for (std::size_t i = 0; i < items.size(); ++i) {
+            if (items[i]->getName() == name) return static_cast<long>(i);
+        }
+        return -1L;
+    };
+
+    std::string line;
+    std::size_t lineNumber = 0;
+    while (std::getline(in, line)) {
+        ++lineNumber;
+        if (!line.empty() && line.back() == '\r') line.pop_back();
+        if (line.empty() || line[0] == '#') continue;
+
+        auto fail = [&](const std::string& message) {
+            error = path + ":" + std::to_string(lineNumber) + ": " + message;
+            return false;
+        };
+        auto fields = splitCsvLine(line);
+        if (fields[0] != "transaction") {
+            return fail("only transaction records can be replayed, got " + fields[0]);
+        }
+        Event event{};
+        if (fields.size() < 7 || !parseType(fields[2], event.type) || !parseNumber(fields[5], event.amount)) {
+            return fail("expected user, type, account, category, amount and description");
+        }
+        auto user = userIndex.find(fields[1]);
+        if (user == userIndex.end()) {
+            return fail("unknown user " + fields[1]);
+        }
+        event.user = user->second;
+        const auto& owner = *users[event.user];
+        long account = indexOf(owner.getAccounts(), fields[3]);
+        if (account < 0) {
+            return fail("unknown account " + fields[3]);
+        }
+        event.account = static_cast<std::uint16_t>(account);
+        event.category = -1;
+        if (!fields[4].empty()) {
+            long category = indexOf(owner.getCategories(), fields[4]);
+            if (category < 0) {
+                return fail("unknown category " + fields[4]);
+            }
+            event.category = static_cast<std::int16_t>(category);
+        }
+        auto description = descriptionIndex.emplace(fields[6], static_cast<std::uint32_t>(workload.descriptions.size()));
+        if (description.second) {
+            workload.descriptions.push_back(fields[6]);
+        }
+        event.description = description.first->second;
+
+        if (fields.size() >= 8 && !fields[7].empty()) {
+            std::chrono::system_clock::time_point date;
+            if (!DateUtils::parseTimePoint(fields[7], date)) {
+                return fail("invalid date " + fields[7]);
+            }
+            event.date = std::chrono::duration_cast<std::chrono::seconds>(date.time_since_epoch()).count();
+        }
+        if (event.type == COMPOUNDING) {
+            if (fields.size() < 10 || !parseNumber(fields[9], event.rate)) {
+                return fail("compounding requires period and rate");
+            }
+            event.period = static_cast<std::uint16_t>(std::atoi(fields[8].c_str()));
+        }
+        workload.events.push_back(event);
+    }
+    return true;
+}
+
+bool writeLedger(std::ostream& os, Ledger& ledger) {
+    for (const auto& user : ledger.getUsers()) {
+        if (!Ledger::writeUser(os, *user)) {
+            return false;
+        }
+    }
+    return static_cast<bool>(os);
+}
+
+void writeStream(std::ostream& os, Ledger& ledger, const Workload& workload) {
+    const auto& users = ledger.getUsers();
+    char amount[32];
+    for (const auto& event : workload.events) {
+        const User& user = *users[event.user];
+        std::snprintf(amount, sizeof(amount), "%.2f", event.amount);
+        os << "transaction," << user.getName() << "," << typeName(event.type) << ","
+           << quoteCsvField(user.getAccounts()[event.account]->getName()) << ","
+           << (event.category >= 0 ? quoteCsvField(user.getCategories()[event.category]->getName()) : std::string())
+           << "," << amount << ",\"" << workload.descriptions[event.description] << "\","
+           << DateUtils::formatTimePoint(std::chrono::system_clock::time_point(std::chrono::seconds(event.date)));
+        if (event.type == COMPOUNDING) {
+            os << "," << event.period << "," << event.rate;
+        }
+        os << "\n";
+    }
+}
+
+} // namespace Load
@@ -0,0 +1,90 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <iosfwd>
+#include <string>
+#include <vector>
+#include "../src/ledger/Ledger.h"
+
+namespace Load {
+
+/**
+ * @brief Параметры синтетической нагрузки
+ *
+ * Все случайные величины берутся из std::mt19937_64 с собственными
+ * преобразованиями (без std::*_distribution), поэтому одинаковый seed дает
+ * одинаковую нагрузку на любой стандартной библиотеке.
+ */
+struct Profile {
+    std::uint64_t seed = 42;
+    std::size_t users = 1000;
+    std::size_t events = 1000000;
+    std::uint32_t minAccounts = 1;        // счетов на пользователя, равномерно в [min, max]
+    std::uint32_t maxAccounts = 3;
+    double accountMix[3] = {60, 30, 10};  // веса Debit, Credit, Savings
+    std::uint32_t categories = 4;         // расходных категорий на пользователя (до 8)
+    double typeMix[3] = {25, 70, 5};      // веса DEPOSIT, WITHDRAWAL, COMPOUNDING
+    double amountMedian = 800.0;          // медиана списания, логнормальное распределение
+    double amountSigma = 1.0;             // стандартное отклонение логарифма суммы
+    double userSkew = 1.0;                // показатель Zipf активности пользователей (0 — равномерно)
+    std::uint32_t days = 30;              // даты событий равномерно покрывают столько дней
+    double interestRate = 5.0;            // ставка CompoundingTransaction, % годовых
+};
+
+/**
+ * @brief Одна операция нагрузки: транзакция для проводки через User::post
+ */
+struct Event {
+    std::int64_t date;          // секунды от эпохи
+    double amount;              // положительная, знак задает тип
+    double rate;                // только для COMPOUNDING
+    std::uint32_t user;         // номер в Ledger::getUsers()
+    std::uint32_t description;  // номер в Workload::descriptions
+    std::uint16_t account;      // номер счета у пользователя
+    std::int16_t category;      // номер категории у пользователя, -1 — без категории
+    std::uint16_t period;       // только для COMPOUNDING
+    std::uint8_t type;          // 0 — DEPOSIT, 1 — WITHDRAWAL, 2 — COMPOUNDING
+};
+
+struct Workload {
+    std::vector<Event> events;
+    std::vector<std::string> descriptions;
+    std::size_t accounts = 0;   // всего счетов у пользователей нагрузки
+};
+
+/**
+ * @brief Создает пользователей профиля в пустом журнале и синтезирует события
+ *
+ * Активность пользователей распределена по Zipf (самые активные разбросаны
+ * по номерам случайной перестановкой). Списания идут с дебетовых и
+ * кредитных счетов по расходным категориям, пополнения — на дебетовые
+ * (медиана подобрана так, чтобы в среднем покрывать списания), проценты —
+ * на сберегательные; у пользователя без сберегательного счета проценты
+ * заменяются пополнением.
+ */
+Workload synthesize(const Profile& profile, Ledger& ledger);
+
+/**
+ * @brief Читает события из файла импорта (записи transaction формата Ledger)
+ *
+ * Пользователи, счета и категории должны уже быть в журнале.
+ * @param error Текст ошибки с номером строки
+ */
+bool loadReplay(const std::string& path, Ledger& ledger, Workload& workload, std::string& error);
+
+/**
+ * @brief Журнал пользователей (счета и категории) для --ledger при повторе
+ */
+bool writeLedger(std::ostream& os, Ledger& ledger);
+/**
+ * @brief События в формате файла импорта, читаемом loadReplay и Ledger::importFile
+ */
+void writeStream(std::ostream& os, Ledger& ledger, const Workload& workload);
+
+/**
+ * @brief Тип события по названию транзакции; false для неизвестного
+ */
+bool parseType(const std::string& name, std::uint8_t& type);
+const char* typeName(std::uint8_t type);
+
+} // namespace Load
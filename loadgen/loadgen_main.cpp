@@ -0,0 +1,314 @@
+/**
+ * @file loadgen_main.cpp
+ * @brief Генератор нагрузки: синтез или повтор потока транзакций с заданной интенсивностью
+ */
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <sstream>
+#include <string>
+#include "LoadDriver.h"
+#include "Workload.h"
+
+namespace {
+
+struct Options {
+    Load::Profile profile;
+    Load::Settings settings;
+    std::string ledgerPath;       // повтор: пользователи, счета и категории
+    std::string replayPath;       // повтор: события в формате импорта
+    std::string writeLedgerPath;  // сохранить пользователей нагрузки
+    std::string writeStreamPath;  // сохранить события нагрузки
+    std::string jsonPath;
+};
+
+std::string usage() {
+    return
+        "Usage: FinanceTrackerLoad [--seed N] [--users N] [--events N] [--accounts MIN[:MAX]]\n"
+        "                          [--account-mix D,C,S] [--categories N] [--mix DEP,WD,COMP]\n"
+        "                          [--amount MEDIAN[:SIGMA]] [--skew S] [--days N]\n"
+        "                          [--ledger <file> --replay <file>]\n"
+        "                          [--rate R] [--arrivals poisson|uniform] [--threads N]\n"
+        "                          [--write-ledger <file>] [--write-stream <file>] [--json <file>]\n"
+        "  --users       synthetic users (default 1000), named user1..userN\n"
+        "  --events      transactions to post (default 1000000)\n"
+        "  --accounts    accounts per user, uniform in [MIN, MAX] (default 1:3)\n"
+        "  --account-mix weights of Debit, Credit and Savings accounts (default 60,30,10)\n"
+        "  --categories  expense categories per user, up to 8 (default 4)\n"
+        "  --mix         weights of DEPOSIT, WITHDRAWAL and COMPOUNDING (default 25,70,5)\n"
+        "  --amount      median and log-sigma of withdrawal amounts (default 800:1.0)\n"
+        "  --skew        Zipf exponent of user activity, 0 for uniform (default 1.0)\n"
+        "  --replay      post transaction records of <file> against the users of --ledger\n"
+        "  --rate        target events per second, 0 to post back to back (default 10000)\n"
+        "  --arrivals    inter-arrival times: exponential (poisson, default) or constant\n"
+        "  --threads     users are split between threads by number (default 1)\n"
+        "  --write-ledger, --write-stream  save the workload as a ledger and an import file\n"
+        "                replayable with --ledger/--replay or FinanceTracker --import\n";
+}
+
+bool parseWeights(const std::string& text, double (&weights)[3]) {
+    double parsed[3];
+    char tail;
+    if (std::sscanf(text.c_str(), "%lf,%lf,%lf%c", &parsed[0], &parsed[1], &parsed[2], &tail) != 3) {
+        return false;
+    }
+    if (parsed[0] < 0 || parsed[1] < 0 || parsed[2] < 0 || parsed[0] + parsed[1] + parsed[2] <= 0) {
+        return false;
+    }
+    std::copy(parsed, parsed + 3, weights);
+    return true;
+}
+
+bool parseArguments(int argc, char** argv, Options& options, std::string& error) {
+    Load::Profile& profile = options.profile;
+    Load::Settings& settings = options.settings;
+    for (int i = 1; i < argc; ++i) {
+        std::string arg = argv[i];
+        auto value = [&](std::string& target) {
+            if (i + 1 >= argc) {
+                error = "missing value for " + arg;
+                return false;
+            }
+            target = argv[++i];
+            return true;
+        };
+        auto invalid = [&](const std::string& v) {
+            error = "invalid " + arg + " value " + v;
+            return false;
+        };
+
+        std::string v;
+        if (arg == "--help" || arg == "-h") {
+            error.clear();
+            return false;
+        } else if (arg == "--ledger") {
+            if (!value(options.ledgerPath)) return false;
+        } else if (arg == "--replay") {
+            if (!value(options.replayPath)) return false;
+        } else if (arg == "--write-ledger") {
+            if (!value(options.writeLedgerPath)) return false;
+        } else if (arg == "--write-stream") {
+            if (!value(options.writeStreamPath)) return false;
+        } else if (arg == "--json") {
+            if (!value(options.jsonPath)) return false;
+        } else if (arg == "--arrivals") {
+            if (!value(v)) return false;
+            if (v != "poisson" && v != "uniform") return invalid(v);
+            settings.poisson = v == "poisson";
+        } else if (arg == "--account-mix" || arg == "--mix") {
+            if (!value(v)) return false;
+            if (!parseWeights(v, arg == "--mix" ? profile.typeMix : profile.accountMix)) return invalid(v);
+        } else if (arg == "--accounts") {
+            if (!value(v)) return false;
+            unsigned lo = 0, hi = 0;
+            char tail;
+            int n = std::sscanf(v.c_str(), "%u:%u%c", &lo, &hi, &tail);
+            if (n == 1) hi = lo;
+            if ((n != 1 && n != 2) || lo == 0 || hi < lo || hi > 1000) return invalid(v);
+            profile.minAccounts = lo;
+            profile.maxAccounts = hi;
+        } else if (arg == "--amount") {
+            if (!value(v)) return false;
+            double median = 0, sigma = profile.amountSigma;
+            char tail;
+            int n = std::sscanf(v.c_str(), "%lf:%lf%c", &median, &sigma, &tail);
+            if ((n != 1 && n != 2) || median <= 0 || sigma < 0) return invalid(v);
+            profile.amountMedian = median;
+            profile.amountSigma = sigma;
+        } else if (arg == "--rate" || arg == "--skew") {
+            if (!value(v)) return false;
+            try {
+                double x = std::stod(v);
+                if (x < 0) return invalid(v);
+                (arg == "--rate" ? settings.rate : profile.userSkew) = x;
+            } catch (...) {
+                return invalid(v);
+            }
+        } else if (arg == "--seed" || arg == "--users" || arg == "--events" || arg == "--categories" ||
+                   arg == "--days" || arg == "--threads") {
+            if (!value(v)) return false;
+            unsigned long long n = 0;
+            try {
+                n = std::stoull(v);
+            } catch (...) {
+                return invalid(v);
+            }
+            if (arg == "--seed") {
+                profile.seed = settings.seed = n;
+            } else if (arg == "--users") {
+                profile.users = static_cast<std::size_t>(n);
+            } else if (arg == "--events") {
+                profile.events = static_cast<std::size_t>(n);
+            } else if (arg == "--categories") {
+                if (n == 0 || n > 8) return invalid(v);
+                profile.categories = static_cast<std::uint32_t>(n);
+            } else if (arg == "--days") {
+                profile.days = static_cast<std::uint32_t>(n);
+            } else {
+                if (n == 0) return invalid(v);
+                settings.threads = static_cast<std::size_t>(n);
+            }
+        } else {
+            error = "unknown argument " + arg;
+            return false;
+        }
+    }
+
+    if (options.ledgerPath.empty() != options.replayPath.empty()) {
+        error = "--ledger and --replay go together";
+        return false;
+    }
+    if (options.replayPath.empty() && profile.users == 0 && profile.events > 0) {
+        error = "--users must be positive";
+        return false;
+    }
+    return true;
+}
+
+std::string formatNanos(std::uint64_t nanos) {
+    std::ostringstream os;
+    os << std::fixed;
+    if (nanos < 10000) {
+        os << nanos << " ns";
+    } else if (nanos < 10000000) {
+        os << std::setprecision(1) << nanos / 1e3 << " us";
+    } else if (nanos < 10000000000ull) {
+        os << std::setprecision(1) << nanos / 1e6 << " ms";
+    } else {
+        os << std::setprecision(2) << nanos / 1e9 << " s";
+    }
+    return os.str();
+}
+
+const double QUANTILES[] = {0.5, 0.9, 0.99, 0.999, 0.9999};
+const char* const QUANTILE_NAMES[] = {"p50", "p90", "p99", "p99.9", "p99.99"};
+
+void writeLatencies(std::ostream& os, const char* label, const Metrics::HistogramSnapshot& histogram) {
+    os << std::left << std::setw(10) << label << std::right;
+    for (std::size_t q = 0; q < sizeof(QUANTILES) / sizeof(QUANTILES[0]); ++q) {
+        os << QUANTILE_NAMES[q] << " " << formatNanos(histogram.quantile(QUANTILES[q])) << "  ";
+    }
+    os << "max " << formatNanos(histogram.maxNanos) << "\n";
+}
+
+void writeJsonLatencies(std::ostream& os, const char* name, const Metrics::HistogramSnapshot& histogram) {
+    os << "  \"" << name << "_ns\": {";
+    for (std::size_t q = 0; q < sizeof(QUANTILES) / sizeof(QUANTILES[0]); ++q) {
+        os << "\"" << QUANTILE_NAMES[q] << "\": " << histogram.quantile(QUANTILES[q]) << ", ";
+    }
+    os << "\"mean\": " << std::fixed << std::setprecision(0) << histogram.meanNanos()
+       << ", \"max\": " << histogram.maxNanos << "}";
+}
+
+void writeJson(std::ostream& os, const Options& options, const Load::Workload& workload,
+               std::size_t users, const Load::Result& result) {
+    os << "{\n";
+    os << "  \"source\": \"" << (options.replayPath.empty() ? "synthetic" : "replay") << "\",\n";
+    os << "  \"seed\": " << options.profile.seed << ",\n";
+    os << "  \"users\": " << users << ",\n";
+    os << "  \"accounts\": " << workload.accounts << ",\n";
+    os << "  \"events\": " << result.events << ",\n";
+    os << "  \"threads\": " << options.settings.threads << ",\n";
+    os << "  \"arrivals\": \"" << (options.settings.poisson ? "poisson" : "uniform") << "\",\n";
+    os << std::fixed << std::setprecision(1);
+    os << "  \"target_rate\": " << options.settings.rate << ",\n";
+    os << "  \"throughput\": " << result.throughput() << ",\n";
+    os << std::setprecision(3);
+    os << "  \"seconds\": " << result.seconds << ",\n";
+    os << "  \"rejected\": " << result.rejected << ",\n";
+    os << "  \"max_lag_ns\": " << result.maxLagNanos << ",\n";
+    writeJsonLatencies(os, "response", result.response);
+    os << ",\n";
+    writeJsonLatencies(os, "service", result.service);
+    os << "\n}\n";
+}
+
+} // namespace
+
+int main(int argc, char** argv) {
+    Options options;
+    std::string error;
+    if (!parseArguments(argc, argv, options, error)) {
+        if (error.empty()) {
+            std::cout << usage();
+            return 0;
+        }
+        std::cerr << "Error: " << error << "\n" << usage();
+        return 2;
+    }
+
+    auto started = std::chrono::steady_clock::now();
+    Ledger ledger;
+    Load::Workload workload;
+    if (options.replayPath.empty()) {
+        workload = Load::synthesize(options.profile, ledger);
+    } else {
+        if (!ledger.loadFile(options.ledgerPath)) {
+            std::cerr << "Error: " << options.ledgerPath << ": " << ledger.getLastError() << "\n";
+            return 1;
+        }
+        if (!Load::loadReplay(options.replayPath, ledger, workload, error)) {
+            std::cerr << "Error: " << error << "\n";
+            return 1;
+        }
+    }
+
+    // Файлы пишутся до прогона: проводки меняют балансы пользователей
+    if (!options.writeLedgerPath.empty()) {
+        std::ofstream out(options.writeLedgerPath);
+        if (!Load::writeLedger(out, ledger)) {
+            std::cerr << "Error: cannot write " << options.writeLedgerPath << "\n";
+            return 1;
+        }
+    }
+    if (!options.writeStreamPath.empty()) {
+        std::ofstream out(options.writeStreamPath);
+        Load::writeStream(out, ledger, workload);
+        if (!out) {
+            std::cerr << "Error: cannot write " << options.writeStreamPath << "\n";
+            return 1;
+        }
+    }
+    auto prepared = std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::steady_clock::now() - started);
+
+    const auto& settings = options.settings;
+    std::cout << "workload  " << (options.replayPath.empty() ? "synthetic" : "replay") << ": "
+              << ledger.getUserCount() << " users, " << workload.accounts << " accounts, "
+              << workload.events.size() << " events";
+    if (options.replayPath.empty()) {
+        std::cout << " (seed " << options.profile.seed << ")";
+    }
+    std::cout << ", prepared in " << prepared.count() << " ms\n";
+    std::cout << "target    ";
+    if (settings.rate > 0) {
+        std::cout << std::fixed << std::setprecision(0) << settings.rate << " events/s, "
+                  << (settings.poisson ? "poisson" : "uniform") << " arrivals";
+    } else {
+        std::cout << "back to back (closed loop)";
+    }
+    std::cout << ", " << settings.threads << " thread(s)\n";
+    std::cout.flush();
+
+    Load::Result result = Load::run(ledger, workload, settings);
+
+    std::cout << "achieved  " << std::fixed << std::setprecision(0) << result.throughput() << " events/s over "
+              << std::setprecision(2) << result.seconds << " s (schedule " << result.scheduledSeconds << " s), "
+              << result.rejected << " withdrawal(s) rejected\n";
+    writeLatencies(std::cout, "response", result.response);
+    writeLatencies(std::cout, "service", result.service);
+    std::cout << "max lag   " << formatNanos(result.maxLagNanos) << " behind schedule\n";
+
+    if (!options.jsonPath.empty()) {
+        std::ofstream out(options.jsonPath);
+        writeJson(out, options, workload, ledger.getUserCount(), result);
+        if (!out) {
+            std::cerr << "Error: cannot write " << options.jsonPath << "\n";
+            return 1;
+        }
+    }
+    return 0;
+}
@@ -7,6 +7,7 @@
 #include "src/transactions/Transaction.h"
 #include "src/reports/Report.h"
 #include "src/utils/Utils.h"
+#include "src/batch/BatchRunner.h"
 
 /**
  * @brief Главная функция приложения Финансового Трекера
@@ -18,9 +19,27 @@
  * - Шаблонные функции для работы с коллекциями
  * - Генерация отчетов через полиморфизм
  * 
+ * При запуске с аргументами работает в пакетном режиме без меню
+ * (см. Batch::usage()).
+ * 
  * @return int Код завершения программы (0 - успешное завершение)
  */
-int main() {
+int main(int argc, char** argv) {
+    if (argc > 1) {
+        std::string arg = argv[1];
+        if (arg == "--help" || arg == "-h") {
+            std::cout << Batch::usage();
+            return 0;
+        }
+        Batch::Options options;
+        std::string error;
+        if (!Batch::parseArguments(argc, argv, options, error)) {
+            std::cerr << "error: " << error << "\n" << Batch::usage();
+            return 2;
+        }
+        return Batch::run(options, std::cout);
+    }
+
     std::cout << "\n=== Финансовый Трекер ===\n\n";
     
     User user("Alice");
@@ -4,42 +4,111 @@
  */
 
 #include "Account.h"
+#include "../metrics/Metrics.h"
+#include <algorithm>
+#include <cmath>
 #include <iostream>
 
 /**
  * @brief Конструктор базового класса Account
  * @param accName Название счета
  * @param initialBalance Начальный баланс счета
+ * @param cur Валюта счета
  */
-Account::Account(const std::string& accName, double initialBalance)
-    : name(accName), balance(initialBalance) {}
+Account::Account(const std::string& accName, double initialBalance, Currency cur)
+    : name(accName), balance(initialBalance), openingBalance(initialBalance), currency(cur),
+      availableCents(toCents(initialBalance)) {}
+
+std::int64_t Account::toCents(double amount) {
+    return std::llround(amount * 100.0);
+}
+
+/**
+ * @brief Атомарно уменьшает доступные средства, если их хватает
+ * @param cents Сумма в копейках
+ */
+bool Account::reserve(std::int64_t cents) {
+    std::int64_t current = availableCents.load(std::memory_order_relaxed);
+    while (current >= cents) {
+        if (availableCents.compare_exchange_weak(current, current - cents, std::memory_order_acq_rel,
+                                                 std::memory_order_relaxed)) {
+            return true;
+        }
+    }
+    return false;
+}
+
+/**
+ * @brief Атомарное изменение баланса (std::atomic<double> в C++17 не имеет fetch_add)
+ * @return Разность округленных до копейки балансов после и до изменения
+ */
+std::int64_t Account::addBalance(double delta) {
+    double current = balance.load(std::memory_order_relaxed);
+    while (!balance.compare_exchange_weak(current, current + delta, std::memory_order_acq_rel,
+                                          std::memory_order_relaxed)) {
+    }
+    return toCents(current + delta) - toCents(current);
+}
 
 /**
  * @brief Внесение средств на счет
  * @param amount Сумма для внесения
  */
-void Account::deposit(double amount) {
-    balance += amount;
+bool Account::deposit(double amount) {
+    if (!(amount > 0.0)) {
+        return false;
+    }
+    METRICS_INC(AccountDeposits);
+    availableCents.fetch_add(addBalance(amount), std::memory_order_acq_rel);
+    return true;
 }
 
 /**
  * @brief Снятие средств со счета
  * @param amount Сумма для снятия
- * @return true если операция успешна, false если недостаточно средств
+ * @return true если операция успешна, false если сумма не положительна или недостаточно средств
  */
 bool Account::withdraw(double amount) {
-    if (balance >= amount) {
-        balance -= amount;
+    std::int64_t reserved = std::max<std::int64_t>(toCents(amount), 1);
+    if (amount > 0.0 && reserve(reserved)) {
+        METRICS_INC(AccountWithdrawals);
+        // Резерв заменяется фактическим изменением округленного баланса
+        availableCents.fetch_add(reserved + addBalance(-amount), std::memory_order_acq_rel);
         return true;
     }
+    METRICS_INC(AccountWithdrawalsRejected);
     return false;
 }
 
+/**
+ * @brief Резервирует сумму под ожидающий платеж
+ * @param amount Сумма холда
+ * @return Холд или пустой холд, если средств не хватает
+ */
+Hold Account::placeHold(double amount) {
+    std::int64_t cents = toCents(amount);
+    if (cents < 0 || !reserve(cents)) {
+        METRICS_INC(AccountWithdrawalsRejected);
+        return Hold();
+    }
+    heldCents.fetch_add(cents, std::memory_order_relaxed);
+    return Hold(this, cents);
+}
+
+/**
+ * @brief Устанавливает баланс напрямую; доступные средства сдвигаются на ту же величину
+ * @param value Новый баланс
+ */
+void Account::setBalance(double value) {
+    double previous = balance.exchange(value, std::memory_order_acq_rel);
+    availableCents.fetch_add(toCents(value) - toCents(previous), std::memory_order_acq_rel);
+}
+
 /**
  * @brief Получает название счета
  * @return Строка с названием счета
  */
-std::string Account::getName() const {
+const std::string& Account::getName() const {
     return name;
 }
 
@@ -48,7 +117,7 @@ std::string Account::getName() const {
  * @return Текущий баланс
  */
 double Account::getBalance() const {
-    return balance;
+    return balance.load(std::memory_order_relaxed);
 }
 
 // Перегрузка операторов
@@ -79,7 +148,7 @@ Account& Account::operator+=(double amount) {
  */
 std::ostream& operator<<(std::ostream& os, const Account& account) {
     os << "[" << account.getType() << "] " << account.name 
-       << " | Balance: " << account.balance;
+       << " | Balance: " << account.getBalance() << " " << currencyCode(account.currency);
     return os;
 }
 
@@ -88,24 +157,19 @@ std::ostream& operator<<(std::ostream& os, const Account& account) {
  * @brief Конструктор класса DebitAccount
  * @param accName Название дебетового счета
  * @param initialBalance Начальный баланс счета
+ * @param cur Валюта счета
  */
-DebitAccount::DebitAccount(const std::string& accName, double initialBalance)
-    : Account(accName, initialBalance) {}
+DebitAccount::DebitAccount(const std::string& accName, double initialBalance, Currency cur)
+    : Account(accName, initialBalance, cur) {}
 
 std::string DebitAccount::getType() const {
     return "DebitAccount";
 }
 
 // Наследование - Credit Account
-CreditAccount::CreditAccount(const std::string& accName, double initialBalance, double limit)
-    : Account(accName, initialBalance), creditLimit(limit) {}
-
-bool CreditAccount::withdraw(double amount) {
-    if (balance + creditLimit >= amount) {
-        balance -= amount;
-        return true;
-    }
-    return false;
+CreditAccount::CreditAccount(const std::string& accName, double initialBalance, double limit, Currency cur)
+    : Account(accName, initialBalance, cur), creditLimit(limit) {
+    availableCents.fetch_add(toCents(limit), std::memory_order_relaxed);
 }
 
 std::string CreditAccount::getType() const {
@@ -113,9 +177,49 @@ std::string CreditAccount::getType() const {
 }
 
 // Наследование - Savings Account
-SavingsAccount::SavingsAccount(const std::string& accName, double initialBalance)
-    : Account(accName, initialBalance) {}
+SavingsAccount::SavingsAccount(const std::string& accName, double initialBalance, Currency cur)
+    : Account(accName, initialBalance, cur) {}
 
 std::string SavingsAccount::getType() const {
     return "SavingsAccount";
 }
+
+// Холды
+Hold::Hold(Hold&& other) noexcept : account(other.account), cents(other.cents) {
+    other.account = nullptr;
+}
+
+Hold& Hold::operator=(Hold&& other) noexcept {
+    if (this != &other) {
+        release();
+        account = other.account;
+        cents = other.cents;
+        other.account = nullptr;
+    }
+    return *this;
+}
+
+bool Hold::capture() {
+    return capture(getAmount());
+}
+
+bool Hold::capture(double amount) {
+    std::int64_t captured = Account::toCents(amount);
+    if (!account || captured < 0 || captured > cents) {
+        return false;
+    }
+    METRICS_INC(AccountWithdrawals);
+    account->availableCents.fetch_add(cents + account->addBalance(-amount), std::memory_order_acq_rel);
+    account->heldCents.fetch_sub(cents, std::memory_order_relaxed);
+    account = nullptr;
+    return true;
+}
+
+void Hold::release() {
+    if (!account) {
+        return;
+    }
+    account->availableCents.fetch_add(cents, std::memory_order_acq_rel);
+    account->heldCents.fetch_sub(cents, std::memory_order_relaxed);
+    account = nullptr;
+}
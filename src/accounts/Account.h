@@ -1,6 +1,11 @@
 #pragma once
+#include <atomic>
+#include <cstdint>
 #include <string>
 #include <iostream>
+#include "../currency/Currency.h"
+
+class Hold;
 
 // Базовый класс Account
 /**
@@ -11,30 +16,61 @@
  * для различных типов счетов (дебетовые, кредитные, сберегательные).
  */
 class Account {
+    friend class Hold;
+
 protected:
     std::string name;
-    double balance;
+    std::atomic<double> balance;
+    double openingBalance; // баланс до первой транзакции истории
+    Currency currency;
+    // Доступные средства в копейках: округленный баланс + кредитный лимит - холды.
+    // Списания и холды резервируют средства атомарным CAS без блокировок;
+    // изменение баланса сдвигает их на разность округленных балансов до и после,
+    // так что суммы с долями копейки не накапливают расхождение.
+    std::atomic<std::int64_t> availableCents;
+    std::atomic<std::int64_t> heldCents{0};
+
+    static std::int64_t toCents(double amount);
+    bool reserve(std::int64_t cents);
+    // Возвращает изменение округленного баланса в копейках
+    std::int64_t addBalance(double delta);
 
 public:
     /**
      * @brief Конструктор базового класса Account
      * @param accName Название счета
      * @param initialBalance Начальный баланс счета
+     * @param cur Валюта счета
      */
-    Account(const std::string& accName, double initialBalance);
+    Account(const std::string& accName, double initialBalance, Currency cur = Currency::RUB);
     virtual ~Account() = default;
 
     /**
      * @brief Внесение средств на счет
      * @param amount Сумма для внесения
+     * @return false если сумма не положительна; баланс тогда не меняется
      */
-    virtual void deposit(double amount);
+    virtual bool deposit(double amount);
     /**
      * @brief Снятие средств со счета
+     *
+     * Резервируется не меньше копейки: списание меньше полукопейки
+     * при нулевых доступных средствах отклоняется.
      * @param amount Сумма для снятия
-     * @return true если операция успешна, false если недостаточно средств
+     * @return true если операция успешна, false если сумма не положительна
+     *         или недостаточно доступных средств
      */
     virtual bool withdraw(double amount);
+    /**
+     * @brief Резервирует сумму под ожидающий платеж (авторизация)
+     *
+     * Холд уменьшает доступные средства, но не баланс; затем он списывается
+     * (Hold::capture) или снимается (Hold::release, деструктор Hold).
+     * Безопасно при одновременных вызовах из разных потоков.
+     * @param amount Сумма холда
+     * @return Холд; пустой (false), если доступных средств не хватает
+     */
+    Hold placeHold(double amount);
     /**
      * @brief Получает тип счета
      * @return Строка с названием типа счета
@@ -45,12 +81,35 @@ public:
      * @brief Получает название счета
      * @return Строка с названием счета
      */
-    std::string getName() const;
+    const std::string& getName() const;
     /**
      * @brief Получает текущий баланс счета
      * @return Текущий баланс
      */
     double getBalance() const;
+    /**
+     * @brief Получает валюту счета
+     * @return Валюта, в которой ведется баланс
+     */
+    Currency getCurrency() const { return currency; }
+    /**
+     * @brief Устанавливает баланс напрямую (восстановление из снимка)
+     * @param value Новый баланс
+     */
+    void setBalance(double value);
+    /**
+     * @brief Средства, доступные для списаний и новых холдов
+     */
+    double getAvailable() const { return availableCents.load(std::memory_order_relaxed) / 100.0; }
+    /**
+     * @brief Сумма активных холдов
+     */
+    double getHeld() const { return heldCents.load(std::memory_order_relaxed) / 100.0; }
+    /**
+     * @brief Баланс до первой транзакции истории (для сверки с историей)
+     */
+    double getOpeningBalance() const { return openingBalance; }
+    void setOpeningBalance(double value) { openingBalance = value; }
     
     // Перегрузка операторов
     bool operator==(const Account& other) const;
@@ -67,7 +126,7 @@ public:
  */
 class DebitAccount : public Account {
 public:
-    DebitAccount(const std::string& accName, double initialBalance);
+    DebitAccount(const std::string& accName, double initialBalance, Currency cur = Currency::RUB);
     std::string getType() const override;
 };
 
@@ -75,15 +134,15 @@ public:
  * @brief Класс кредитного счета
  * 
  * Представляет кредитный счет с кредитным лимитом.
- * Позволяет балансу становиться отрицательным в пределах лимита.
- * Переопределяет метод withdraw() для учета кредитного лимита.
+ * Позволяет балансу становиться отрицательным в пределах лимита:
+ * лимит входит в доступные средства счета (getAvailable).
  */
 class CreditAccount : public Account {
     double creditLimit;
 public:
-    CreditAccount(const std::string& accName, double initialBalance, double limit);
-    bool withdraw(double amount) override;
+    CreditAccount(const std::string& accName, double initialBalance, double limit, Currency cur = Currency::RUB);
     std::string getType() const override;
+    double getCreditLimit() const { return creditLimit; }
 };
 
 /**
@@ -95,6 +154,45 @@ public:
  */
 class SavingsAccount : public Account {
 public:
-    SavingsAccount(const std::string& accName, double initialBalance);
+    SavingsAccount(const std::string& accName, double initialBalance, Currency cur = Currency::RUB);
     std::string getType() const override;
 };
+
+/**
+ * @brief Холд (резерв средств) на счете
+ *
+ * Владеет зарезервированной суммой: её можно списать (capture) или вернуть
+ * в доступные средства (release). Незавершенный холд снимается в деструкторе.
+ * Счет должен пережить холд.
+ */
+class Hold {
+    Account* account = nullptr;
+    std::int64_t cents = 0;
+
+public:
+    Hold() = default;
+    Hold(Account* acc, std::int64_t amountCents) : account(acc), cents(amountCents) {}
+    Hold(Hold&& other) noexcept;
+    Hold& operator=(Hold&& other) noexcept;
+    Hold(const Hold&) = delete;
+    Hold& operator=(const Hold&) = delete;
+    ~Hold() { release(); }
+
+    explicit operator bool() const { return account != nullptr; }
+    double getAmount() const { return cents / 100.0; }
+
+    /**
+     * @brief Списывает зарезервированную сумму со счета
+     */
+    bool capture();
+    /**
+     * @brief Списывает часть холда, остаток возвращается в доступные средства
+     * @param amount Сумма списания, не больше суммы холда
+     * @return false если холд пуст или сумма больше зарезервированной
+     */
+    bool capture(double amount);
+    /**
+     * @brief Снимает холд без списания
+     */
+    void release();
+};
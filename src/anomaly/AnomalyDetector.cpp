@@ -0,0 +1,118 @@
+/**
+ * @file AnomalyDetector.cpp
+ * @brief EWMA-статистика по счетам и правила тревог
+ */
+
+#include "AnomalyDetector.h"
+#include <cmath>
+#include <ctime>
+
+namespace Anomaly {
+
+namespace {
+
+std::int64_t localUtcOffset() {
+    std::time_t now = std::time(nullptr);
+    std::tm local{};
+    std::tm utc{};
+    localtime_r(&now, &local);
+    gmtime_r(&now, &utc);
+    utc.tm_isdst = local.tm_isdst;
+    return static_cast<std::int64_t>(std::difftime(std::mktime(&local), std::mktime(&utc)));
+}
+
+} // namespace
+
+AnomalyDetector::AnomalyDetector(const Settings& config)
+    : settings(config), utcOffset(localUtcOffset()) {
+    if (settings.burstCount > RECENT_SLOTS) settings.burstCount = RECENT_SLOTS;
+    if (settings.burstCount < 2) settings.burstCount = 2;
+}
+
+std::uint32_t AnomalyDetector::observe(const std::string& user, const std::string& account, double amount,
+                                       std::chrono::system_clock::time_point when, double* score) {
+    ++eventCount;
+    std::string key;
+    key.reserve(user.size() + account.size() + 1);
+    key.append(user).push_back('\0');
+    key.append(account);
+    auto [it, inserted] = index.emplace(std::move(key), static_cast<std::uint32_t>(states.size()));
+    if (inserted) {
+        states.emplace_back();
+    }
+    AccountState& st = states[it->second];
+
+    std::int64_t seconds = std::chrono::duration_cast<std::chrono::seconds>(when.time_since_epoch()).count();
+    int hour = static_cast<int>((((seconds + utcOffset) % 86400) + 86400) % 86400 / 3600);
+    bool night = settings.offHoursStart <= settings.offHoursEnd
+        ? hour >= settings.offHoursStart && hour < settings.offHoursEnd
+        : hour >= settings.offHoursStart || hour < settings.offHoursEnd;
+    // Суммы распределены с тяжелым хвостом — статистика ведется по логарифму
+    double x = std::log1p(std::fabs(amount));
+
+    std::uint32_t kinds = 0;
+    double z = 0.0;
+    if (st.count >= settings.warmup) {
+        double sd = std::sqrt(static_cast<double>(st.variance));
+        z = sd > 1e-9 ? (x - st.mean) / sd : (x > st.mean + 1e-9 ? settings.spikeScore : 0.0);
+        if (z >= settings.spikeScore) kinds |= Spike;
+        if (night && st.offHoursShare < settings.offHoursShare) kinds |= OffHours;
+    }
+    // recent[head] — предыдущее списание, recent[head - k + 1] — k-е с конца
+    std::size_t back = (st.head + RECENT_SLOTS - (settings.burstCount - 2)) % RECENT_SLOTS;
+    if (st.count + 1 >= settings.burstCount && seconds - st.recent[back] < settings.burstWindowSeconds) {
+        kinds |= Burst;
+    }
+
+    double alpha = st.count == 0 ? 1.0 : settings.alpha;
+    double diff = x - st.mean;
+    double incr = alpha * diff;
+    st.mean = static_cast<float>(st.mean + incr);
+    st.variance = static_cast<float>((1.0 - alpha) * (st.variance + diff * incr));
+    st.offHoursShare = static_cast<float>(st.offHoursShare + settings.alpha * ((night ? 1.0 : 0.0) - st.offHoursShare));
+    st.head = static_cast<std::uint8_t>((st.head + 1) % RECENT_SLOTS);
+    st.recent[st.head] = seconds;
+    ++st.count;
+
+    if (kinds) {
+        ++alertCount;
+    }
+    if (score) {
+        *score = z;
+    }
+    return kinds;
+}
+
+std::string AnomalyDetector::describe(std::uint32_t kinds) {
+    std::string text;
+    auto add = [&](const char* name) {
+        if (!text.empty()) text += '|';
+        text += name;
+    };
+    if (kinds & Spike) add("spike");
+    if (kinds & Burst) add("burst");
+    if (kinds & OffHours) add("off-hours");
+    return text;
+}
+
+void AnomalyDetector::onTransactionAdded(const User& user,
+                                         const std::shared_ptr<Transactions::Transaction>& trans) {
+    const Account* account = trans->getAccount().get();
+    if (trans->getAmount() >= 0 || !account ||
+        !(dynamic_cast<const DebitAccount*>(account) || dynamic_cast<const CreditAccount*>(account))) {
+        return;
+    }
+    double score = 0.0;
+    std::uint32_t kinds = observe(user.getName(), account->getName(), -trans->getAmount(), trans->getDate(), &score);
+    if (kinds && callback) {
+        Alert alert;
+        alert.user = user.getName();
+        alert.account = account->getName();
+        alert.transaction = trans;
+        alert.kinds = kinds;
+        alert.score = score;
+        callback(alert);
+    }
+}
+
+} // namespace Anomaly
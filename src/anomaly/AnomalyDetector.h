@@ -0,0 +1,104 @@
+#pragma once
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <string>
+#include <unordered_map>
+#include <vector>
+#include "../ledger/Ledger.h"
+
+namespace Anomaly {
+
+enum AlertKind : std::uint32_t {
+    Spike = 1,      // сумма резко выше обычной для счета
+    Burst = 2,      // много списаний за короткое окно
+    OffHours = 4    // списание в ночные часы у счета, где их обычно нет
+};
+
+struct Alert {
+    std::string user;
+    std::string account;
+    std::shared_ptr<Transactions::Transaction> transaction;
+    std::uint32_t kinds = 0;
+    double score = 0.0;   // z-оценка логарифма суммы
+};
+
+struct Settings {
+    double alpha = 0.1;                 // вес нового значения в EWMA
+    double spikeScore = 4.0;            // порог z-оценки для Spike
+    std::uint32_t warmup = 10;          // сколько списаний накопить до первых оценок
+    std::size_t burstCount = 5;         // Burst: столько списаний ...
+    std::int64_t burstWindowSeconds = 600; // ... за это окно
+    int offHoursStart = 0;              // ночные часы [start, end) локального времени
+    int offHoursEnd = 6;
+    double offHoursShare = 0.05;        // OffHours, если обычная доля ночных списаний ниже
+};
+
+/**
+ * @brief Потоковый детектор необычных списаний
+ *
+ * Для каждого дебетового и кредитного счета хранит состояние фиксированного
+ * размера: EWMA среднего и дисперсии логарифма суммы, EWMA доли ночных
+ * списаний и кольцо времен последних списаний для оконного счета. Оценка
+ * события — O(1): поиск состояния в хеш-таблице и несколько операций
+ * с плавающей точкой. Тревоги передаются в обратный вызов синхронно.
+ *
+ * Подключается к журналу как наблюдатель; исторические транзакции, загруженные
+ * до установки обратного вызова, только обучают статистику.
+ * Состояние ключуется по паре (пользователь, имя счета), а не по адресу
+ * объекта счета: при выгрузке пользователя оно сохраняется и продолжает
+ * действовать после подгрузки, когда счета создаются заново.
+ * Час события считается по смещению локального времени на момент создания детектора.
+ */
+class AnomalyDetector : public LedgerObserver {
+public:
+    static constexpr std::size_t RECENT_SLOTS = 8;
+
+    struct AccountState {
+        float mean = 0.0f;
+        float variance = 0.0f;
+        float offHoursShare = 0.0f;
+        std::uint32_t count = 0;
+        std::int64_t recent[RECENT_SLOTS] = {};
+        std::uint8_t head = 0;
+    };
+
+private:
+    Settings settings;
+    std::int64_t utcOffset;
+    std::unordered_map<std::string, std::uint32_t> index;   // "пользователь\0счет" -> состояние
+    std::vector<AccountState> states;
+    std::function<void(const Alert&)> callback;
+    std::size_t eventCount = 0;
+    std::size_t alertCount = 0;
+
+public:
+    explicit AnomalyDetector(const Settings& config = Settings());
+
+    void setCallback(std::function<void(const Alert&)> cb) { callback = std::move(cb); }
+
+    /**
+     * @brief Оценивает списание и обновляет статистику счета
+     * @param amount Сумма списания (положительная)
+     * @param score Если задан — z-оценка суммы
+     * @return Маска AlertKind (0 — событие обычное)
+     */
+    std::uint32_t observe(const std::string& user, const std::string& account, double amount,
+                          std::chrono::system_clock::time_point when, double* score = nullptr);
+
+    std::size_t getEventCount() const { return eventCount; }
+    std::size_t getAlertCount() const { return alertCount; }
+    std::size_t getAccountCount() const { return states.size(); }
+
+    static std::string describe(std::uint32_t kinds);
+
+    void onUserAdded(const User&) override {}
+    void onAccountAdded(const User&, const Account&) override {}
+    void onCategoryAdded(const User&, const Category&) override {}
+    void onBalanceChanged(const User&, const Account&) override {}
+    void onTransactionAdded(const User& user, const std::shared_ptr<Transactions::Transaction>& trans) override;
+};
+
+} // namespace Anomaly
@@ -0,0 +1,538 @@
+/**
+ * @file BatchRunner.cpp
+ * @brief Реализация пакетного режима: загрузка, импорт и параллельная выгрузка отчётов
+ */
+
+#include "BatchRunner.h"
+#include <algorithm>
+#include <chrono>
+#include <csignal>
+#include <fstream>
+#include <future>
+#include <iomanip>
+#include <sstream>
+#include <thread>
+#include "../anomaly/AnomalyDetector.h"
+#include "../forecast/Forecaster.h"
+#include "../ledger/Ledger.h"
+#include "../metrics/Metrics.h"
+#include "../persistence/StateStore.h"
+#include "../reconciliation/Reconciler.h"
+#include "../rules/Categorizer.h"
+#include "../reports/AsyncExporter.h"
+#include "../reports/Report.h"
+#include "../search/TransactionIndex.h"
+#include "../server/HttpServer.h"
+#include "../utils/DateUtils.h"
+#include "../utils/Utils.h"
+
+namespace Batch {
+
+namespace {
+
+Server::HttpServer* activeServer = nullptr;
+
+void stopServer(int) {
+    if (activeServer) {
+        activeServer->stop();
+    }
+}
+
+using Clock = std::chrono::steady_clock;
+
+double millisSince(Clock::time_point start) {
+    return std::chrono::duration<double, std::milli>(Clock::now() - start).count();
+}
+
+std::string expandPath(const std::string& pathTemplate, const std::string& user) {
+    std::string path = pathTemplate;
+    const std::string placeholder = "{user}";
+    for (auto pos = path.find(placeholder); pos != std::string::npos; pos = path.find(placeholder, pos)) {
+        path.replace(pos, placeholder.size(), user);
+        pos += user.size();
+    }
+    return path;
+}
+
+struct Job {
+    std::size_t user;          // номер в списке выбранных имен
+    const ReportSpec* spec;
+    std::string path;
+    double millis = 0.0;       // от постановки в очередь до записи файла
+    std::size_t rows = 0;
+    std::size_t archived = 0;  // строк архива, учтенных в итогах по статистике блоков
+    bool ok = false;
+    std::string error{};       // исключение при форматировании
+    std::future<bool> result{};
+};
+
+} // namespace
+
+std::string usage() {
+    return
+        "Usage: FinanceTracker --ledger <file> [--import <file>]... [--no-dedup] [--rules <file>]\n"
+        "                      --report <format>:<path> [--query <query>]...\n"
+        "                      [--user <name>]... [--threads N] [--metrics <file>]\n"
+        "                      [--state <dir> [--snapshot-every N]] [--reconcile <file>]\n"
+        "                      [--alerts <file>] [--forecast <file> [--days N] [--scenarios N]]\n"
+        "                      [--serve <port>] [--evict <dir> [--memory-budget MiB] [--evict-idle S]]\n"
+        "                      [--archive-before YYYY-MM-DD]\n"
+        "  <format>  text | csv | json | arrow\n"
+        "  <path>    may contain {user}, required when exporting several users\n"
+        "  --query   rows and columns of the preceding report, key=value pairs joined by '&':\n"
+        "            columns=date,amount type=withdrawal account=A,B category=C (with\n"
+        "            subcategories) min=-500 max=0 from=YYYY-MM-DD to=YYYY-MM-DD sort=-amount,date\n"
+        "  --state   restore users from <dir> (snapshot + delta log) instead of --ledger\n"
+        "            and keep logging changes there\n"
+        "  --import  post new transactions in date order; rows repeating the user's history\n"
+        "            (same date, amount, account and description) are skipped unless --no-dedup\n"
+        "  --rules   assign categories to imported transactions without one\n"
+        "  --reconcile  recompute balances from history, write discrepancies to <file>\n"
+        "  --alerts  flag unusual imported withdrawals (spikes, bursts, off-hours) to <file>\n"
+        "  --forecast  project balances N days ahead (default 90) from recurring payments,\n"
+        "            average flow and interest; quantiles over Monte Carlo scenarios\n"
+        "  --serve   then serve the ledger as JSON over HTTP on 127.0.0.1:<port> until SIGINT\n"
+        "  --evict   write users not requested for --evict-idle seconds, or beyond\n"
+        "            --memory-budget (least recently used first), to <dir>; reload on access\n"
+        "  --archive-before  move history older than the date into compressed cold storage;\n"
+        "            report totals still include it, rows and search cover recent history\n";
+}
+
+bool parseArguments(int argc, char** argv, Options& options, std::string& error) {
+    for (int i = 1; i < argc; ++i) {
+        std::string arg = argv[i];
+        auto value = [&](std::string& target) {
+            if (i + 1 >= argc) {
+                error = "missing value for " + arg;
+                return false;
+            }
+            target = argv[++i];
+            return true;
+        };
+
+        std::string v;
+        if (arg == "--ledger") {
+            if (!value(options.ledgerPath)) return false;
+        } else if (arg == "--import") {
+            if (!value(v)) return false;
+            options.importPaths.push_back(v);
+        } else if (arg == "--no-dedup") {
+            options.dedupImports = false;
+        } else if (arg == "--rules") {
+            if (!value(options.rulesPath)) return false;
+        } else if (arg == "--user") {
+            if (!value(v)) return false;
+            options.users.push_back(v);
+        } else if (arg == "--threads") {
+            if (!value(v)) return false;
+            try {
+                options.threads = static_cast<std::size_t>(std::stoul(v));
+            } catch (...) {
+                error = "invalid --threads value " + v;
+                return false;
+            }
+        } else if (arg == "--metrics") {
+            if (!value(options.metricsPath)) return false;
+        } else if (arg == "--state") {
+            if (!value(options.stateDir)) return false;
+        } else if (arg == "--serve") {
+            if (!value(v)) return false;
+            try {
+                options.servePort = std::stoi(v);
+            } catch (...) {
+                options.servePort = -1;
+            }
+            if (options.servePort < 0 || options.servePort > 65535) {
+                error = "invalid --serve port " + v;
+                return false;
+            }
+        } else if (arg == "--evict") {
+            if (!value(options.evictDir)) return false;
+        } else if (arg == "--memory-budget" || arg == "--evict-idle") {
+            if (!value(v)) return false;
+            try {
+                auto n = std::stoul(v);
+                if (arg == "--memory-budget") {
+                    options.memoryBudgetMiB = static_cast<std::size_t>(n);
+                } else {
+                    options.evictIdleSeconds = static_cast<std::uint32_t>(n);
+                }
+            } catch (...) {
+                error = "invalid " + arg + " value " + v;
+                return false;
+            }
+        } else if (arg == "--archive-before") {
+            if (!value(options.archiveBefore)) return false;
+            std::chrono::system_clock::time_point cutoff;
+            if (!DateUtils::parseTimePoint(options.archiveBefore + " 00:00:00", cutoff)) {
+                error = "invalid --archive-before date " + options.archiveBefore;
+                return false;
+            }
+        } else if (arg == "--forecast") {
+            if (!value(options.forecastPath)) return false;
+        } else if (arg == "--days" || arg == "--scenarios") {
+            if (!value(v)) return false;
+            try {
+                auto n = static_cast<std::uint32_t>(std::stoul(v));
+                (arg == "--days" ? options.forecastDays : options.scenarios) = n;
+            } catch (...) {
+                error = "invalid " + arg + " value " + v;
+                return false;
+            }
+        } else if (arg == "--alerts") {
+            if (!value(options.alertsPath)) return false;
+        } else if (arg == "--reconcile") {
+            if (!value(options.reconcilePath)) return false;
+        } else if (arg == "--snapshot-every") {
+            if (!value(v)) return false;
+            try {
+                options.snapshotEvery = static_cast<std::size_t>(std::stoul(v));
+            } catch (...) {
+                error = "invalid --snapshot-every value " + v;
+                return false;
+            }
+        } else if (arg == "--report") {
+            if (!value(v)) return false;
+            auto colon = v.find(':');
+            if (colon == std::string::npos || colon == 0 || colon + 1 == v.size()) {
+                error = "--report expects <format>:<path>, got " + v;
+                return false;
+            }
+            ReportSpec spec;
+            spec.format = v.substr(0, colon);
+            spec.pathTemplate = v.substr(colon + 1);
+            if (!Reports::createReport(spec.format, "")) {
+                error = "unknown report format " + spec.format;
+                return false;
+            }
+            options.reports.push_back(spec);
+        } else if (arg == "--query") {
+            if (!value(v)) return false;
+            if (options.reports.empty()) {
+                error = "--query must follow --report";
+                return false;
+            }
+            ReportSpec& spec = options.reports.back();
+            if (!spec.query.parse(v, error)) {
+                error = "--query: " + error;
+                return false;
+            }
+            if (!spec.query.columns.empty() && !Reports::createReport(spec.format, "")->supportsColumnSelection()) {
+                error = "--query: " + spec.format + " reports always contain all columns";
+                return false;
+            }
+        } else {
+            error = "unknown argument " + arg;
+            return false;
+        }
+    }
+
+    if (options.ledgerPath.empty() && options.stateDir.empty()) {
+        error = "--ledger or --state is required";
+        return false;
+    }
+    if (options.evictDir.empty() && (options.memoryBudgetMiB || options.evictIdleSeconds)) {
+        error = "--memory-budget and --evict-idle require --evict";
+        return false;
+    }
+    return true;
+}
+
+int run(const Options& options, std::ostream& out) {
+    std::ostringstream log;
+    log << std::fixed << std::setprecision(2);
+    auto total = Clock::now();
+
+    Ledger ledger;
+    if (!options.evictDir.empty() &&
+        !ledger.enableEviction(options.evictDir, options.memoryBudgetMiB << 20,
+                               std::chrono::seconds(options.evictIdleSeconds))) {
+        out << "error: " << ledger.getLastError() << "\n";
+        return 1;
+    }
+    std::unique_ptr<Persistence::StateStore> store;
+    auto start = Clock::now();
+    bool restored = false;
+    if (!options.stateDir.empty()) {
+        store = std::make_unique<Persistence::StateStore>(options.stateDir);
+        if (!store->restore(ledger)) {
+            out << "error: " << store->getLastError() << "\n";
+            return 1;
+        }
+        store->setAutoSnapshot(&ledger, options.snapshotEvery);
+        restored = store->hasRestoredSnapshot() || store->getReplayedRecords() > 0;
+        log << "restore " << options.stateDir << ": " << ledger.getUserCount() << " users, "
+            << store->getReplayedRecords() << " log records, " << millisSince(start) << " ms\n";
+    }
+
+    // Детектор обучается на истории, тревоги собираются только по импорту
+    Anomaly::AnomalyDetector detector;
+    std::vector<Anomaly::Alert> alerts;
+    if (!options.alertsPath.empty()) {
+        ledger.addObserver(&detector);
+    }
+
+    if (restored && !options.ledgerPath.empty()) {
+        log << "load    " << options.ledgerPath << ": skipped, state restored\n";
+    } else if (!options.ledgerPath.empty()) {
+        start = Clock::now();
+        if (!ledger.loadFile(options.ledgerPath)) {
+            out << log.str() << "error: " << ledger.getLastError() << "\n";
+            return 1;
+        }
+        log << "load    " << options.ledgerPath << ": " << ledger.getUserCount() << " users, "
+            << ledger.getTransactionCount() << " transactions, " << millisSince(start) << " ms\n";
+    }
+
+    if (!options.alertsPath.empty()) {
+        detector.setCallback([&alerts](const Anomaly::Alert& alert) { alerts.push_back(alert); });
+    }
+
+    Rules::Categorizer categorizer;
+    if (!options.rulesPath.empty()) {
+        start = Clock::now();
+        if (!categorizer.loadFile(options.rulesPath)) {
+            out << log.str() << "error: " << categorizer.getLastError() << "\n";
+            return 1;
+        }
+        ledger.setCategorizer(&categorizer);
+        log << "rules   " << options.rulesPath << ": " << categorizer.getRules().size() << " rules, "
+            << categorizer.getStateCount() << " states, " << millisSince(start) << " ms\n";
+    }
+
+    ledger.setImportDedup(options.dedupImports);
+    for (const auto& path : options.importPaths) {
+        std::size_t before = ledger.getTransactionCount();
+        start = Clock::now();
+        if (!ledger.importFile(path)) {
+            out << log.str() << "error: " << ledger.getLastError() << "\n";
+            return 1;
+        }
+        log << "import  " << path << ": " << ledger.getTransactionCount() - before << " transactions, ";
+        if (options.dedupImports) {
+            log << ledger.getImportDuplicates() << " duplicates skipped, ";
+        }
+        if (ledger.getImportRejected() > 0) {
+            log << ledger.getImportRejected() << " withdrawals rejected (insufficient funds), ";
+        }
+        log << millisSince(start) << " ms\n";
+    }
+
+    if (!options.alertsPath.empty()) {
+        ledger.removeObserver(&detector);
+        std::ofstream file(options.alertsPath);
+        file << "User,Account,Date,Amount,Kind,Score\n" << std::fixed << std::setprecision(2);
+        for (const auto& alert : alerts) {
+            file << quoteCsvField(alert.user) << "," << quoteCsvField(alert.account) << ","
+                 << alert.transaction->getFormattedDate() << "," << alert.transaction->getAmount() << ","
+                 << Anomaly::AnomalyDetector::describe(alert.kinds) << "," << alert.score << "\n";
+        }
+        if (!file) {
+            out << log.str() << "error: cannot write alerts to " << options.alertsPath << "\n";
+            return 1;
+        }
+        log << "alerts  " << alerts.size() << " of " << detector.getEventCount() << " withdrawals on "
+            << detector.getAccountCount() << " accounts\n";
+    }
+
+    if (!options.archiveBefore.empty()) {
+        std::chrono::system_clock::time_point cutoff;
+        DateUtils::parseTimePoint(options.archiveBefore + " 00:00:00", cutoff);
+        start = Clock::now();
+        std::size_t moved = 0;
+        std::size_t blocks = 0;
+        std::size_t bytes = 0;
+        ledger.forEachUser([&](const std::shared_ptr<User>& user) {
+            moved += ledger.archiveBefore(*user, cutoff);
+            blocks += user->getArchive().getBlockCount();
+            bytes += user->getArchive().getCompressedBytes();
+        });
+        log << "archive " << options.archiveBefore << ": " << moved << " transactions, " << blocks << " blocks, "
+            << bytes / 1024.0 << " KiB, " << millisSince(start) << " ms\n";
+    }
+
+    // Снимок пишется в фоне, пока формируются отчеты
+    auto snapshotStart = Clock::now();
+    if (store) {
+        if (!store->snapshot(ledger, true)) {
+            out << log.str() << "error: " << store->getLastError() << "\n";
+            return 1;
+        }
+        log << "snapshot started at record " << store->getSequence() << "\n";
+    }
+
+    // Выбранные пользователи хранятся по именам: указатели удерживали бы
+    // от выгрузки всех сразу
+    std::vector<std::string> selected;
+    if (options.users.empty()) {
+        selected = ledger.getUserNames();
+    } else {
+        for (const auto& name : options.users) {
+            if (!ledger.findUser(name)) {
+                out << log.str() << "error: unknown user " << name << "\n";
+                return 1;
+            }
+            selected.push_back(name);
+        }
+    }
+
+    // Задания идут по пользователям: задания одного пользователя подряд
+    std::vector<Job> jobs;
+    for (const auto& spec : options.reports) {
+        if (selected.size() > 1 && spec.pathTemplate.find("{user}") == std::string::npos) {
+            out << log.str() << "error: path " << spec.pathTemplate
+                << " must contain {user} when exporting several users\n";
+            return 1;
+        }
+    }
+    for (std::size_t u = 0; u < selected.size(); ++u) {
+        for (const auto& spec : options.reports) {
+            jobs.push_back(Job{u, &spec, expandPath(spec.pathTemplate, selected[u])});
+        }
+    }
+
+    std::size_t threadCount = options.threads ? options.threads
+                                              : std::max(1u, std::thread::hardware_concurrency());
+    threadCount = std::max<std::size_t>(1, std::min(threadCount, jobs.size()));
+
+    // Отчеты строятся в этом потоке по одному пользователю (журнал подгружает
+    // его здесь же), форматирование и запись идут в AsyncExporter. Выгрузок
+    // в очереди не больше двух на поток: отчеты держат копии истории
+    start = Clock::now();
+    {
+        Reports::AsyncExporter exporter(threadCount);
+        const std::size_t maxPending = 2 * threadCount;
+        std::size_t done = 0;
+        for (std::size_t i = 0; i < jobs.size();) {
+            const std::size_t u = jobs[i].user;
+            auto user = ledger.findUser(selected[u]);
+            for (; i < jobs.size() && jobs[i].user == u; ++i) {
+                Job& job = jobs[i];
+                auto report = Reports::createReport(job.spec->format, user->getName());
+                report->setQuery(job.spec->query);
+                report->setTransactions(user->getTransactions());
+                if (report->addArchive(user->getArchive(), Reports::TimePoint::min(), Reports::TimePoint::max())) {
+                    job.archived = report->getArchivedCount();
+                }
+                job.rows = report->getTransactionCount();
+                auto submitted = Clock::now();
+                job.result = exporter.submit(report, job.path, [&job, submitted](bool) {
+                    job.millis = millisSince(submitted);
+                });
+                while (i + 1 - done > maxPending) {
+                    jobs[done++].result.wait();
+                }
+            }
+        }
+        // Деструктор дожидается записи всех файлов и обратных вызовов
+    }
+    for (auto& job : jobs) {
+        try {
+            job.ok = job.result.get();
+        } catch (const std::exception& e) {
+            job.error = e.what();
+        }
+    }
+
+    int status = 0;
+    for (const auto& job : jobs) {
+        log << "report  " << job.spec->format << " " << job.path << ": " << job.rows << " rows, ";
+        if (job.archived > 0) {
+            log << job.archived << " archived, ";
+        }
+        log << job.millis << " ms" << (job.ok ? "" : " FAILED")
+            << (job.error.empty() ? "" : ": " + job.error) << "\n";
+        if (!job.ok) status = 1;
+    }
+    log << "reports " << jobs.size() << " files on " << threadCount << " threads, "
+        << millisSince(start) << " ms\n";
+
+    if (!options.reconcilePath.empty()) {
+        Reconciliation::Reconciler reconciler(options.threads);
+        auto result = reconciler.run(ledger);
+        log << "reconcile " << result.accountsChecked << " accounts, " << result.transactionsProcessed
+            << " transactions, " << result.discrepancies.size() << " discrepancies, "
+            << result.millis << " ms\n";
+        if (!Reconciliation::Reconciler::saveReport(options.reconcilePath, result)) {
+            log << "error: cannot write reconciliation report to " << options.reconcilePath << "\n";
+            status = 1;
+        } else if (!result.ok()) {
+            status = 1;
+        }
+    }
+
+    if (!options.forecastPath.empty()) {
+        Forecast::Settings settings;
+        settings.days = options.forecastDays;
+        settings.scenarios = options.scenarios;
+        settings.threads = options.threads;
+        auto model = Forecast::buildModel(ledger, std::chrono::system_clock::now());
+        auto result = Forecast::run(model, settings);
+        std::ofstream file(options.forecastPath);
+        Forecast::writeCsv(file, model, result);
+        log << "forecast " << model.size() << " accounts, " << result.days << " days, "
+            << result.scenarios << " scenarios, " << result.millis << " ms\n";
+        if (!file) {
+            log << "error: cannot write forecast to " << options.forecastPath << "\n";
+            status = 1;
+        }
+    }
+
+    if (store) {
+        if (store->waitForSnapshot()) {
+            log << "snapshot " << options.stateDir << ": " << millisSince(snapshotStart) << " ms\n";
+        } else {
+            log << "error: " << store->getLastError() << "\n";
+            status = 1;
+        }
+    }
+
+    // Итоговый проход вытеснения перед замером памяти
+    if (!options.evictDir.empty()) {
+        ledger.evictIdle();
+    }
+    auto memory = ledger.getMemoryStats();
+    log << "memory  " << memory.residentUsers << " users resident, " << memory.evictedUsers << " evicted, "
+        << memory.resident.total() / 1048576.0 << " MiB (peak " << memory.peakBytes / 1048576.0 << " MiB), "
+        << memory.evictions << " evictions, " << memory.reloads << " reloads\n";
+
+    if (!options.metricsPath.empty() && !Metrics::dumpPrometheus(options.metricsPath)) {
+        log << "error: cannot write metrics to " << options.metricsPath << "\n";
+        status = 1;
+    }
+    log << "total   " << millisSince(total) << " ms\n";
+
+    out << log.str();
+    out.flush();
+
+    if (options.servePort >= 0) {
+        // Индекс подписывается до построения: выгрузки во время обхода
+        // сразу убирают транзакции выгруженных из индекса
+        Search::TransactionIndex index;
+        ledger.addObserver(&index);
+        index.build(ledger);
+        Server::HttpServer server(ledger, options.threads, &index);
+        if (!server.listen(static_cast<std::uint16_t>(options.servePort))) {
+            ledger.removeObserver(&index);
+            out << "error: " << server.getLastError() << "\n";
+            return 1;
+        }
+        activeServer = &server;
+        auto previousInt = std::signal(SIGINT, stopServer);
+        auto previousTerm = std::signal(SIGTERM, stopServer);
+        out << "serving http://127.0.0.1:" << server.getPort() << "/users\n";
+        out.flush();
+        server.run();
+        std::signal(SIGINT, previousInt);
+        std::signal(SIGTERM, previousTerm);
+        activeServer = nullptr;
+        ledger.removeObserver(&index);
+        if (!server.getLastError().empty()) {
+            out << "error: " << server.getLastError() << "\n";
+            status = 1;
+        }
+    }
+    return status;
+}
+
+} // namespace Batch
@@ -0,0 +1,71 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <iostream>
+#include <string>
+#include <vector>
+#include "../reports/ReportQuery.h"
+
+/**
+ * @brief Неинтерактивный (пакетный) режим FinanceTracker
+ *
+ * Пример:
+ *
+ *     FinanceTracker --ledger ledger.csv --import bank.csv \
+ *         --report csv:out/{user}.csv --report json:out/{user}.json --threads 8 \
+ *         --report csv:out/{user}-food.csv --query "columns=date,amount&category=Еда&sort=-amount"
+ *
+ * Отчёты всех пользователей формируются параллельно в одном процессе,
+ * сводка с замерами времени выводится одним блоком в конце.
+ */
+namespace Batch {
+
+struct ReportSpec {
+    std::string format;
+    std::string pathTemplate; // {user} заменяется на имя пользователя
+    Reports::ReportQuery query; // --query после --report: столбцы, фильтры, порядок
+};
+
+struct Options {
+    std::string ledgerPath;
+    std::vector<std::string> importPaths;
+    std::string rulesPath;          // правила категоризации импортируемых транзакций
+    bool dedupImports = true;       // отбрасывать импортируемые транзакции, уже бывшие в истории
+    std::vector<ReportSpec> reports;
+    std::vector<std::string> users; // пусто — все пользователи
+    std::size_t threads = 0;        // 0 — по числу ядер
+    std::string metricsPath;        // дамп метрик в формате Prometheus
+    std::string stateDir;           // каталог снимков и журнала изменений
+    std::size_t snapshotEvery = 0;  // автоматический снимок каждые N записей журнала
+    std::string reconcilePath;      // отчет о расхождениях балансов с историей
+    std::string alertsPath;         // тревоги детектора необычных списаний при импорте
+    std::string forecastPath;       // прогноз балансов по счетам
+    std::uint32_t forecastDays = 90;
+    std::uint32_t scenarios = 64;   // сценарии Монте-Карло для прогноза
+    int servePort = -1;             // HTTP-сервис после обработки (-1 — не запускать)
+    std::string evictDir;           // каталог выгрузки простаивающих пользователей (пусто — не выгружать)
+    std::size_t memoryBudgetMiB = 0; // предел памяти пользователей (0 — без предела)
+    std::uint32_t evictIdleSeconds = 0; // выгружать не запрашиваемых дольше (0 — только по пределу)
+    std::string archiveBefore;      // YYYY-MM-DD: история до этой даты уходит в холодный архив (пусто — нет)
+};
+
+/**
+ * @brief Разбор аргументов командной строки
+ * @param error Текст ошибки, если разбор не удался
+ * @return true если аргументы корректны
+ */
+bool parseArguments(int argc, char** argv, Options& options, std::string& error);
+
+/**
+ * @brief Выполняет пакетное задание
+ * @param out Поток для итоговой сводки
+ * @return Код завершения процесса (0 — успех)
+ */
+int run(const Options& options, std::ostream& out);
+
+/**
+ * @brief Справка по аргументам пакетного режима
+ */
+std::string usage();
+
+} // namespace Batch
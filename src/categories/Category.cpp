@@ -15,10 +15,42 @@ Category::Category(const std::string& categoryName) : name(categoryName) {}
  * @brief Получает название категории
  * @return Строка с названием категории
  */
-std::string Category::getName() const {
+const std::string& Category::getName() const {
     return name;
 }
 
+/**
+ * @brief Назначает родительскую категорию
+ * @param newParent Родитель или nullptr
+ * @return false если назначение образует цикл
+ */
+bool Category::setParent(std::shared_ptr<Category> newParent) {
+    if (newParent && (newParent.get() == this || newParent->isDescendantOf(*this))) {
+        return false;
+    }
+    parent = std::move(newParent);
+    return true;
+}
+
+/**
+ * @brief Проверяет, лежит ли категория в поддереве ancestor (не считая его самого)
+ */
+bool Category::isDescendantOf(const Category& ancestor) const {
+    for (const Category* p = parent.get(); p; p = p->parent.get()) {
+        if (p == &ancestor) {
+            return true;
+        }
+    }
+    return false;
+}
+
+/**
+ * @brief Полный путь от корня: "Еда > Продукты > Овощи"
+ */
+std::string Category::getPath() const {
+    return parent ? parent->getPath() + " > " + name : name;
+}
+
 // Перегрузка оператора ==
 /**
  * @brief Оператор сравнения двух категорий
@@ -1,6 +1,7 @@
 #pragma once
 #include <string>
 #include <iostream>
+#include <memory>
 
 /**
  * @brief Базовый класс для всех типов категорий транзакций
@@ -11,12 +12,20 @@
 class Category {
 protected:
     std::string name;
+    std::shared_ptr<Category> parent; // nullptr — корень иерархии
     
 public:
     Category(const std::string& categoryName);
     virtual ~Category() = default;
     
-    std::string getName() const;
+    const std::string& getName() const;
+
+    // Иерархия: "Еда > Продукты > Овощи". У категории пользователя родитель
+    // меняется через User::setCategoryParent, чтобы перестроилось дерево итогов
+    bool setParent(std::shared_ptr<Category> newParent);
+    const std::shared_ptr<Category>& getParent() const { return parent; }
+    bool isDescendantOf(const Category& ancestor) const;
+    std::string getPath() const;
     
     // Виртуальные методы (ПОЛИМОРФИЗМ)
     virtual std::string getType() const { return "Category"; }
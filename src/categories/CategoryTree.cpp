@@ -0,0 +1,193 @@
+/**
+ * @file CategoryTree.cpp
+ * @brief Реализация дерева категорий с итогами по поддеревьям
+ */
+
+#include "CategoryTree.h"
+#include <cmath>
+#include "../transactions/Transaction.h"
+
+namespace {
+
+std::int64_t toCents(double amount) {
+    return std::llround(amount * 100.0);
+}
+
+} // namespace
+
+/**
+ * @brief Добавляет категорию в дерево
+ * @param category Категория пользователя
+ */
+void CategoryTree::addCategory(const std::shared_ptr<Category>& category) {
+    if (!category || contains(*category)) {
+        return;
+    }
+    index.emplace(category.get(), nodes.size());
+    nodes.push_back(Node{category, NONE, 0, 0});
+    ownSpent.push_back(0);
+    ownIncome.push_back(0);
+    invalidateLayout();
+}
+
+/**
+ * @brief Перестраивает устаревшую раскладку перед запросом
+ */
+void CategoryTree::ensureLayout() const {
+    if (!stale.load(std::memory_order_acquire)) {
+        return;
+    }
+    std::lock_guard<std::mutex> lock(layoutMutex);
+    if (stale.load(std::memory_order_relaxed)) {
+        rebuild();
+        stale.store(false, std::memory_order_release);
+    }
+}
+
+/**
+ * @brief Раскладка узлов в порядке обхода в глубину и пересборка деревьев Фенвика
+ */
+void CategoryTree::rebuild() const {
+    std::vector<std::vector<std::size_t>> children(nodes.size());
+    std::vector<std::size_t> roots;
+    for (std::size_t i = 0; i < nodes.size(); ++i) {
+        const auto& parent = nodes[i].category->getParent();
+        auto it = parent ? index.find(parent.get()) : index.end();
+        nodes[i].parent = it == index.end() ? NONE : it->second;
+        (nodes[i].parent == NONE ? roots : children[nodes[i].parent]).push_back(i);
+    }
+
+    // Обход без рекурсии: глубина иерархии не ограничена
+    std::size_t position = 0;
+    std::vector<std::pair<std::size_t, std::size_t>> stack; // узел, следующий ребенок
+    for (std::size_t root : roots) {
+        nodes[root].enter = position++;
+        stack.emplace_back(root, 0);
+        while (!stack.empty()) {
+            auto& [node, next] = stack.back();
+            if (next < children[node].size()) {
+                std::size_t child = children[node][next++];
+                nodes[child].enter = position++;
+                stack.emplace_back(child, 0);
+            } else {
+                nodes[node].exit = position;
+                stack.pop_back();
+            }
+        }
+    }
+
+    std::vector<std::int64_t> spent(nodes.size()), income(nodes.size());
+    for (std::size_t i = 0; i < nodes.size(); ++i) {
+        spent[nodes[i].enter] = ownSpent[i];
+        income[nodes[i].enter] = ownIncome[i];
+    }
+    spentTree.assign(spent);
+    incomeTree.assign(income);
+}
+
+void CategoryTree::apply(const Transactions::Transaction& trans, std::int64_t sign) {
+    const auto& category = trans.getCategory();
+    auto it = category ? index.find(category.get()) : index.end();
+    if (it == index.end()) {
+        return;
+    }
+    std::int64_t cents = toCents(trans.getAmount());
+    std::size_t node = it->second;
+    // При устаревшей раскладке деревья соберутся из собственных сумм
+    bool layoutReady = !stale.load(std::memory_order_relaxed);
+    if (cents < 0) {
+        ownSpent[node] -= sign * cents;
+        if (layoutReady) spentTree.add(nodes[node].enter, -sign * cents);
+    } else {
+        ownIncome[node] += sign * cents;
+        if (layoutReady) incomeTree.add(nodes[node].enter, sign * cents);
+    }
+}
+
+/**
+ * @brief Учитывает транзакцию в итогах ее категории
+ * @param trans Транзакция
+ */
+void CategoryTree::addTransaction(const Transactions::Transaction& trans) {
+    apply(trans, 1);
+}
+
+/**
+ * @brief Исключает транзакцию из итогов ее категории
+ * @param trans Транзакция
+ */
+void CategoryTree::removeTransaction(const Transactions::Transaction& trans) {
+    apply(trans, -1);
+}
+
+CategoryTree::Totals CategoryTree::getOwnTotals(const Category& category) const {
+    auto it = index.find(&category);
+    if (it == index.end()) {
+        return {};
+    }
+    return Totals{ownSpent[it->second] / 100.0, ownIncome[it->second] / 100.0};
+}
+
+std::int64_t CategoryTree::subtreeSpent(std::size_t node) const {
+    return spentTree.range(nodes[node].enter, nodes[node].exit);
+}
+
+CategoryTree::Totals CategoryTree::getTotals(const Category& category) const {
+    auto it = index.find(&category);
+    if (it == index.end()) {
+        return {};
+    }
+    ensureLayout();
+    const Node& node = nodes[it->second];
+    return Totals{subtreeSpent(it->second) / 100.0, incomeTree.range(node.enter, node.exit) / 100.0};
+}
+
+/**
+ * @brief Проверка бюджетов категории и всех ее предков
+ * @param category Категория списания
+ * @param extraSpent Планируемое дополнительное списание
+ * @return Категория с превышенным бюджетом или nullptr
+ */
+const Category* CategoryTree::findExceededBudget(const Category& category, double extraSpent) const {
+    auto it = index.find(&category);
+    if (it == index.end()) {
+        return nullptr;
+    }
+    ensureLayout();
+    std::int64_t extra = toCents(extraSpent);
+    for (std::size_t node = it->second; node != NONE; node = nodes[node].parent) {
+        double budget = nodes[node].category->getBudgetLimit();
+        if (budget > 0.0 && subtreeSpent(node) + extra > toCents(budget)) {
+            return nodes[node].category.get();
+        }
+    }
+    return nullptr;
+}
+
+std::vector<std::shared_ptr<Category>> CategoryTree::getChildren(const Category* parent) const {
+    std::size_t parentNode = NONE;
+    if (parent) {
+        auto it = index.find(parent);
+        if (it == index.end()) {
+            return {};
+        }
+        parentNode = it->second;
+    }
+    ensureLayout();
+    std::vector<std::shared_ptr<Category>> result;
+    for (const auto& node : nodes) {
+        if (node.parent == parentNode) {
+            result.push_back(node.category);
+        }
+    }
+    return result;
+}
+
+std::size_t CategoryTree::memoryBytes() const {
+    // Узел unordered_map: пара, указатель на следующий и кэш хеша
+    std::size_t indexBytes = index.size() * (sizeof(std::pair<const Category*, std::size_t>) + 2 * sizeof(void*)) +
+                             index.bucket_count() * sizeof(void*);
+    return nodes.capacity() * sizeof(Node) + indexBytes +
+           (ownSpent.capacity() + ownIncome.capacity()) * sizeof(std::int64_t) +
+           spentTree.memoryBytes() + incomeTree.memoryBytes();
+}
@@ -0,0 +1,100 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <atomic>
+#include <memory>
+#include <mutex>
+#include <unordered_map>
+#include <vector>
+#include "Category.h"
+#include "../utils/FenwickTree.h"
+
+namespace Transactions { class Transaction; }
+
+/**
+ * @brief Иерархия категорий пользователя с итогами по поддеревьям
+ *
+ * Узлы раскладываются в порядке обхода в глубину (эйлеров обход), так что
+ * поддерево занимает непрерывный отрезок позиций [enter, exit). Собственные
+ * суммы узлов лежат в деревьях Фенвика по этим позициям: итог поддерева
+ * и проверка бюджета предка — запрос на отрезке за O(log n), проводка
+ * транзакции — точечное изменение. Суммы копятся в копейках, поэтому после
+ * отмены операций возвращаются к прежним значениям точно.
+ *
+ * Добавление категории или смена родителя только помечают раскладку
+ * устаревшей; она перестраивается за O(n) перед первым запросом итогов,
+ * так что загрузка n категорий стоит O(n), а не O(n²). Пока раскладка
+ * устарела, проводки копятся только в собственных суммах узлов, из которых
+ * и строятся деревья Фенвика. Перестройка из const-запросов защищена
+ * мьютексом: одновременные запросы к неизменяемому дереву допустимы.
+ */
+class CategoryTree {
+public:
+    struct Totals {
+        double spent = 0.0;   // сумма списаний по модулю
+        double income = 0.0;  // сумма поступлений
+    };
+
+    /**
+     * @brief Добавляет узел; родитель берется из Category::getParent
+     *
+     * Родитель, которого нет в дереве, не учитывается: узел становится корнем.
+     */
+    void addCategory(const std::shared_ptr<Category>& category);
+    /**
+     * @brief Помечает раскладку устаревшей после смены родителей
+     */
+    void invalidateLayout() { stale.store(true, std::memory_order_relaxed); }
+
+    void addTransaction(const Transactions::Transaction& trans);
+    void removeTransaction(const Transactions::Transaction& trans);
+
+    bool contains(const Category& category) const { return index.count(&category) != 0; }
+    std::size_t size() const { return nodes.size(); }
+    /**
+     * @brief Память узлов, индекса и деревьев итогов (без самих категорий)
+     */
+    std::size_t memoryBytes() const;
+
+    /**
+     * @brief Суммы транзакций самой категории, без подкатегорий
+     */
+    Totals getOwnTotals(const Category& category) const;
+    /**
+     * @brief Суммы по поддереву: категория и все ее подкатегории
+     */
+    Totals getTotals(const Category& category) const;
+    /**
+     * @brief Ближайшая снизу категория на пути к корню, чей бюджет превышен
+     * @param category Категория списания
+     * @param extraSpent Планируемое дополнительное списание
+     * @return nullptr если все бюджеты на пути соблюдены
+     */
+    const Category* findExceededBudget(const Category& category, double extraSpent = 0.0) const;
+    /**
+     * @brief Дочерние категории в порядке добавления (nullptr — корни)
+     */
+    std::vector<std::shared_ptr<Category>> getChildren(const Category* parent) const;
+
+private:
+    struct Node {
+        std::shared_ptr<Category> category;
+        std::size_t parent;   // NONE для корня
+        std::size_t enter;    // позиция в обходе
+        std::size_t exit;     // конец поддерева (не включительно)
+    };
+    static constexpr std::size_t NONE = static_cast<std::size_t>(-1);
+
+    // Раскладка (parent, enter, exit) и деревья Фенвика строятся лениво из const-запросов
+    mutable std::vector<Node> nodes;
+    std::unordered_map<const Category*, std::size_t> index;
+    std::vector<std::int64_t> ownSpent, ownIncome;            // по номерам узлов, копейки
+    mutable FenwickTree<std::int64_t> spentTree, incomeTree;  // по позициям обхода
+    mutable std::atomic<bool> stale{false};
+    mutable std::mutex layoutMutex;
+
+    void ensureLayout() const;
+    void rebuild() const;
+    void apply(const Transactions::Transaction& trans, std::int64_t sign);
+    std::int64_t subtreeSpent(std::size_t node) const;
+};
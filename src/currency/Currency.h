@@ -0,0 +1,50 @@
+#pragma once
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+/**
+ * @brief Валюты, в которых ведутся счета
+ */
+enum class Currency : std::uint8_t {
+    RUB,
+    USD,
+    EUR,
+    COUNT
+};
+
+constexpr std::size_t CURRENCY_COUNT = static_cast<std::size_t>(Currency::COUNT);
+
+// Суммы с разбивкой по валютам (индекс — значение Currency)
+using CurrencyAmounts = std::array<double, CURRENCY_COUNT>;
+
+inline std::size_t currencyIndex(Currency c) {
+    return static_cast<std::size_t>(c);
+}
+
+/**
+ * @brief Код валюты ISO 4217
+ */
+inline std::string currencyCode(Currency c) {
+    switch (c) {
+        case Currency::RUB: return "RUB";
+        case Currency::USD: return "USD";
+        case Currency::EUR: return "EUR";
+        default: return "???";
+    }
+}
+
+/**
+ * @brief Разбор кода валюты
+ * @return true если код известен
+ */
+inline bool parseCurrency(const std::string& code, Currency& c) {
+    for (std::size_t i = 0; i < CURRENCY_COUNT; ++i) {
+        if (code == currencyCode(static_cast<Currency>(i))) {
+            c = static_cast<Currency>(i);
+            return true;
+        }
+    }
+    return false;
+}
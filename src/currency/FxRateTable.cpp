@@ -0,0 +1,112 @@
+/**
+ * @file FxRateTable.cpp
+ * @brief Реализация таблицы курсов валют
+ */
+
+#include "FxRateTable.h"
+#include <algorithm>
+#include <fstream>
+#include "../utils/DateUtils.h"
+#include "../utils/Utils.h"
+
+/**
+ * @brief Добавляет курс с сохранением упорядоченности истории
+ */
+void FxRateTable::setRate(Currency c, TimePoint effective, double rate) {
+    auto& entries = history[currencyIndex(c)];
+    auto pos = std::upper_bound(entries.begin(), entries.end(), effective,
+        [](const TimePoint& t, const auto& entry) { return t < entry.first; });
+    if (pos != entries.begin() && std::prev(pos)->first == effective) {
+        std::prev(pos)->second = rate;
+    } else {
+        entries.insert(pos, {effective, rate});
+    }
+}
+
+/**
+ * @brief Курс валюты к базовой на момент времени (бинарный поиск по истории)
+ */
+bool FxRateTable::rateToBase(Currency c, TimePoint at, double& rate) const {
+    if (c == BASE) {
+        rate = 1.0;
+        return true;
+    }
+    const auto& entries = history[currencyIndex(c)];
+    auto pos = std::upper_bound(entries.begin(), entries.end(), at,
+        [](const TimePoint& t, const auto& entry) { return t < entry.first; });
+    if (pos == entries.begin()) {
+        return false;
+    }
+    rate = std::prev(pos)->second;
+    return true;
+}
+
+bool FxRateTable::getRate(Currency from, Currency to, TimePoint at, double& rate) const {
+    double fromRate = 0.0;
+    double toRate = 0.0;
+    if (!rateToBase(from, at, fromRate) || !rateToBase(to, at, toRate) || toRate == 0.0) {
+        return false;
+    }
+    rate = fromRate / toRate;
+    return true;
+}
+
+bool FxRateTable::convert(double amount, Currency from, Currency to, TimePoint at, double& result) const {
+    double rate = 0.0;
+    if (!getRate(from, to, at, rate)) {
+        return false;
+    }
+    result = amount * rate;
+    return true;
+}
+
+bool FxRateTable::convertTotals(const CurrencyAmounts& totals, Currency target, TimePoint at, double& result) const {
+    double sum = 0.0;
+    for (std::size_t i = 0; i < CURRENCY_COUNT; ++i) {
+        if (totals[i] == 0.0) continue;
+        double rate = 0.0;
+        if (!getRate(static_cast<Currency>(i), target, at, rate)) {
+            return false;
+        }
+        sum += totals[i] * rate;
+    }
+    result = sum;
+    return true;
+}
+
+bool FxRateTable::loadFile(const std::string& path) {
+    std::ifstream file(path);
+    if (!file.is_open()) {
+        lastError = "cannot open " + path;
+        return false;
+    }
+
+    std::string line;
+    std::size_t lineNo = 0;
+    while (std::getline(file, line)) {
+        ++lineNo;
+        if (line.empty() || line[0] == '#' || line == "\r") {
+            continue;
+        }
+        auto fields = splitCsvLine(line);
+        TimePoint effective;
+        Currency currency;
+        double rate = 0.0;
+        bool ok = fields.size() >= 3
+            && DateUtils::parseTimePoint(fields[0], effective)
+            && parseCurrency(fields[1], currency);
+        if (ok) {
+            try {
+                rate = std::stod(fields[2]);
+            } catch (...) {
+                ok = false;
+            }
+        }
+        if (!ok || rate <= 0.0) {
+            lastError = path + ":" + std::to_string(lineNo) + ": expected <date>,<currency>,<rate>";
+            return false;
+        }
+        setRate(currency, effective, rate);
+    }
+    return true;
+}
@@ -0,0 +1,64 @@
+#pragma once
+#include <chrono>
+#include <string>
+#include <utility>
+#include <vector>
+#include "Currency.h"
+
+/**
+ * @brief Таблица курсов валют с версионированием по времени
+ *
+ * Для каждой валюты хранится упорядоченная по времени история курсов
+ * к базовой валюте (RUB). Курс на момент времени — последний вступивший
+ * в силу не позже этого момента. Файл курсов — CSV:
+ *
+ *     <дата вступления в силу>,<валюта>,<курс к RUB>
+ *     2026-01-01 00:00:00,USD,92.50
+ *
+ * Для агрегатов предназначен convertTotals(): суммы копятся по валютам,
+ * а конвертация выполняется по одному разу на валюту, а не на каждую строку.
+ */
+class FxRateTable {
+public:
+    using TimePoint = std::chrono::system_clock::time_point;
+
+private:
+    std::array<std::vector<std::pair<TimePoint, double>>, CURRENCY_COUNT> history;
+    std::string lastError;
+
+    bool rateToBase(Currency c, TimePoint at, double& rate) const;
+
+public:
+    static constexpr Currency BASE = Currency::RUB;
+
+    /**
+     * @brief Загружает курсы из файла (дополняя уже загруженные)
+     * @return true если файл прочитан без ошибок
+     */
+    bool loadFile(const std::string& path);
+
+    /**
+     * @brief Добавляет курс: 1 единица валюты = rate RUB начиная с момента effective
+     */
+    void setRate(Currency c, TimePoint effective, double rate);
+
+    /**
+     * @brief Курс пересчёта from -> to на момент времени
+     * @return false если для одной из валют нет курса на этот момент
+     */
+    bool getRate(Currency from, Currency to, TimePoint at, double& rate) const;
+
+    /**
+     * @brief Пересчёт одной суммы
+     * @return false если курс неизвестен
+     */
+    bool convert(double amount, Currency from, Currency to, TimePoint at, double& result) const;
+
+    /**
+     * @brief Пересчёт сумм, накопленных по валютам, в целевую валюту
+     * @return false если для ненулевой суммы нет курса
+     */
+    bool convertTotals(const CurrencyAmounts& totals, Currency target, TimePoint at, double& result) const;
+
+    const std::string& getLastError() const { return lastError; }
+};
@@ -0,0 +1,319 @@
+/**
+ * @file Forecaster.cpp
+ * @brief Построение модели по истории и блочный расчет прогноза
+ */
+
+#include "Forecaster.h"
+#include <algorithm>
+#include <atomic>
+#include <cmath>
+#include <iomanip>
+#include <map>
+#include <random>
+#include <thread>
+#include <tuple>
+#include <unordered_map>
+#include "../utils/Utf8.h"
+
+namespace Forecast {
+
+namespace {
+
+constexpr double SECONDS_PER_DAY = 86400.0;
+constexpr std::size_t BLOCK = 2048;
+
+double daysBetween(std::chrono::system_clock::time_point from, std::chrono::system_clock::time_point to) {
+    return std::chrono::duration<double>(to - from).count() / SECONDS_PER_DAY;
+}
+
+struct Series {
+    std::vector<double> days;    // дни от asOf (отрицательные — прошлое)
+    std::vector<double> amounts;
+};
+
+/**
+ * @brief Проверка регулярности: период и первый будущий день, если ряд регулярный
+ */
+bool detectPeriod(Series& series, std::uint32_t& period, std::uint32_t& firstDay) {
+    if (series.days.size() < 3) {
+        return false;
+    }
+    std::vector<std::size_t> order(series.days.size());
+    for (std::size_t i = 0; i < order.size(); ++i) order[i] = i;
+    std::sort(order.begin(), order.end(), [&](std::size_t a, std::size_t b) {
+        return series.days[a] < series.days[b];
+    });
+
+    std::vector<double> gaps;
+    for (std::size_t i = 1; i < order.size(); ++i) {
+        gaps.push_back(series.days[order[i]] - series.days[order[i - 1]]);
+    }
+    std::vector<double> sorted = gaps;
+    std::nth_element(sorted.begin(), sorted.begin() + sorted.size() / 2, sorted.end());
+    double median = sorted[sorted.size() / 2];
+    if (median < 1.0) {
+        return false;
+    }
+    double tolerance = std::max(2.0, 0.2 * median);
+    for (double gap : gaps) {
+        if (std::fabs(gap - median) > tolerance) {
+            return false;
+        }
+    }
+
+    double last = series.days[order.back()];
+    if (last + 2.0 * median < 0.0) {
+        return false; // платеж прекратился
+    }
+    period = static_cast<std::uint32_t>(std::lround(median));
+    double next = last + period;
+    while (next < 0.0) next += period;
+    firstDay = static_cast<std::uint32_t>(std::floor(next));
+    return true;
+}
+
+} // namespace
+
+std::uint32_t Model::addAccount(double startBalance, double dailyGrowth, double dailyDrift, double dailyNoise) {
+    balance.push_back(startBalance);
+    growth.push_back(dailyGrowth);
+    drift.push_back(dailyDrift);
+    noise.push_back(dailyNoise);
+    return static_cast<std::uint32_t>(balance.size() - 1);
+}
+
+void Model::addRecurring(std::uint32_t account, std::uint32_t firstDay, std::uint32_t period, double amount) {
+    Recurring rec{account, firstDay, std::max<std::uint32_t>(period, 1), amount};
+    // Обычно добавляются по возрастанию счета
+    auto pos = std::upper_bound(recurring.begin(), recurring.end(), account,
+        [](std::uint32_t acc, const Recurring& r) { return acc < r.account; });
+    recurring.insert(pos, rec);
+}
+
+Model buildModel(Ledger& ledger, std::chrono::system_clock::time_point asOf) {
+    // Транзакции счета, сгруппированные по (описание, категория, знак)
+    using GroupKey = std::tuple<std::string, const Category*, bool>;
+    struct AccountHistory {
+        std::map<GroupKey, Series> groups;
+        double rate = 0.0;
+        std::chrono::system_clock::time_point rateDate = std::chrono::system_clock::time_point::min();
+        double firstDay = 0.0;
+    };
+
+    Model model;
+    ledger.forEachUser([&](const std::shared_ptr<User>& user) {
+        const auto& accounts = user->getAccounts();
+        std::vector<AccountHistory> histories(accounts.size());
+        std::unordered_map<const Account*, std::size_t> slots;
+        for (std::size_t i = 0; i < accounts.size(); ++i) {
+            slots.emplace(accounts[i].get(), i);
+        }
+
+        for (const auto& trans : user->getTransactions()) {
+            auto slot = slots.find(trans->getAccount().get());
+            double day = daysBetween(asOf, trans->getDate());
+            if (slot == slots.end() || day > 0.0) {
+                continue;
+            }
+            AccountHistory& h = histories[slot->second];
+            h.firstDay = std::min(h.firstDay, day);
+            if (auto compounding = dynamic_cast<const Transactions::CompoundingTransaction*>(trans.get())) {
+                if (trans->getDate() >= h.rateDate) {
+                    h.rate = compounding->getInterestRate();
+                    h.rateDate = trans->getDate();
+                }
+                continue;
+            }
+            auto& series = h.groups[{Utf8::foldCase(trans->getDescription()), trans->getCategory().get(),
+                                     trans->getAmount() >= 0}];
+            series.days.push_back(day);
+            series.amounts.push_back(trans->getAmount());
+        }
+
+        for (std::size_t a = 0; a < accounts.size(); ++a) {
+            AccountHistory& h = histories[a];
+            double growth = h.rate > 0.0 ? std::pow(1.0 + h.rate / 100.0, 1.0 / 365.0) : 1.0;
+            std::uint32_t index = model.addAccount(accounts[a]->getBalance(), growth);
+            model.users.push_back(user->getName());
+            model.accounts.push_back(accounts[a]->getName());
+
+            // Нерегулярный поток: дневные суммы за период истории
+            std::map<std::int64_t, double> daily;
+            for (auto& [key, series] : h.groups) {
+                std::uint32_t period = 0;
+                std::uint32_t first = 0;
+                if (detectPeriod(series, period, first)) {
+                    double sum = 0.0;
+                    for (double amount : series.amounts) sum += amount;
+                    model.addRecurring(index, first, period, sum / series.amounts.size());
+                    continue;
+                }
+                for (std::size_t i = 0; i < series.days.size(); ++i) {
+                    daily[static_cast<std::int64_t>(std::floor(series.days[i]))] += series.amounts[i];
+                }
+            }
+            double span = std::max(1.0, std::ceil(-h.firstDay));
+            double sum = 0.0;
+            double sumSq = 0.0;
+            for (const auto& [day, amount] : daily) {
+                sum += amount;
+                sumSq += amount * amount;
+            }
+            double mean = sum / span;
+            model.drift[index] = mean;
+            model.noise[index] = std::sqrt(std::max(0.0, sumSq / span - mean * mean));
+        }
+    });
+    return model;
+}
+
+Result run(const Model& model, const Settings& settings) {
+    auto start = std::chrono::steady_clock::now();
+    const std::size_t n = model.size();
+    const std::uint32_t days = std::max<std::uint32_t>(settings.days, 1);
+    const std::uint32_t scenarios = settings.scenarios;
+
+    Result result;
+    result.days = days;
+    result.scenarios = scenarios;
+    result.accounts.resize(n);
+
+    // Общие сценарии: стандартные случайные блуждания walks[s * days + d]
+    std::vector<double> walks(static_cast<std::size_t>(scenarios) * days);
+    std::vector<double> finals(scenarios);
+    std::mt19937_64 rng(settings.seed);
+    std::normal_distribution<double> normal;
+    for (std::uint32_t s = 0; s < scenarios; ++s) {
+        double w = 0.0;
+        for (std::uint32_t d = 0; d < days; ++d) {
+            w += normal(rng);
+            walks[s * days + d] = w;
+        }
+        finals[s] = w;
+    }
+    std::sort(finals.begin(), finals.end());
+    auto quantile = [&](double q) {
+        return finals.empty() ? 0.0 : finals[std::min<std::size_t>(finals.size() - 1,
+                                                                  static_cast<std::size_t>(q * finals.size()))];
+    };
+    const double q5 = quantile(0.05);
+    const double q50 = quantile(0.50);
+    const double q95 = quantile(0.95);
+
+    std::size_t blocks = (n + BLOCK - 1) / BLOCK;
+    std::size_t threads = settings.threads ? settings.threads : std::max(1u, std::thread::hardware_concurrency());
+    threads = std::max<std::size_t>(1, std::min(threads, blocks));
+    result.threadsUsed = threads;
+
+    std::atomic<std::size_t> nextBlock{0};
+    auto worker = [&]() {
+        std::vector<double> flows(static_cast<std::size_t>(days) * BLOCK);
+        std::vector<double> paths(static_cast<std::size_t>(days) * BLOCK);
+        std::vector<double> b(BLOCK);
+        std::vector<double> low(BLOCK);
+        std::vector<double> own(days);
+
+        for (std::size_t blk = nextBlock++; blk < blocks; blk = nextBlock++) {
+            const std::size_t begin = blk * BLOCK;
+            const std::size_t count = std::min(BLOCK, n - begin);
+            const double* growth = model.growth.data() + begin;
+            const double* drift = model.drift.data() + begin;
+
+            // Регулярные операции раскладываются по дням: flows[d * BLOCK + i]
+            std::fill(flows.begin(), flows.begin() + static_cast<std::size_t>(days) * BLOCK, 0.0);
+            auto rec = std::lower_bound(model.recurring.begin(), model.recurring.end(), begin,
+                [](const Model::Recurring& r, std::size_t acc) { return r.account < acc; });
+            for (; rec != model.recurring.end() && rec->account < begin + count; ++rec) {
+                for (std::uint32_t d = rec->firstDay; d < days; d += rec->period) {
+                    flows[static_cast<std::size_t>(d) * BLOCK + (rec->account - begin)] += rec->amount;
+                }
+            }
+
+            std::copy(model.balance.begin() + begin, model.balance.begin() + begin + count, b.begin());
+            std::copy(b.begin(), b.begin() + count, low.begin());
+            for (std::uint32_t d = 0; d < days; ++d) {
+                const double* flow = flows.data() + static_cast<std::size_t>(d) * BLOCK;
+                double* path = paths.data() + static_cast<std::size_t>(d) * BLOCK;
+                for (std::size_t i = 0; i < count; ++i) {
+                    double x = b[i] > 0.0 ? b[i] * growth[i] : b[i];
+                    x += drift[i] + flow[i];
+                    b[i] = x;
+                    path[i] = x;
+                    low[i] = std::min(low[i], x);
+                }
+            }
+
+            for (std::size_t i = 0; i < count; ++i) {
+                AccountForecast& f = result.accounts[begin + i];
+                double sd = model.noise[begin + i];
+                f.start = model.balance[begin + i];
+                f.expected = b[i];
+                f.minExpected = low[i];
+                f.p5 = b[i] + sd * q5;
+                f.p50 = b[i] + sd * q50;
+                f.p95 = b[i] + sd * q95;
+                if (scenarios == 0 || sd == 0.0) {
+                    f.negativeShare = low[i] < 0.0 ? 1.0 : 0.0;
+                    continue;
+                }
+                for (std::uint32_t d = 0; d < days; ++d) {
+                    own[d] = paths[static_cast<std::size_t>(d) * BLOCK + i];
+                }
+                std::uint32_t negative = 0;
+                for (std::uint32_t s = 0; s < scenarios; ++s) {
+                    const double* walk = walks.data() + static_cast<std::size_t>(s) * days;
+                    for (std::uint32_t d = 0; d < days; ++d) {
+                        if (own[d] + sd * walk[d] < 0.0) {
+                            ++negative;
+                            break;
+                        }
+                    }
+                }
+                f.negativeShare = static_cast<double>(negative) / scenarios;
+            }
+        }
+    };
+
+    std::vector<std::thread> pool;
+    for (std::size_t t = 1; t < threads; ++t) {
+        pool.emplace_back(worker);
+    }
+    worker();
+    for (auto& th : pool) {
+        th.join();
+    }
+
+    result.millis = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+    return result;
+}
+
+std::vector<double> expectedPath(const Model& model, std::uint32_t account, std::uint32_t days) {
+    std::vector<double> flows(days, 0.0);
+    for (const auto& rec : model.recurring) {
+        if (rec.account != account) continue;
+        for (std::uint32_t d = rec.firstDay; d < days; d += rec.period) {
+            flows[d] += rec.amount;
+        }
+    }
+    std::vector<double> path(days);
+    double b = model.balance[account];
+    for (std::uint32_t d = 0; d < days; ++d) {
+        b = (b > 0.0 ? b * model.growth[account] : b) + model.drift[account] + flows[d];
+        path[d] = b;
+    }
+    return path;
+}
+
+void writeCsv(std::ostream& os, const Model& model, const Result& result) {
+    os << "User,Account,Start,Expected,MinExpected,P5,P50,P95,NegativeShare\n";
+    os << std::fixed << std::setprecision(2);
+    for (std::size_t i = 0; i < result.accounts.size(); ++i) {
+        const auto& f = result.accounts[i];
+        os << (i < model.users.size() ? model.users[i] : "") << ","
+           << (i < model.accounts.size() ? model.accounts[i] : std::to_string(i)) << ","
+           << f.start << "," << f.expected << "," << f.minExpected << ","
+           << f.p5 << "," << f.p50 << "," << f.p95 << "," << f.negativeShare << "\n";
+    }
+}
+
+} // namespace Forecast
@@ -0,0 +1,103 @@
+#pragma once
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <iostream>
+#include <string>
+#include <vector>
+#include "../ledger/Ledger.h"
+
+namespace Forecast {
+
+/**
+ * @brief Модель движения средств по счетам в виде структуры массивов
+ *
+ * Для счета i: стартовый баланс, дневной множитель процентов (применяется
+ * к положительному балансу), средний дневной нерегулярный поток и его
+ * стандартное отклонение. Регулярные операции хранятся отдельным списком.
+ */
+struct Model {
+    struct Recurring {
+        std::uint32_t account;
+        std::uint32_t firstDay;  // день первого срабатывания от даты прогноза
+        std::uint32_t period;    // период в днях
+        double amount;           // сумма со знаком
+    };
+
+    // Имена, а не указатели: модель не удерживает счета от выгрузки пользователя
+    std::vector<std::string> users;
+    std::vector<std::string> accounts;  // может быть пуст для синтетической модели
+    std::vector<double> balance;
+    std::vector<double> growth;
+    std::vector<double> drift;
+    std::vector<double> noise;
+    std::vector<Recurring> recurring;   // отсортированы по счету
+
+    std::size_t size() const { return balance.size(); }
+    /**
+     * @brief Добавляет счет; возвращает его номер
+     */
+    std::uint32_t addAccount(double startBalance, double dailyGrowth = 1.0, double dailyDrift = 0.0,
+                             double dailyNoise = 0.0);
+    void addRecurring(std::uint32_t account, std::uint32_t firstDay, std::uint32_t period, double amount);
+};
+
+struct Settings {
+    std::uint32_t days = 90;
+    std::uint32_t scenarios = 64;  // 0 — только ожидаемый прогноз
+    std::size_t threads = 0;       // 0 — по числу ядер
+    std::uint64_t seed = 42;
+};
+
+struct AccountForecast {
+    double start = 0.0;
+    double expected = 0.0;       // баланс в конце горизонта без шума
+    double minExpected = 0.0;    // минимум ожидаемого пути
+    double p5 = 0.0;             // квантили конечного баланса по сценариям
+    double p50 = 0.0;
+    double p95 = 0.0;
+    double negativeShare = 0.0;  // доля сценариев, где баланс уходил в минус
+};
+
+struct Result {
+    std::vector<AccountForecast> accounts;
+    std::uint32_t days = 0;
+    std::uint32_t scenarios = 0;
+    std::size_t threadsUsed = 0;
+    double millis = 0.0;
+};
+
+/**
+ * @brief Строит модель по истории журнала
+ *
+ * Регулярные операции ищутся среди транзакций счета с одинаковыми описанием
+ * (без учета регистра), категорией и знаком: не меньше трех повторов
+ * с почти постоянным интервалом, последний — не позже двух периодов назад.
+ * Остальные транзакции дают средний дневной поток и его разброс за период
+ * истории. Ставка — из последней CompoundingTransaction счета.
+ * @param asOf Дата начала прогноза
+ */
+Model buildModel(Ledger& ledger, std::chrono::system_clock::time_point asOf);
+
+/**
+ * @brief Прогноз балансов на settings.days дней вперед
+ *
+ * Счета обрабатываются блоками по потокам; внутри блока дни идут во внешнем
+ * цикле, а счета — во внутреннем по плотным массивам, что векторизуется.
+ * Сценарии Монте-Карло — общие для всех счетов нормированные случайные
+ * блуждания, масштабируемые шумом счета: распределение по каждому счету
+ * точное, а генерация случайных чисел не зависит от числа счетов.
+ */
+Result run(const Model& model, const Settings& settings);
+
+/**
+ * @brief Ожидаемый дневной путь баланса одного счета
+ */
+std::vector<double> expectedPath(const Model& model, std::uint32_t account, std::uint32_t days);
+
+/**
+ * @brief Прогноз в CSV (по строке на счет)
+ */
+void writeCsv(std::ostream& os, const Model& model, const Result& result);
+
+} // namespace Forecast
@@ -0,0 +1,52 @@
+/**
+ * @file CommandLog.cpp
+ * @brief Кольцевой буфер операций для undo/redo
+ */
+
+#include "CommandLog.h"
+
+namespace History {
+
+static_assert(sizeof(CommandLog::Record) == 16, "Record must stay compact");
+
+CommandLog::CommandLog(std::size_t maxRecords) : capacity(maxRecords ? maxRecords : 1) {}
+
+void CommandLog::record(std::uint32_t account, double delta, std::uint32_t flags) {
+    if (!ring) {
+        ring.reset(new Record[capacity]);
+    }
+    ring[position % capacity] = Record{delta, account, flags};
+    ++position;
+    redoLimit = position;
+    if (position - oldest > capacity) {
+        oldest = position - capacity;
+    }
+}
+
+const CommandLog::Record* CommandLog::undo() {
+    if (!canUndo()) {
+        return nullptr;
+    }
+    --position;
+    return &ring[position % capacity];
+}
+
+const CommandLog::Record* CommandLog::redo() {
+    if (!canRedo()) {
+        return nullptr;
+    }
+    return &ring[position++ % capacity];
+}
+
+void CommandLog::setCapacity(std::size_t maxRecords) {
+    capacity = maxRecords ? maxRecords : 1;
+    clear();
+}
+
+void CommandLog::clear() {
+    ring.reset();
+    oldest = position;
+    redoLimit = position;
+}
+
+} // namespace History
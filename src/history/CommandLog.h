@@ -0,0 +1,77 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+
+namespace History {
+
+/**
+ * @brief Журнал команд пользователя для undo/redo и отката к контрольной точке
+ *
+ * Хранит последние N операций в кольцевом буфере записей фиксированного
+ * размера (16 байт, без указателей). Буфер выделяется при первой операции,
+ * поэтому пользователи без изменений памяти не занимают, а у активных
+ * расход ограничен capacity * sizeof(Record).
+ *
+ * Позиция журнала — сквозной номер следующей операции; она же служит
+ * контрольной точкой. Операции после позиции (отмененные) доступны для redo
+ * до первой новой операции. Самые старые записи вытесняются, и откатиться
+ * дальше них нельзя.
+ */
+class CommandLog {
+public:
+    /**
+     * @brief Запись об изменении баланса
+     */
+    struct Record {
+        double delta;            // фактическое изменение баланса
+        std::uint32_t account;   // номер счета у пользователя
+        std::uint32_t flags;
+    };
+
+    static constexpr std::uint32_t WITH_TRANSACTION = 1; // операция добавила транзакцию в историю
+    static constexpr std::size_t DEFAULT_CAPACITY = 256;
+
+private:
+    std::unique_ptr<Record[]> ring;
+    std::size_t capacity;
+    std::uint64_t oldest = 0;   // номер самой старой сохраненной операции
+    std::uint64_t position = 0; // номер следующей операции
+    std::uint64_t redoLimit = 0;
+
+public:
+    explicit CommandLog(std::size_t maxRecords = DEFAULT_CAPACITY);
+
+    /**
+     * @brief Записывает новую операцию; доступные для redo операции сбрасываются
+     */
+    void record(std::uint32_t account, double delta, std::uint32_t flags = 0);
+    /**
+     * @brief Снимает последнюю операцию для отмены
+     * @return Запись или nullptr, если отменять нечего
+     */
+    const Record* undo();
+    /**
+     * @brief Возвращает следующую отмененную операцию для повтора
+     * @return Запись или nullptr, если повторять нечего
+     */
+    const Record* redo();
+
+    bool canUndo() const { return position > oldest; }
+    bool canRedo() const { return redoLimit > position; }
+    std::uint64_t getPosition() const { return position; }
+    std::uint64_t getOldest() const { return oldest; }
+
+    /**
+     * @brief Меняет емкость; история при этом очищается
+     */
+    void setCapacity(std::size_t maxRecords);
+    std::size_t getCapacity() const { return capacity; }
+    void clear();
+    /**
+     * @brief Память, занятая буфером записей
+     */
+    std::size_t memoryBytes() const { return ring ? capacity * sizeof(Record) : 0; }
+};
+
+} // namespace History
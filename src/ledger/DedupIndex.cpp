@@ -0,0 +1,194 @@
+/**
+ * @file DedupIndex.cpp
+ * @brief Индекс содержимого истории для отсева повторно импортированных транзакций
+ */
+
+#include "DedupIndex.h"
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <numeric>
+#include "../users/User.h"
+#include "../utils/Utf8.h"
+
+namespace {
+
+constexpr std::uint64_t FNV_OFFSET = 14695981039346656037ull;
+constexpr std::uint64_t FNV_PRIME = 1099511628211ull;
+
+void mixBytes(std::uint64_t& h, const void* data, std::size_t size) {
+    const auto* bytes = static_cast<const unsigned char*>(data);
+    for (std::size_t i = 0; i < size; ++i) {
+        h = (h ^ bytes[i]) * FNV_PRIME;
+    }
+}
+
+// Финальное перемешивание splitmix64: биты FNV для фильтра Блума слабоваты
+std::uint64_t finalize(std::uint64_t h) {
+    h = (h ^ (h >> 30)) * 0xbf58476d1ce4e5b9ull;
+    h = (h ^ (h >> 27)) * 0x94d049bb133111ebull;
+    return h ^ (h >> 31);
+}
+
+std::int64_t toSeconds(std::chrono::system_clock::time_point tp) {
+    return std::chrono::duration_cast<std::chrono::seconds>(tp.time_since_epoch()).count();
+}
+
+/**
+ * @brief Описание без учета регистра, пробелы по краям убраны, внутри — по одному
+ */
+std::string normalizeDescription(const std::string& text) {
+    std::string folded = Utf8::foldCase(text);
+    std::string out;
+    out.reserve(folded.size());
+    bool space = false;
+    for (char c : folded) {
+        if (c == ' ' || c == '\t' || c == '\r' || c == '\n') {
+            space = !out.empty();
+            continue;
+        }
+        if (space) {
+            out += ' ';
+            space = false;
+        }
+        out += c;
+    }
+    return out;
+}
+
+} // namespace
+
+std::uint64_t contentHash(const Transactions::Transaction& trans) {
+    std::uint64_t h = FNV_OFFSET;
+    std::int64_t seconds = toSeconds(trans.getDate());
+    std::int64_t cents = std::llround(trans.getAmount() * 100.0);
+    mixBytes(h, &seconds, sizeof(seconds));
+    mixBytes(h, &cents, sizeof(cents));
+    const auto& account = trans.getAccount();
+    if (account) {
+        mixBytes(h, account->getName().data(), account->getName().size());
+    }
+    const char separator = '\x1f';
+    mixBytes(h, &separator, 1);
+    std::string description = normalizeDescription(trans.getDescription());
+    mixBytes(h, description.data(), description.size());
+    return finalize(h);
+}
+
+DedupIndex::Key DedupIndex::keyOf(const Transactions::Transaction& trans) {
+    return Key{toSeconds(trans.getDate()), contentHash(trans)};
+}
+
+/**
+ * @brief Догоняет историю: дописанный хвост сливается, иначе индекс строится заново
+ * @param user Пользователь, чью историю отражает индекс
+ */
+void DedupIndex::sync(const User& user) {
+    if (built && user.getHistoryVersion() == version) {
+        return;
+    }
+    if (built && user.isAppendOnlySince(version) && synced <= user.getTransactions().size()) {
+        append(user);
+    } else {
+        rebuild(user);
+    }
+    version = user.getHistoryVersion();
+    synced = user.getTransactions().size();
+    built = true;
+}
+
+void DedupIndex::rebuild(const User& user) {
+    const auto& history = user.getTransactions();
+    const auto& archive = user.getArchive();
+    keys.clear();
+    keys.reserve(history.size() + archive.size());
+    for (const auto& trans : history) {
+        keys.push_back(keyOf(*trans));
+    }
+    // Перенесенные в архив строки тоже не должны импортироваться повторно
+    if (archive.size() > 0) {
+        for (const auto& trans : archive.materialize(Storage::ColdStore::TimePoint::min(),
+                                                     Storage::ColdStore::TimePoint::max(), user)) {
+            keys.push_back(keyOf(*trans));
+        }
+    }
+    std::sort(keys.begin(), keys.end());
+    bloom.reset(keys.size() * 2);
+    for (const auto& key : keys) {
+        bloom.add(key.hash);
+    }
+}
+
+void DedupIndex::append(const User& user) {
+    const auto& history = user.getTransactions();
+    std::vector<Key> tail;
+    tail.reserve(history.size() - synced);
+    for (std::size_t i = synced; i < history.size(); ++i) {
+        tail.push_back(keyOf(*history[i]));
+    }
+    if (tail.empty()) {
+        return;
+    }
+    std::sort(tail.begin(), tail.end());
+
+    // Хвост обычно новее истории и просто дописывается; иначе сливается
+    // только с перекрывающимся по времени концом индекса
+    std::size_t middle = keys.size();
+    std::size_t first = static_cast<std::size_t>(std::upper_bound(keys.begin(), keys.end(), tail.front()) - keys.begin());
+    keys.insert(keys.end(), tail.begin(), tail.end());
+    if (first < middle) {
+        std::inplace_merge(keys.begin() + static_cast<std::ptrdiff_t>(first),
+                           keys.begin() + static_cast<std::ptrdiff_t>(middle), keys.end());
+    }
+
+    if (bloom.size() + tail.size() > bloom.getCapacity()) {
+        bloom.reset(keys.size() * 2);
+        for (const auto& key : keys) {
+            bloom.add(key.hash);
+        }
+    } else {
+        for (const auto& key : tail) {
+            bloom.add(key.hash);
+        }
+    }
+}
+
+/**
+ * @brief Сопоставление отсортированного пакета с отсортированными ключами истории
+ */
+std::vector<bool> DedupIndex::findDuplicates(
+    const std::vector<std::shared_ptr<Transactions::Transaction>>& batch) const {
+    std::vector<Key> batchKeys;
+    batchKeys.reserve(batch.size());
+    for (const auto& trans : batch) {
+        batchKeys.push_back(keyOf(*trans));
+    }
+    // Равные ключи остаются в порядке файла: дубликатами считаются первые из них
+    std::vector<std::size_t> order(batch.size());
+    std::iota(order.begin(), order.end(), std::size_t(0));
+    std::stable_sort(order.begin(), order.end(),
+                     [&](std::size_t a, std::size_t b) { return batchKeys[a] < batchKeys[b]; });
+
+    std::vector<bool> duplicate(batch.size(), false);
+    auto pos = keys.begin();
+    for (std::size_t g = 0; g < order.size();) {
+        const Key& key = batchKeys[order[g]];
+        std::size_t groupEnd = g + 1;
+        while (groupEnd < order.size() && batchKeys[order[groupEnd]] == key) {
+            ++groupEnd;
+        }
+        if (bloom.mayContain(key.hash)) {
+            pos = std::lower_bound(pos, keys.end(), key);
+            std::size_t matches = 0;
+            while (pos != keys.end() && *pos == key) {
+                ++matches;
+                ++pos;
+            }
+            for (std::size_t i = g; i < groupEnd && i - g < matches; ++i) {
+                duplicate[order[i]] = true;
+            }
+        }
+        g = groupEnd;
+    }
+    return duplicate;
+}
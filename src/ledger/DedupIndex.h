@@ -0,0 +1,73 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <vector>
+#include "../utils/BloomFilter.h"
+
+class User;
+namespace Transactions { class Transaction; }
+
+/**
+ * @brief Индекс содержимого истории пользователя для отсева повторного импорта
+ *
+ * Ключ транзакции — время с точностью до секунды и 64-битный хеш содержимого
+ * (contentHash: дата, сумма в копейках, счет, описание без учета регистра
+ * и лишних пробелов). В индекс входят и транзакции холодного архива
+ * пользователя (User::archiveBefore). Ключи истории хранятся отсортированными по времени,
+ * перед ними стоит блочный фильтр Блума.
+ *
+ * Пакет импорта сортируется по ключам; строки, которых заведомо нет в фильтре,
+ * считаются новыми без обращения к индексу, остальные находятся слиянием
+ * с отсортированными ключами (поиск продвигается только вперед). Одинаковые
+ * строки сопоставляются с историей по количеству: если в истории две
+ * одинаковые покупки, а в выписке три, новой считается одна.
+ *
+ * Индекс догоняет историю лениво (sync): если в историю только дописывали,
+ * ключи хвоста сливаются с индексом за время, пропорциональное хвосту и
+ * перекрытию по датам; после отмены или архивации индекс строится заново.
+ */
+class DedupIndex {
+public:
+    struct Key {
+        std::int64_t seconds;
+        std::uint64_t hash;
+
+        bool operator<(const Key& other) const {
+            return seconds != other.seconds ? seconds < other.seconds : hash < other.hash;
+        }
+        bool operator==(const Key& other) const { return seconds == other.seconds && hash == other.hash; }
+    };
+
+    static Key keyOf(const Transactions::Transaction& trans);
+
+    /**
+     * @brief Приводит индекс к текущей истории пользователя
+     */
+    void sync(const User& user);
+    /**
+     * @brief Находит в пакете транзакции, уже присутствующие в истории
+     * @param batch Транзакции пакета в порядке файла
+     * @return duplicate[i] — batch[i] повторяет транзакцию истории
+     */
+    std::vector<bool> findDuplicates(const std::vector<std::shared_ptr<Transactions::Transaction>>& batch) const;
+
+    std::size_t size() const { return keys.size(); }
+    std::size_t getMemoryBytes() const { return keys.capacity() * sizeof(Key) + bloom.getMemoryBytes(); }
+
+private:
+    std::vector<Key> keys;  // по возрастанию (seconds, hash), то есть по времени
+    BloomFilter bloom;
+    std::uint64_t version = 0;     // версия истории, по которой построен индекс
+    std::size_t synced = 0;        // сколько транзакций истории учтено
+    bool built = false;
+
+    void rebuild(const User& user);
+    void append(const User& user);
+};
+
+/**
+ * @brief Хеш содержимого транзакции: дата (секунды), сумма в копейках,
+ *        название счета и описание без учета регистра и повторных пробелов
+ */
+std::uint64_t contentHash(const Transactions::Transaction& trans);
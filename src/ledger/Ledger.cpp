@@ -0,0 +1,901 @@
+/**
+ * @file Ledger.cpp
+ * @brief Загрузка журнала и импорт транзакций из текстовых файлов
+ */
+
+#include "Ledger.h"
+#include <algorithm>
+#include <charconv>
+#include <cstdio>
+#include <filesystem>
+#include <fstream>
+#include <iterator>
+#include "../metrics/Metrics.h"
+#include "../rules/Categorizer.h"
+#include "../utils/DateUtils.h"
+#include "../utils/Utils.h"
+
+namespace {
+
+bool parseDouble(const std::string& text, double& value) {
+    try {
+        std::size_t pos = 0;
+        value = std::stod(text, &pos);
+        return pos == text.size();
+    } catch (...) {
+        return false;
+    }
+}
+
+// Кратчайшая запись, которая читается обратно в то же значение
+std::string exactNumber(double value) {
+    char buffer[32];
+    auto result = std::to_chars(buffer, buffer + sizeof(buffer), value);
+    return std::string(buffer, result.ptr);
+}
+
+const char* accountType(const Account& account) {
+    if (dynamic_cast<const CreditAccount*>(&account)) {
+        return "Credit";
+    }
+    return dynamic_cast<const SavingsAccount*>(&account) ? "Savings" : "Debit";
+}
+
+const char* categoryType(const Category& category) {
+    if (dynamic_cast<const ExpenseCategory*>(&category)) {
+        return "Expense";
+    }
+    return dynamic_cast<const IncomeCategory*>(&category) ? "Income" : "Other";
+}
+
+} // namespace
+
+/**
+ * @brief Возвращает пользователя, создавая его при необходимости
+ * @param name Имя пользователя
+ */
+std::shared_ptr<User> Ledger::getOrCreateUser(const std::string& name) {
+    auto it = userIndex.find(name);
+    if (it != userIndex.end()) {
+        return access(it->second);
+    }
+    std::size_t index = users.size();
+    userIndex.emplace(name, index);
+    users.push_back(std::make_shared<User>(name));
+    residency.emplace_back();
+    residency.back().lru = lru.insert(lru.begin(), index);
+    for (auto* obs : observers) {
+        obs->onUserAdded(*users.back());
+    }
+    return access(index);
+}
+
+/**
+ * @brief Обращение к пользователю: подгрузка с диска, учет давности и памяти
+ */
+std::shared_ptr<User> Ledger::access(std::size_t index) {
+    if (!users[index]) {
+        reload(index);
+    }
+    touch(index);
+    // Копия удерживает пользователя, так что проверка ниже его не выгрузит
+    std::shared_ptr<User> user = users[index];
+    if (readDepth == 0) {
+        maybeEvict();
+    }
+    return user;
+}
+
+/**
+ * @brief Переносит пользователя в начало списка давности и обновляет оценку его памяти
+ *
+ * Во время чтения файла пользователь только помечается: оценка пересчитывается
+ * по окончании чтения.
+ */
+void Ledger::touch(std::size_t index) {
+    Residency& slot = residency[index];
+    lru.splice(lru.begin(), lru, slot.lru);
+    if (readDepth > 0) {
+        if (!slot.dirty) {
+            slot.dirty = true;
+            dirtyUsers.push_back(index);
+        }
+        return;
+    }
+    slot.lastAccess = Clock::now();
+    UserMemory memory = getMemoryUsage(*users[index]);
+    residentBytes = residentBytes - slot.memory.total() + memory.total();
+    slot.memory = memory;
+    peakBytes = std::max(peakBytes, residentBytes);
+}
+
+/**
+ * @brief Проход вытеснения при выходе за предел памяти и не чаще раза в idleAfter / 2 по простою
+ */
+void Ledger::maybeEvict() {
+    if (evictionDirectory.empty()) {
+        return;
+    }
+    bool overBudget = memoryBudget && residentBytes > memoryBudget;
+    bool idleCheck = idleAfter != Clock::duration::zero() && Clock::now() - lastEvictionPass >= idleAfter / 2;
+    if (overBudget || idleCheck) {
+        evictIdle();
+    }
+}
+
+/**
+ * @brief Включает выгрузку пользователей на диск
+ */
+bool Ledger::enableEviction(const std::string& directory, std::size_t budgetBytes, std::chrono::seconds idleAfterSeconds) {
+    std::error_code ec;
+    std::filesystem::create_directories(directory, ec);
+    if (ec) {
+        lastError = "cannot create " + directory + ": " + ec.message();
+        return false;
+    }
+    evictionDirectory = directory;
+    memoryBudget = budgetBytes;
+    idleAfter = idleAfterSeconds;
+    return true;
+}
+
+std::string Ledger::spillPath(std::size_t index) const {
+    return (std::filesystem::path(evictionDirectory) / ("user-" + std::to_string(index) + ".ledger")).string();
+}
+
+/**
+ * @brief Проход от давно не запрашиваемых пользователей к недавним
+ *
+ * Проход останавливается на первом пользователе, который не простаивает,
+ * если предел памяти соблюден. Удерживаемые извне пользователи пропускаются.
+ */
+std::size_t Ledger::evictIdle() {
+    if (evictionDirectory.empty()) {
+        return 0;
+    }
+    auto now = Clock::now();
+    lastEvictionPass = now;
+    std::size_t evicted = 0;
+    auto it = lru.end();
+    while (it != lru.begin()) {
+        auto current = std::prev(it);
+        std::size_t index = *current;
+        bool idle = idleAfter != Clock::duration::zero() && now - residency[index].lastAccess >= idleAfter;
+        bool overBudget = memoryBudget && residentBytes > memoryBudget;
+        if (!idle && !overBudget) {
+            break;
+        }
+        if (evict(index)) {
+            ++evicted;  // current удален из списка, it по-прежнему указывает на более недавнего
+        } else {
+            it = current;
+        }
+    }
+    return evicted;
+}
+
+/**
+ * @brief Записывает пользователя в файл каталога вытеснения и освобождает его
+ */
+bool Ledger::evict(std::size_t index) {
+    Residency& slot = residency[index];
+    const auto& user = users[index];
+    if (slot.pinned || user.use_count() != 1) {
+        return false;
+    }
+    for (const auto& acc : user->getAccounts()) {
+        if (acc->getHeld() != 0.0) {
+            return false;
+        }
+    }
+
+    std::string path = spillPath(index);
+    std::string coldPath = path + ".cold";
+    {
+        std::ofstream file(path, std::ios::binary | std::ios::trunc);
+        bool ok = file && writeUser(file, *user) && file.flush();
+        if (ok && user->getArchive().size() > 0) {
+            ok = user->getArchive().saveToFile(coldPath);
+        } else {
+            std::remove(coldPath.c_str());  // не подхватить архив прежней выгрузки
+        }
+        if (!ok) {
+            file.close();
+            std::remove(path.c_str());
+            std::remove(coldPath.c_str());
+            return false;
+        }
+    }
+
+    for (auto* obs : observers) {
+        obs->onUserEvicted(*user);
+    }
+    residentBytes -= slot.memory.total();
+    slot.memory = UserMemory{};
+    slot.evictedName = user->getName();
+    slot.evictedTransactions = user->getTransactions().size();
+    lru.erase(slot.lru);
+    dedupIndexes.erase(user.get());
+    users[index].reset();
+    ++evictedUsers;
+    ++evictions;
+    METRICS_INC(UsersEvicted);
+    return true;
+}
+
+/**
+ * @brief Подгружает выгруженного пользователя из его файла
+ *
+ * Наблюдатели получают только onUserReloaded, без событий построчного чтения.
+ * При ошибке чтения пользователь остается с прочитанной частью, текст ошибки —
+ * в lastError, а файл сохраняется.
+ */
+void Ledger::reload(std::size_t index) {
+    Residency& slot = residency[index];
+    std::string path = spillPath(index);
+    users[index] = std::make_shared<User>(slot.evictedName);
+    slot.lru = lru.insert(lru.begin(), index);
+
+    // Для наблюдателей пользователь не менялся
+    std::vector<LedgerObserver*> muted;
+    muted.swap(observers);
+    bool ok = readFile(path, false);
+    observers.swap(muted);
+    // Архив читается до onUserReloaded: наблюдатели видят пользователя целиком
+    std::string coldPath = path + ".cold";
+    bool hasArchive = ok && std::filesystem::exists(coldPath);
+    if (hasArchive) {
+        Storage::ColdStore archive;
+        ok = archive.loadFromFile(coldPath);
+        if (ok) {
+            users[index]->restoreArchive(std::move(archive));
+        } else {
+            lastError = archive.getLastError();
+        }
+    }
+    for (auto* obs : observers) {
+        obs->onUserReloaded(*users[index]);
+    }
+
+    --evictedUsers;
+    if (!ok) {
+        // Файл остается единственной полной копией: пользователь больше не выгружается
+        lastError = "cannot reload user " + slot.evictedName + ": " + lastError;
+        slot.pinned = true;
+        return;
+    }
+    std::remove(path.c_str());
+    if (hasArchive) {
+        std::remove(coldPath.c_str());
+    }
+    slot.evictedName.clear();
+    slot.evictedTransactions = 0;
+    ++reloads;
+    METRICS_INC(UsersReloaded);
+}
+
+/**
+ * @brief Подписывает наблюдателя на изменения журнала
+ */
+void Ledger::addObserver(LedgerObserver* obs) {
+    if (obs && std::find(observers.begin(), observers.end(), obs) == observers.end()) {
+        observers.push_back(obs);
+    }
+}
+
+/**
+ * @brief Отписывает наблюдателя
+ */
+void Ledger::removeObserver(LedgerObserver* obs) {
+    observers.erase(std::remove(observers.begin(), observers.end(), obs), observers.end());
+}
+
+/**
+ * @brief Добавляет счет пользователю и уведомляет наблюдателя
+ */
+void Ledger::addAccount(User& user, std::shared_ptr<Account> account) {
+    user.addAccount(account);
+    for (auto* obs : observers) {
+        obs->onAccountAdded(user, *account);
+    }
+}
+
+/**
+ * @brief Добавляет категорию пользователю и уведомляет наблюдателя
+ */
+void Ledger::addCategory(User& user, std::shared_ptr<Category> category) {
+    user.addCategory(category);
+    for (auto* obs : observers) {
+        obs->onCategoryAdded(user, *category);
+    }
+}
+
+/**
+ * @brief Ищет пользователя по имени
+ * @param name Имя пользователя
+ * @return Указатель на пользователя или nullptr
+ */
+std::shared_ptr<User> Ledger::findUser(const std::string& name) {
+    auto it = userIndex.find(name);
+    if (it == userIndex.end()) {
+        return nullptr;
+    }
+    return access(it->second);
+}
+
+/**
+ * @brief Все пользователи с подгрузкой выгруженных
+ */
+const std::vector<std::shared_ptr<User>>& Ledger::getUsers() {
+    if (evictedUsers > 0) {
+        // Без прохода вытеснения: подгруженные не должны выгружаться до возврата
+        for (std::size_t i = 0; i < users.size(); ++i) {
+            if (!users[i]) {
+                reload(i);
+                touch(i);
+            }
+        }
+    }
+    return users;
+}
+
+/**
+ * @brief Обход пользователей с подгрузкой по одному
+ */
+void Ledger::forEachUser(const std::function<void(const std::shared_ptr<User>&)>& fn) {
+    for (std::size_t i = 0; i < users.size(); ++i) {
+        // access выгружает лишних до вызова fn: в памяти остаются предыдущие,
+        // пока укладываются в предел, и текущий
+        auto user = access(i);
+        fn(user);
+        if (users[i]) {
+            touch(i);
+        }
+    }
+    if (readDepth == 0) {
+        maybeEvict();
+    }
+}
+
+/**
+ * @brief Имена пользователей, выгруженных — по записи о размещении
+ */
+std::vector<std::string> Ledger::getUserNames() const {
+    std::vector<std::string> names;
+    names.reserve(users.size());
+    for (std::size_t i = 0; i < users.size(); ++i) {
+        names.push_back(users[i] ? users[i]->getName() : residency[i].evictedName);
+    }
+    return names;
+}
+
+/**
+ * @brief Общее число транзакций всех пользователей
+ */
+std::size_t Ledger::getTransactionCount() const {
+    std::size_t total = 0;
+    for (std::size_t i = 0; i < users.size(); ++i) {
+        total += users[i] ? users[i]->getTransactions().size() : residency[i].evictedTransactions;
+    }
+    return total;
+}
+
+UserMemory Ledger::getMemoryUsage(const User& user) const {
+    UserMemory memory = user.getMemoryUsage();
+    auto it = dedupIndexes.find(&user);
+    if (it != dedupIndexes.end()) {
+        memory.caches += it->second.getMemoryBytes();
+    }
+    return memory;
+}
+
+/**
+ * @brief Пересчитывает оценку по всем пользователям в памяти
+ */
+Ledger::MemoryStats Ledger::getMemoryStats() const {
+    MemoryStats stats;
+    for (const auto& user : users) {
+        if (user) {
+            ++stats.residentUsers;
+            stats.resident += getMemoryUsage(*user);
+        }
+    }
+    peakBytes = std::max(peakBytes, stats.resident.total());
+    stats.evictedUsers = evictedUsers;
+    stats.peakBytes = peakBytes;
+    stats.evictions = evictions;
+    stats.reloads = reloads;
+    return stats;
+}
+
+/**
+ * @brief Пишет записи user, account, category и transaction одного пользователя
+ *
+ * Даты транзакций записываются с точностью до секунды.
+ */
+bool Ledger::writeUser(std::ostream& os, const User& user) {
+    const std::string name = quoteCsvField(user.getName());
+    os << "user," << name << "\n";
+
+    for (const auto& acc : user.getAccounts()) {
+        if (user.findAccount(acc->getName()) != acc) {
+            return false;
+        }
+        os << "account," << name << "," << accountType(*acc) << "," << quoteCsvField(acc->getName()) << ","
+           << exactNumber(acc->getBalance());
+        if (const auto* credit = dynamic_cast<const CreditAccount*>(acc.get())) {
+            os << "," << exactNumber(credit->getCreditLimit());
+        }
+        os << "," << currencyCode(acc->getCurrency()) << "," << exactNumber(acc->getOpeningBalance()) << "\n";
+    }
+
+    // Родитель пишется раньше дочерних, остальные категории — в исходном порядке
+    const auto& categories = user.getCategories();
+    std::vector<bool> written(categories.size(), false);
+    std::unordered_set<const Category*> declared;
+    for (std::size_t remaining = categories.size(); remaining > 0;) {
+        std::size_t before = remaining;
+        for (std::size_t i = 0; i < categories.size(); ++i) {
+            const Category& cat = *categories[i];
+            const auto& parent = cat.getParent();
+            if (written[i] || (parent && !declared.count(parent.get()))) {
+                continue;
+            }
+            if (user.findCategory(cat.getName()) != categories[i]) {
+                return false;
+            }
+            os << "category," << name << "," << categoryType(cat) << "," << quoteCsvField(cat.getName()) << ",";
+            if (dynamic_cast<const ExpenseCategory*>(&cat)) {
+                os << exactNumber(cat.getBudgetLimit());
+            }
+            os << "," << (parent ? quoteCsvField(parent->getName()) : std::string()) << "\n";
+            written[i] = true;
+            declared.insert(&cat);
+            --remaining;
+        }
+        if (remaining == before) {
+            return false;  // родитель не принадлежит пользователю
+        }
+    }
+
+    for (const auto& trans : user.getTransactions()) {
+        const auto& account = trans->getAccount();
+        const auto& category = trans->getCategory();
+        if (!account || user.findAccount(account->getName()) != account ||
+            (category && user.findCategory(category->getName()) != category) ||
+            trans->getCurrency() != account->getCurrency() ||
+            trans->getDescription().find('\n') != std::string::npos) {
+            return false;
+        }
+        std::string type = trans->getType();
+        double amount = type == "WITHDRAWAL" ? -trans->getAmount() : trans->getAmount();
+        os << "transaction," << name << "," << type << "," << quoteCsvField(account->getName()) << ","
+           << (category ? quoteCsvField(category->getName()) : std::string()) << "," << exactNumber(amount) << ","
+           << quoteCsvField(trans->getDescription()) << "," << DateUtils::formatTimePoint(trans->getDate());
+        if (const auto* compounding = dynamic_cast<const Transactions::CompoundingTransaction*>(trans.get())) {
+            os << "," << compounding->getPeriod() << "," << exactNumber(compounding->getInterestRate());
+        }
+        os << "\n";
+    }
+    return static_cast<bool>(os);
+}
+
+/**
+ * @brief Разбор одной записи журнала
+ * @param line Строка файла
+ * @param applyToAccounts Проводить ли суммы транзакций по счетам
+ * @return false при ошибке (текст в lastError)
+ */
+bool Ledger::parseLine(const std::string& line, bool applyToAccounts) {
+    auto fields = splitCsvLine(line);
+    const std::string& kind = fields[0];
+    if (fields.size() < 2) {
+        lastError = "missing user field";
+        return false;
+    }
+    auto user = getOrCreateUser(fields[1]);
+
+    if (kind == "user") {
+        return true;
+    }
+
+    if (kind == "account") {
+        double balance = 0.0;
+        if (fields.size() < 5 || !parseDouble(fields[4], balance)) {
+            lastError = "account: expected type, name and balance";
+            return false;
+        }
+        const std::string& type = fields[2];
+        std::size_t currencyField = type == "Credit" ? 6 : 5;
+        Currency currency = Currency::RUB;
+        if (fields.size() > currencyField && !fields[currencyField].empty()
+            && !parseCurrency(fields[currencyField], currency)) {
+            lastError = "account: unknown currency " + fields[currencyField];
+            return false;
+        }
+        double opening = 0.0;
+        bool hasOpening = fields.size() > currencyField + 1 && !fields[currencyField + 1].empty();
+        if (hasOpening && !parseDouble(fields[currencyField + 1], opening)) {
+            lastError = "account: invalid opening balance " + fields[currencyField + 1];
+            return false;
+        }
+
+        std::shared_ptr<Account> account;
+        if (type == "Debit") {
+            account = std::make_shared<DebitAccount>(fields[3], balance, currency);
+        } else if (type == "Credit") {
+            double limit = 0.0;
+            if (fields.size() < 6 || !parseDouble(fields[5], limit)) {
+                lastError = "account: credit account requires a limit";
+                return false;
+            }
+            account = std::make_shared<CreditAccount>(fields[3], balance, limit, currency);
+        } else if (type == "Savings") {
+            account = std::make_shared<SavingsAccount>(fields[3], balance, currency);
+        } else {
+            lastError = "account: unknown type " + type;
+            return false;
+        }
+        if (hasOpening) {
+            account->setOpeningBalance(opening);
+            fixedOpenings.insert(account.get());
+        }
+        addAccount(*user, account);
+        return true;
+    }
+
+    if (kind == "category") {
+        if (fields.size() < 4) {
+            lastError = "category: expected type and name";
+            return false;
+        }
+        std::shared_ptr<Category> parent;
+        if (fields.size() >= 6 && !fields[5].empty()) {
+            parent = user->findCategory(fields[5]);
+            if (!parent) {
+                lastError = "category: unknown parent " + fields[5];
+                return false;
+            }
+        }
+        const std::string& type = fields[2];
+        std::shared_ptr<Category> category;
+        if (type == "Expense") {
+            double budget = 0.0;
+            if (fields.size() >= 5 && !fields[4].empty() && !parseDouble(fields[4], budget)) {
+                lastError = "category: invalid budget";
+                return false;
+            }
+            category = std::make_shared<ExpenseCategory>(fields[3], budget);
+        } else if (type == "Income") {
+            category = std::make_shared<IncomeCategory>(fields[3]);
+        } else if (type == "Other") {
+            category = std::make_shared<Category>(fields[3]);
+        } else {
+            lastError = "category: unknown type " + type;
+            return false;
+        }
+        category->setParent(parent);
+        addCategory(*user, category);
+        return true;
+    }
+
+    if (kind == "transaction") {
+        double amount = 0.0;
+        if (fields.size() < 7 || !parseDouble(fields[5], amount)) {
+            lastError = "transaction: expected type, account, category, amount and description";
+            return false;
+        }
+        auto account = user->findAccount(fields[3]);
+        if (!account) {
+            lastError = "transaction: unknown account " + fields[3];
+            return false;
+        }
+        auto category = fields[4].empty() ? nullptr : user->findCategory(fields[4]);
+        if (!fields[4].empty() && !category) {
+            lastError = "transaction: unknown category " + fields[4];
+            return false;
+        }
+        if (!category && applyToAccounts && categorizer) {
+            double signedAmount = fields[2] == "WITHDRAWAL" ? -amount : amount;
+            category = categorizer->classify(*user, fields[6], signedAmount, fields[3]);
+        }
+
+        std::shared_ptr<Transactions::Transaction> trans;
+        const std::string& type = fields[2];
+        if (type == "DEPOSIT") {
+            trans = std::make_shared<Transactions::DepositTransaction>(amount, fields[6], category, account);
+        } else if (type == "WITHDRAWAL") {
+            trans = std::make_shared<Transactions::WithdrawalTransaction>(amount, fields[6], category, account);
+        } else if (type == "COMPOUNDING") {
+            double rate = 0.0;
+            if (fields.size() < 10 || !parseDouble(fields[9], rate)) {
+                lastError = "transaction: compounding requires period and rate";
+                return false;
+            }
+            int period = std::atoi(fields[8].c_str());
+            trans = std::make_shared<Transactions::CompoundingTransaction>(
+                amount, fields[6], period, rate, category, account);
+        } else {
+            lastError = "transaction: unknown type " + type;
+            return false;
+        }
+
+        if (fields.size() >= 8 && !fields[7].empty()) {
+            std::chrono::system_clock::time_point date;
+            if (!DateUtils::parseTimePoint(fields[7], date)) {
+                lastError = "transaction: invalid date " + fields[7];
+                return false;
+            }
+            trans->setDate(date);
+        }
+
+        // Баланс счета в журнале уже включает историю, поэтому историческая
+        // транзакция сдвигает начальный баланс, а импортируемая — текущий
+        if (!applyToAccounts) {
+            if (!fixedOpenings.count(account.get())) {
+                account->setOpeningBalance(account->getOpeningBalance() - trans->getAmount());
+            }
+            user->addTransaction(trans);
+            for (auto* obs : observers) {
+                obs->onTransactionAdded(*user, trans);
+            }
+        } else if (dedupImports) {
+            pendingImport.emplace_back(user, std::move(trans));
+        } else {
+            postImported(*user, std::move(trans));
+        }
+        return true;
+    }
+
+    lastError = "unknown record kind " + kind;
+    return false;
+}
+
+/**
+ * @brief Проводка импортированной транзакции с уведомлением наблюдателей
+ *
+ * Отклоненное счетом списание не проводится и только учитывается в importRejected.
+ */
+void Ledger::postImported(User& user, std::shared_ptr<Transactions::Transaction> trans) {
+    if (!user.post(trans)) {
+        ++importRejected;
+        return;
+    }
+    for (auto* obs : observers) {
+        obs->onBalanceChanged(user, *trans->getAccount());
+    }
+    for (auto* obs : observers) {
+        obs->onTransactionAdded(user, trans);
+    }
+}
+
+/**
+ * @brief Отсев дубликатов и проводка прочитанного файла импорта
+ *
+ * Пакет каждого пользователя сверяется с индексом его истории; новые
+ * транзакции проводятся в порядке дат (при равных датах — в порядке файла).
+ */
+void Ledger::commitImport() {
+    std::vector<std::shared_ptr<User>> order;
+    std::unordered_map<const User*, std::vector<std::shared_ptr<Transactions::Transaction>>> batches;
+    for (auto& [user, trans] : pendingImport) {
+        auto& batch = batches[user.get()];
+        if (batch.empty()) {
+            order.push_back(user);
+        }
+        batch.push_back(std::move(trans));
+    }
+    pendingImport.clear();
+
+    for (const auto& user : order) {
+        auto& batch = batches[user.get()];
+        DedupIndex& index = dedupIndexes[user.get()];
+        index.sync(*user);
+        std::vector<bool> duplicate = index.findDuplicates(batch);
+
+        std::vector<std::shared_ptr<Transactions::Transaction>> fresh;
+        fresh.reserve(batch.size());
+        for (std::size_t i = 0; i < batch.size(); ++i) {
+            if (duplicate[i]) {
+                ++importDuplicates;
+            } else {
+                fresh.push_back(std::move(batch[i]));
+            }
+        }
+        std::stable_sort(fresh.begin(), fresh.end(),
+                         [](const auto& a, const auto& b) { return a->getDate() < b->getDate(); });
+        for (auto& trans : fresh) {
+            postImported(*user, std::move(trans));
+        }
+    }
+    METRICS_ADD(ImportDuplicates, importDuplicates);
+}
+
+/**
+ * @brief Чтение файла журнала; по окончании внешнего чтения пересчитывается память
+ */
+bool Ledger::readFile(const std::string& path, bool applyToAccounts) {
+    ++readDepth;
+    bool ok = readLines(path, applyToAccounts);
+    if (--readDepth == 0) {
+        fixedOpenings.clear();
+        for (std::size_t index : dirtyUsers) {
+            residency[index].dirty = false;
+            if (users[index]) {
+                touch(index);
+            }
+        }
+        dirtyUsers.clear();
+    }
+    return ok;
+}
+
+/**
+ * @brief Построчное чтение файла журнала
+ */
+bool Ledger::readLines(const std::string& path, bool applyToAccounts) {
+    std::ifstream file(path);
+    if (!file.is_open()) {
+        lastError = "cannot open " + path;
+        return false;
+    }
+
+    // Контрольные точки для отката импорта при ошибке; у новых пользователей — 0
+    std::vector<std::uint64_t> checkpoints;
+    if (applyToAccounts) {
+        for (const auto& user : users) {
+            checkpoints.push_back(user ? user->checkpoint() : 0);
+        }
+    }
+
+    std::string line;
+    std::size_t lineNo = 0;
+    while (std::getline(file, line)) {
+        ++lineNo;
+        if (line.empty() || line[0] == '#' || line == "\r") {
+            continue;
+        }
+        if (!parseLine(line, applyToAccounts)) {
+            lastError = path + ":" + std::to_string(lineNo) + ": " + lastError;
+            if (applyToAccounts) {
+                pendingImport.clear();
+                rollbackImport(checkpoints);
+            }
+            return false;
+        }
+    }
+    if (applyToAccounts) {
+        commitImport();
+    }
+    return true;
+}
+
+/**
+ * @brief Откатывает проводки незавершенного импорта по журналам команд пользователей
+ *
+ * Пользователи, счета и категории, объявленные в файле, остаются.
+ */
+void Ledger::rollbackImport(const std::vector<std::uint64_t>& checkpoints) {
+    bool complete = true;
+    for (std::size_t i = 0; i < users.size(); ++i) {
+        if (!users[i]) {
+            continue;
+        }
+        User& user = *users[i];
+        std::uint64_t point = i < checkpoints.size() ? checkpoints[i] : 0;
+        if (user.checkpoint() == point) {
+            continue;
+        }
+        // Откатываемые транзакции — хвост истории, не больше одной на операцию журнала
+        const auto& history = user.getTransactions();
+        std::size_t before = history.size();
+        std::size_t tail = std::min<std::size_t>(before, user.checkpoint() - point);
+        std::vector<std::shared_ptr<Transactions::Transaction>> removed(history.end() - tail, history.end());
+        if (!user.rollbackTo(point)) {
+            complete = false;
+            continue;
+        }
+        for (std::size_t t = tail - (before - history.size()); t < tail; ++t) {
+            for (auto* obs : observers) {
+                obs->onTransactionRemoved(user, *removed[t]);
+            }
+        }
+        for (auto* obs : observers) {
+            for (const auto& acc : user.getAccounts()) {
+                obs->onBalanceChanged(user, *acc);
+            }
+        }
+    }
+    lastError += complete ? " (import rolled back)" : " (import partially applied: history too deep to roll back)";
+}
+
+/**
+ * @brief Отмена операции пользователя с уведомлением наблюдателей
+ */
+bool Ledger::undo(User& user) {
+    const auto& history = user.getTransactions();
+    std::size_t before = history.size();
+    std::shared_ptr<Transactions::Transaction> last = before > 0 ? history.back() : nullptr;
+    if (!user.undo()) {
+        return false;
+    }
+    for (auto* obs : observers) {
+        if (history.size() < before) {
+            obs->onTransactionRemoved(user, *last);
+        }
+        for (const auto& acc : user.getAccounts()) {
+            obs->onBalanceChanged(user, *acc);
+        }
+    }
+    touchUser(user);
+    return true;
+}
+
+/**
+ * @brief Архивация истории пользователя с уведомлением наблюдателей
+ */
+std::size_t Ledger::archiveBefore(User& user, std::chrono::system_clock::time_point cutoff) {
+    std::size_t moved = user.archiveBefore(cutoff);
+    if (moved == 0) {
+        return 0;
+    }
+    for (auto* obs : observers) {
+        obs->onTransactionsArchived(user, cutoff);
+    }
+    touchUser(user);
+    return moved;
+}
+
+/**
+ * @brief Повтор операции пользователя с уведомлением наблюдателей
+ */
+bool Ledger::redo(User& user) {
+    const auto& history = user.getTransactions();
+    std::size_t before = history.size();
+    if (!user.redo()) {
+        return false;
+    }
+    for (auto* obs : observers) {
+        if (history.size() > before) {
+            obs->onTransactionAdded(user, history.back());
+        }
+        for (const auto& acc : user.getAccounts()) {
+            obs->onBalanceChanged(user, *acc);
+        }
+    }
+    touchUser(user);
+    return true;
+}
+
+/**
+ * @brief Обновляет давность и оценку памяти пользователя журнала после изменения
+ */
+void Ledger::touchUser(const User& user) {
+    auto it = userIndex.find(user.getName());
+    if (it != userIndex.end() && users[it->second].get() == &user) {
+        touch(it->second);
+    }
+}
+
+/**
+ * @brief Загружает журнал; транзакции считаются историей
+ * @param path Путь к файлу
+ */
+bool Ledger::loadFile(const std::string& path) {
+    bool ok = readFile(path, false);
+    // Посреди файла никто не выгружается: откат импорта опирается на журналы команд
+    maybeEvict();
+    return ok;
+}
+
+/**
+ * @brief Импортирует новые записи с проводкой по счетам
+ * @param path Путь к файлу
+ */
+bool Ledger::importFile(const std::string& path) {
+    importDuplicates = 0;
+    importRejected = 0;
+    bool ok = readFile(path, true);
+    maybeEvict();
+    return ok;
+}
@@ -0,0 +1,288 @@
+#pragma once
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <iosfwd>
+#include <list>
+#include <memory>
+#include <string>
+#include <unordered_map>
+#include <unordered_set>
+#include <vector>
+#include "../users/User.h"
+#include "DedupIndex.h"
+
+namespace Rules { class Categorizer; }
+
+/**
+ * @brief Наблюдатель за изменениями журнала (например, для записи журнала изменений)
+ */
+class LedgerObserver {
+public:
+    virtual ~LedgerObserver() = default;
+    virtual void onUserAdded(const User& user) = 0;
+    virtual void onAccountAdded(const User& user, const Account& account) = 0;
+    virtual void onCategoryAdded(const User& user, const Category& category) = 0;
+    virtual void onBalanceChanged(const User& user, const Account& account) = 0;
+    virtual void onTransactionAdded(const User&, const std::shared_ptr<Transactions::Transaction>&) {}
+    virtual void onTransactionRemoved(const User&, const Transactions::Transaction&) {}
+    // Транзакции старше cutoff перенесены из истории в архив (Ledger::archiveBefore)
+    virtual void onTransactionsArchived(const User&, std::chrono::system_clock::time_point) {}
+    // Вытеснение (Ledger::enableEviction): перед выгрузкой пользователя и после
+    // подгрузки; подгруженный пользователь, его счета и транзакции — новые объекты
+    virtual void onUserEvicted(const User&) {}
+    virtual void onUserReloaded(const User&) {}
+};
+
+/**
+ * @brief Журнал: набор пользователей с их счетами, категориями и историей
+ *
+ * Загружается из текстового файла построчно (CSV, первое поле — вид записи):
+ *
+ *     user,<user>
+ *     account,<user>,Debit|Savings,<name>,<balance>[,<currency>[,<opening>]]
+ *     account,<user>,Credit,<name>,<balance>,<creditLimit>[,<currency>[,<opening>]]
+ *     category,<user>,Expense|Income|Other,<name>[,<budget>[,<parent>]]
+ *     transaction,<user>,DEPOSIT|WITHDRAWAL|COMPOUNDING,<account>,<category>,<amount>,"<description>"[,<date>[,<period>,<rate>]]
+ *
+ * Родительская категория должна быть объявлена раньше дочерней.
+ * Пустые строки и строки, начинающиеся с '#', пропускаются.
+ * Сумма транзакции указывается положительной, знак определяется типом,
+ * валюта транзакции — валюта счета. Валюта счета по умолчанию — RUB.
+ * Начальный баланс <opening>, если указан, задается явно и историей
+ * не сдвигается.
+ *
+ * Память пользователей оценивается по UserMemory. С enableEviction
+ * пользователи, к которым давно не обращались или которые выходят за
+ * предел памяти (в порядке давности обращения), выгружаются в каталог
+ * в этом же формате и подгружаются обратно при findUser, getOrCreateUser,
+ * forEachUser или getUsers. Холодный архив пользователя (User::archiveBefore)
+ * выгружается рядом, в файл с суффиксом .cold. Журнал команд (undo/redo)
+ * при выгрузке не сохраняется.
+ * Пользователь, на которого есть ссылки вне журнала (shared_ptr из
+ * findUser или getUsers), или с активными холдами не выгружается.
+ * Поэтому findUser, getUsers и forEachUser не const: они подгружают
+ * и выгружают пользователей. Журнал не синхронизирован — его методы
+ * вызываются из одного потока (в HttpServer — из цикла событий), другие
+ * потоки работают только с полученными shared_ptr на пользователей.
+ */
+class Ledger {
+public:
+    /**
+     * @brief Память пользователей журнала
+     */
+    struct MemoryStats {
+        std::size_t residentUsers = 0;
+        std::size_t evictedUsers = 0;
+        UserMemory resident;          // текущая оценка по пользователям в памяти
+        std::size_t peakBytes = 0;    // наибольшая оценка за время работы
+        std::size_t evictions = 0;
+        std::size_t reloads = 0;
+    };
+
+private:
+    using Clock = std::chrono::steady_clock;
+
+    // Размещение пользователя: место в списке давности обращений и оценка памяти
+    struct Residency {
+        std::list<std::size_t>::iterator lru;
+        Clock::time_point lastAccess;
+        UserMemory memory;                  // учтенная в residentBytes оценка
+        std::string evictedName;            // имя выгруженного пользователя
+        std::size_t evictedTransactions = 0;
+        bool pinned = false;                // не выгружать: файл не удалось прочитать обратно
+        bool dirty = false;                 // затронут во время чтения файла, оценка устарела
+    };
+
+    std::vector<std::shared_ptr<User>> users;
+    std::unordered_map<std::string, std::size_t> userIndex;
+    std::string lastError;
+    std::vector<LedgerObserver*> observers;
+    const Rules::Categorizer* categorizer = nullptr;
+
+    // Отсев повторно импортированных транзакций
+    bool dedupImports = true;
+    std::unordered_map<const User*, DedupIndex> dedupIndexes;
+    // Транзакции читаемого файла импорта, ждущие отсева дубликатов
+    std::vector<std::pair<std::shared_ptr<User>, std::shared_ptr<Transactions::Transaction>>> pendingImport;
+    std::size_t importDuplicates = 0;
+    std::size_t importRejected = 0;         // списания, отклоненные счетом при проводке
+
+    // Учет памяти и вытеснение; users[i] == nullptr — пользователь выгружен
+    std::vector<Residency> residency;       // по номерам пользователей
+    std::list<std::size_t> lru;             // резидентные, недавние в начале
+    std::string evictionDirectory;          // пусто — вытеснение выключено
+    std::size_t memoryBudget = 0;
+    Clock::duration idleAfter{};
+    std::size_t residentBytes = 0;
+    mutable std::size_t peakBytes = 0;
+    std::size_t evictedUsers = 0;
+    std::size_t evictions = 0;
+    std::size_t reloads = 0;
+    Clock::time_point lastEvictionPass;
+    int readDepth = 0;                      // вложенность readFile: подгрузка во время чтения
+    std::vector<std::size_t> dirtyUsers;    // затронутые во время чтения
+    std::unordered_set<const Account*> fixedOpenings; // счета с явным начальным балансом
+
+    bool parseLine(const std::string& line, bool applyToAccounts);
+    bool readFile(const std::string& path, bool applyToAccounts);
+    bool readLines(const std::string& path, bool applyToAccounts);
+    void rollbackImport(const std::vector<std::uint64_t>& checkpoints);
+    void postImported(User& user, std::shared_ptr<Transactions::Transaction> trans);
+    void commitImport();
+
+    std::shared_ptr<User> access(std::size_t index);
+    void touch(std::size_t index);
+    void touchUser(const User& user);
+    void maybeEvict();
+    void reload(std::size_t index);
+    bool evict(std::size_t index);
+    std::string spillPath(std::size_t index) const;
+
+public:
+    /**
+     * @brief Загружает журнал; транзакции считаются историей и балансы не меняют
+     *
+     * Баланс счета в файле — текущий, уже включающий историю: начальный
+     * баланс счета (getOpeningBalance) уменьшается на суммы исторических транзакций.
+     * @param path Путь к файлу
+     * @return true если файл прочитан без ошибок
+     */
+    bool loadFile(const std::string& path);
+    /**
+     * @brief Импортирует новые записи; суммы транзакций проводятся по счетам
+     *
+     * Проводки идут через журнал команд пользователя (User::post). По умолчанию
+     * транзакции файла сначала читаются целиком: повторяющие историю
+     * пользователя (DedupIndex) отбрасываются, остальные проводятся в порядке
+     * дат; при ошибке разбора не проводится ни одна. Без отсева строки
+     * проводятся по мере чтения, а при ошибке уже проведенные откатываются,
+     * если укладываются в глубину журнала.
+     * @param path Путь к файлу
+     * @return true если файл прочитан без ошибок
+     */
+    bool importFile(const std::string& path);
+    /**
+     * @brief Отбрасывать ли при импорте транзакции, уже присутствующие в истории
+     */
+    void setImportDedup(bool enabled) { dedupImports = enabled; }
+    /**
+     * @brief Сколько транзакций отброшено как дубликаты последним importFile
+     */
+    std::size_t getImportDuplicates() const { return importDuplicates; }
+    /**
+     * @brief Сколько списаний последнего importFile отклонено счетом (нехватка средств)
+     *
+     * Такие строки не проводятся и в историю не попадают.
+     */
+    std::size_t getImportRejected() const { return importRejected; }
+
+    /**
+     * @brief Возвращает пользователя, создавая его при необходимости
+     */
+    std::shared_ptr<User> getOrCreateUser(const std::string& name);
+    /**
+     * @brief Добавление счета/категории с уведомлением наблюдателя
+     */
+    void addAccount(User& user, std::shared_ptr<Account> account);
+    void addCategory(User& user, std::shared_ptr<Category> category);
+
+    /**
+     * @brief Правила для импортируемых транзакций без категории (nullptr — не назначать)
+     */
+    void setCategorizer(const Rules::Categorizer* rules) { categorizer = rules; }
+    /**
+     * @brief Подписка наблюдателей на изменения
+     */
+    void addObserver(LedgerObserver* obs);
+    void removeObserver(LedgerObserver* obs);
+    std::shared_ptr<User> findUser(const std::string& name);
+    /**
+     * @brief Отменяет последнюю операцию журнала команд пользователя
+     *
+     * Наблюдатели получают onTransactionRemoved для снятой транзакции
+     * и onBalanceChanged по счетам пользователя, как при откате импорта.
+     * @return false если отменять нечего
+     */
+    bool undo(User& user);
+    /**
+     * @brief Повторяет последнюю отмененную операцию пользователя
+     *
+     * Наблюдатели получают onTransactionAdded и onBalanceChanged.
+     * @return false если повторять нечего
+     */
+    bool redo(User& user);
+    /**
+     * @brief Переносит транзакции пользователя старше cutoff в его холодный архив
+     *
+     * Наблюдатели получают onTransactionsArchived. Отчеты по диапазону дат
+     * добирают итоги архива через Report::addArchive.
+     * @return Число перенесенных транзакций
+     */
+    std::size_t archiveBefore(User& user, std::chrono::system_clock::time_point cutoff);
+    /**
+     * @brief Все пользователи; выгруженные предварительно подгружаются
+     *
+     * С вытеснением подгружает всех сразу и выходит за предел памяти;
+     * для обхода всех пользователей — forEachUser.
+     */
+    const std::vector<std::shared_ptr<User>>& getUsers();
+    /**
+     * @brief Обходит пользователей по одному в порядке добавления
+     *
+     * Выгруженный пользователь подгружается на время вызова fn; после него
+     * пользователь снова может быть выгружен, поэтому память держит только
+     * укладывающихся в предел. Сохраненный fn указатель удерживает
+     * пользователя от выгрузки.
+     */
+    void forEachUser(const std::function<void(const std::shared_ptr<User>&)>& fn);
+    /**
+     * @brief Имена всех пользователей в порядке добавления (без подгрузки)
+     */
+    std::vector<std::string> getUserNames() const;
+    std::size_t getUserCount() const { return users.size(); }
+    /**
+     * @brief Число транзакций всех пользователей, включая выгруженных (без подгрузки)
+     */
+    std::size_t getTransactionCount() const;
+
+    /**
+     * @brief Включает выгрузку пользователей в каталог directory
+     * @param budgetBytes Предел оценки памяти пользователей в памяти (0 — без предела)
+     * @param idleAfter Выгружать не запрашиваемых дольше этого (0 — только по пределу)
+     * @return false если каталог не удалось создать
+     */
+    bool enableEviction(const std::string& directory, std::size_t budgetBytes, std::chrono::seconds idleAfter);
+    /**
+     * @brief Выгружает простаивающих пользователей и тех, кто выходит за предел памяти
+     *
+     * Вызывается и сам при обращениях к пользователям и после loadFile
+     * и importFile: при выходе за предел и не чаще раза в idleAfter / 2 по простою.
+     * @return Число выгруженных пользователей
+     */
+    std::size_t evictIdle();
+    /**
+     * @brief Оценка памяти пользователя вместе с индексами журнала
+     */
+    UserMemory getMemoryUsage(const User& user) const;
+    /**
+     * @brief Текущая и пиковая память пользователей
+     *
+     * Оценка пересчитывается по всем пользователям в памяти: O(пользователей
+     * и их счетов и категорий).
+     */
+    MemoryStats getMemoryStats() const;
+    /**
+     * @brief Запись пользователя в формате журнала (счета, категории, история)
+     * @return false если пользователя нельзя записать без потерь
+     *         (чужой счет или категория, повтор имени, валюта транзакции не совпадает с валютой счета,
+     *         перевод строки в описании)
+     */
+    static bool writeUser(std::ostream& os, const User& user);
+
+    /**
+     * @brief Текст последней ошибки разбора (с номером строки)
+     */
+    const std::string& getLastError() const { return lastError; }
+};
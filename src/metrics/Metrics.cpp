@@ -0,0 +1,223 @@
+/**
+ * @file Metrics.cpp
+ * @brief Реализация потоковых счётчиков, гистограмм и экспорта в Prometheus
+ */
+
+#include "Metrics.h"
+#include <algorithm>
+#include <atomic>
+#include <fstream>
+#include <iomanip>
+#include <mutex>
+#include <vector>
+
+namespace Metrics {
+
+namespace {
+
+/**
+ * @brief Данные одного потока: пишет только владелец, читает снимок
+ */
+struct ThreadSlot {
+    std::array<std::atomic<std::uint64_t>, COUNTER_COUNT> counters{};
+    struct Histogram {
+        std::atomic<std::uint64_t> count{0};
+        std::atomic<std::uint64_t> sum{0};
+        std::atomic<std::uint64_t> max{0};
+        std::array<std::atomic<std::uint64_t>, HISTOGRAM_BUCKETS> buckets{};
+    };
+    std::array<Histogram, TIMER_COUNT> timers{};
+};
+
+// Единственный писатель: load+store дешевле, чем fetch_add с блокировкой шины
+inline void bump(std::atomic<std::uint64_t>& cell, std::uint64_t delta) {
+    cell.store(cell.load(std::memory_order_relaxed) + delta, std::memory_order_relaxed);
+}
+
+void accumulate(Snapshot& snap, const ThreadSlot& slot) {
+    for (std::size_t i = 0; i < COUNTER_COUNT; ++i) {
+        snap.counters[i] += slot.counters[i].load(std::memory_order_relaxed);
+    }
+    for (std::size_t t = 0; t < TIMER_COUNT; ++t) {
+        const auto& src = slot.timers[t];
+        auto& dst = snap.timers[t];
+        dst.count += src.count.load(std::memory_order_relaxed);
+        dst.sumNanos += src.sum.load(std::memory_order_relaxed);
+        dst.maxNanos = std::max(dst.maxNanos, src.max.load(std::memory_order_relaxed));
+        for (std::size_t b = 0; b < HISTOGRAM_BUCKETS; ++b) {
+            dst.buckets[b] += src.buckets[b].load(std::memory_order_relaxed);
+        }
+    }
+}
+
+/**
+ * @brief Реестр потоков; мьютекс берётся только при старте/завершении потока и в snapshot()
+ */
+struct Registry {
+    std::mutex mutex;
+    std::vector<ThreadSlot*> live;
+    Snapshot retired;
+};
+
+Registry& registry() {
+    // Намеренно не разрушается: потоки могут завершаться после статических деструкторов
+    static Registry* instance = new Registry;
+    return *instance;
+}
+
+struct SlotOwner {
+    ThreadSlot* slot;
+
+    SlotOwner() : slot(new ThreadSlot) {
+        auto& reg = registry();
+        std::lock_guard<std::mutex> lock(reg.mutex);
+        reg.live.push_back(slot);
+    }
+    ~SlotOwner() {
+        auto& reg = registry();
+        std::lock_guard<std::mutex> lock(reg.mutex);
+        accumulate(reg.retired, *slot);
+        reg.live.erase(std::find(reg.live.begin(), reg.live.end(), slot));
+        delete slot;
+    }
+};
+
+ThreadSlot& localSlot() {
+    thread_local SlotOwner owner;
+    return *owner.slot;
+}
+
+const double PROMETHEUS_BUCKETS_SECONDS[] = {
+    1e-6, 2.5e-6, 5e-6, 1e-5, 2.5e-5, 5e-5, 1e-4, 2.5e-4, 5e-4,
+    1e-3, 2.5e-3, 5e-3, 1e-2, 2.5e-2, 5e-2, 0.1, 0.25, 0.5, 1.0, 2.5, 5.0, 10.0
+};
+
+} // namespace
+
+std::size_t bucketIndex(std::uint64_t value) {
+    if (value < SUB_BUCKETS) {
+        return static_cast<std::size_t>(value);
+    }
+    unsigned msb = 63 - static_cast<unsigned>(__builtin_clzll(value));
+    unsigned shift = msb - SUB_BUCKET_BITS;
+    std::size_t sub = static_cast<std::size_t>(value >> shift) - SUB_BUCKETS;
+    return (shift + 1) * SUB_BUCKETS + sub;
+}
+
+std::uint64_t bucketUpperBound(std::size_t index) {
+    if (index < SUB_BUCKETS) {
+        return index;
+    }
+    unsigned shift = static_cast<unsigned>(index / SUB_BUCKETS - 1);
+    std::uint64_t lower = static_cast<std::uint64_t>(SUB_BUCKETS + index % SUB_BUCKETS) << shift;
+    return lower + ((std::uint64_t(1) << shift) - 1);
+}
+
+std::uint64_t HistogramSnapshot::quantile(double q) const {
+    if (count == 0) return 0;
+    q = std::clamp(q, 0.0, 1.0);
+    auto target = static_cast<std::uint64_t>(q * static_cast<double>(count));
+    if (target == 0) target = 1;
+
+    std::uint64_t cumulative = 0;
+    for (std::size_t b = 0; b < HISTOGRAM_BUCKETS; ++b) {
+        cumulative += buckets[b];
+        if (cumulative >= target) {
+            return std::min(bucketUpperBound(b), maxNanos);
+        }
+    }
+    return maxNanos;
+}
+
+std::string counterName(Counter c) {
+    switch (c) {
+        case Counter::TransactionExecuted: return "finance_transaction_executed_total";
+        case Counter::TransactionUndone: return "finance_transaction_undone_total";
+        case Counter::AccountDeposits: return "finance_account_deposits_total";
+        case Counter::AccountWithdrawals: return "finance_account_withdrawals_total";
+        case Counter::AccountWithdrawalsRejected: return "finance_account_withdrawals_rejected_total";
+        case Counter::ReportAggregations: return "finance_report_aggregations_total";
+        case Counter::ReportExports: return "finance_report_exports_total";
+        case Counter::ReportExportRows: return "finance_report_export_rows_total";
+        case Counter::ReportCacheHits: return "finance_report_cache_hits_total";
+        case Counter::ReportCacheAppends: return "finance_report_cache_appends_total";
+        case Counter::ReportCacheMisses: return "finance_report_cache_misses_total";
+        case Counter::ImportDuplicates: return "finance_import_duplicates_total";
+        case Counter::UsersEvicted: return "finance_users_evicted_total";
+        case Counter::UsersReloaded: return "finance_users_reloaded_total";
+        default: return "finance_unknown_total";
+    }
+}
+
+std::string timerName(Timer t) {
+    switch (t) {
+        case Timer::TransactionExecute: return "finance_transaction_execute_seconds";
+        case Timer::TransactionUndo: return "finance_transaction_undo_seconds";
+        case Timer::ReportAggregate: return "finance_report_aggregate_seconds";
+        case Timer::ReportExport: return "finance_report_export_seconds";
+        default: return "finance_unknown_seconds";
+    }
+}
+
+void increment(Counter c, std::uint64_t delta) {
+    bump(localSlot().counters[static_cast<std::size_t>(c)], delta);
+}
+
+void record(Timer t, std::uint64_t nanos) {
+    auto& h = localSlot().timers[static_cast<std::size_t>(t)];
+    bump(h.count, 1);
+    bump(h.sum, nanos);
+    if (nanos > h.max.load(std::memory_order_relaxed)) {
+        h.max.store(nanos, std::memory_order_relaxed);
+    }
+    bump(h.buckets[bucketIndex(nanos)], 1);
+}
+
+Snapshot snapshot() {
+    auto& reg = registry();
+    std::lock_guard<std::mutex> lock(reg.mutex);
+    Snapshot snap = reg.retired;
+    for (const ThreadSlot* slot : reg.live) {
+        accumulate(snap, *slot);
+    }
+    return snap;
+}
+
+void writePrometheus(std::ostream& os, const Snapshot& snap) {
+    for (std::size_t i = 0; i < COUNTER_COUNT; ++i) {
+        std::string name = counterName(static_cast<Counter>(i));
+        os << "# TYPE " << name << " counter\n";
+        os << name << " " << snap.counters[i] << "\n";
+    }
+
+    for (std::size_t t = 0; t < TIMER_COUNT; ++t) {
+        std::string name = timerName(static_cast<Timer>(t));
+        const auto& h = snap.timers[t];
+        os << "# TYPE " << name << " histogram\n";
+
+        std::size_t b = 0;
+        std::uint64_t cumulative = 0;
+        for (double le : PROMETHEUS_BUCKETS_SECONDS) {
+            auto limit = static_cast<std::uint64_t>(le * 1e9);
+            while (b < HISTOGRAM_BUCKETS && bucketUpperBound(b) <= limit) {
+                cumulative += h.buckets[b++];
+            }
+            os << name << "_bucket{le=\"" << le << "\"} " << cumulative << "\n";
+        }
+        os << name << "_bucket{le=\"+Inf\"} " << h.count << "\n";
+        os << name << "_sum " << std::setprecision(9) << static_cast<double>(h.sumNanos) / 1e9
+           << std::setprecision(6) << "\n";
+        os << name << "_count " << h.count << "\n";
+    }
+}
+
+bool dumpPrometheus(const std::string& filename) {
+    std::ofstream file(filename);
+    if (!file.is_open()) {
+        return false;
+    }
+    writePrometheus(file, snapshot());
+    return static_cast<bool>(file);
+}
+
+} // namespace Metrics
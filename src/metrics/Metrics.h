@@ -0,0 +1,148 @@
+#pragma once
+#include <array>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <iostream>
+#include <string>
+
+/**
+ * @brief Встроенные метрики горячих путей
+ *
+ * Каждый поток пишет в собственный набор счётчиков и гистограмм
+ * (единственный писатель, атомики с relaxed-порядком, без блокировок).
+ * Снимок суммирует данные всех потоков. Гистограммы задержек —
+ * логарифмически-линейные (в стиле HDR): 8 подкорзин на каждую степень двойки,
+ * относительная погрешность не более 12.5%.
+ *
+ * Сборка с -DFINANCE_METRICS_DISABLED полностью убирает инструментацию:
+ * макросы METRICS_* раскрываются в пустоту.
+ */
+namespace Metrics {
+
+enum class Counter : std::size_t {
+    TransactionExecuted,
+    TransactionUndone,
+    AccountDeposits,
+    AccountWithdrawals,
+    AccountWithdrawalsRejected,
+    ReportAggregations,
+    ReportExports,
+    ReportExportRows,
+    ReportCacheHits,
+    ReportCacheAppends,
+    ReportCacheMisses,
+    ImportDuplicates,
+    UsersEvicted,
+    UsersReloaded,
+    COUNT
+};
+
+enum class Timer : std::size_t {
+    TransactionExecute,
+    TransactionUndo,
+    ReportAggregate,
+    ReportExport,
+    COUNT
+};
+
+constexpr std::size_t COUNTER_COUNT = static_cast<std::size_t>(Counter::COUNT);
+constexpr std::size_t TIMER_COUNT = static_cast<std::size_t>(Timer::COUNT);
+
+// Подкорзины внутри одной степени двойки
+constexpr unsigned SUB_BUCKET_BITS = 3;
+constexpr std::size_t SUB_BUCKETS = std::size_t(1) << SUB_BUCKET_BITS;
+constexpr std::size_t HISTOGRAM_BUCKETS = (64 - SUB_BUCKET_BITS + 1) * SUB_BUCKETS;
+
+/**
+ * @brief Номер корзины для значения в наносекундах
+ */
+std::size_t bucketIndex(std::uint64_t value);
+/**
+ * @brief Верхняя граница корзины (включительно) в наносекундах
+ */
+std::uint64_t bucketUpperBound(std::size_t index);
+
+/**
+ * @brief Снимок одной гистограммы задержек
+ */
+struct HistogramSnapshot {
+    std::uint64_t count = 0;
+    std::uint64_t sumNanos = 0;
+    std::uint64_t maxNanos = 0;
+    std::array<std::uint64_t, HISTOGRAM_BUCKETS> buckets{};
+
+    /**
+     * @brief Приближённый квантиль задержки
+     * @param q Уровень квантиля в диапазоне [0, 1]
+     * @return Задержка в наносекундах
+     */
+    std::uint64_t quantile(double q) const;
+    double meanNanos() const { return count ? static_cast<double>(sumNanos) / count : 0.0; }
+};
+
+/**
+ * @brief Снимок всех метрик процесса
+ */
+struct Snapshot {
+    std::array<std::uint64_t, COUNTER_COUNT> counters{};
+    std::array<HistogramSnapshot, TIMER_COUNT> timers{};
+
+    std::uint64_t get(Counter c) const { return counters[static_cast<std::size_t>(c)]; }
+    const HistogramSnapshot& get(Timer t) const { return timers[static_cast<std::size_t>(t)]; }
+};
+
+std::string counterName(Counter c);
+std::string timerName(Timer t);
+
+void increment(Counter c, std::uint64_t delta = 1);
+void record(Timer t, std::uint64_t nanos);
+
+/**
+ * @brief Собирает данные всех живых и завершившихся потоков
+ */
+Snapshot snapshot();
+
+/**
+ * @brief Вывод снимка в текстовом формате Prometheus
+ */
+void writePrometheus(std::ostream& os, const Snapshot& snap);
+/**
+ * @brief Сохраняет текущий снимок в файл в формате Prometheus
+ * @return true если файл записан
+ */
+bool dumpPrometheus(const std::string& filename);
+
+/**
+ * @brief RAII-замер длительности участка кода
+ */
+class ScopedTimer {
+    Timer timer;
+    std::chrono::steady_clock::time_point start;
+
+public:
+    explicit ScopedTimer(Timer t) : timer(t), start(std::chrono::steady_clock::now()) {}
+    ~ScopedTimer() {
+        auto elapsed = std::chrono::steady_clock::now() - start;
+        record(timer, static_cast<std::uint64_t>(
+            std::chrono::duration_cast<std::chrono::nanoseconds>(elapsed).count()));
+    }
+    ScopedTimer(const ScopedTimer&) = delete;
+    ScopedTimer& operator=(const ScopedTimer&) = delete;
+};
+
+} // namespace Metrics
+
+#define METRICS_CONCAT_INNER(a, b) a##b
+#define METRICS_CONCAT(a, b) METRICS_CONCAT_INNER(a, b)
+
+#ifdef FINANCE_METRICS_DISABLED
+#define METRICS_INC(counter) ((void)0)
+#define METRICS_ADD(counter, delta) ((void)0)
+#define METRICS_TIMER(timer) ((void)0)
+#else
+#define METRICS_INC(counter) ::Metrics::increment(::Metrics::Counter::counter)
+#define METRICS_ADD(counter, delta) ::Metrics::increment(::Metrics::Counter::counter, (delta))
+#define METRICS_TIMER(timer) \
+    ::Metrics::ScopedTimer METRICS_CONCAT(metricsTimer_, __LINE__)(::Metrics::Timer::timer)
+#endif
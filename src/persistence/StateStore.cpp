@@ -0,0 +1,754 @@
+/**
+ * @file StateStore.cpp
+ * @brief Снимки состояния, журнал изменений и восстановление после перезапуска
+ */
+
+#include "StateStore.h"
+#include <algorithm>
+#include <cerrno>
+#include <cstring>
+#include <filesystem>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+namespace Persistence {
+
+namespace {
+
+constexpr char SNAPSHOT_MAGIC[8] = {'F', 'T', 'S', 'N', 'A', 'P', '0', '3'};
+// Снимки первой версии — без истории транзакций, второй — без холодного архива
+constexpr char SNAPSHOT_MAGIC_V1[8] = {'F', 'T', 'S', 'N', 'A', 'P', '0', '1'};
+constexpr char SNAPSHOT_MAGIC_V2[8] = {'F', 'T', 'S', 'N', 'A', 'P', '0', '2'};
+constexpr std::size_t FLUSH_THRESHOLD = 64 * 1024;
+
+enum RecordKind : std::uint8_t {
+    RECORD_USER = 1,
+    RECORD_ACCOUNT = 2,
+    RECORD_CATEGORY = 3,
+    RECORD_BALANCE = 4,
+    RECORD_TRANSACTION = 5,
+    RECORD_TRANSACTION_REMOVED = 6,  // снята последняя транзакция истории
+    RECORD_ARCHIVE = 7               // история до границы перенесена в архив
+};
+
+// Числа пишутся в нативном порядке байт: файлы не переносятся между архитектурами
+template<typename T>
+void put(std::string& out, T value) {
+    out.append(reinterpret_cast<const char*>(&value), sizeof(T));
+}
+
+void putString(std::string& out, const std::string& s) {
+    put<std::uint32_t>(out, static_cast<std::uint32_t>(s.size()));
+    out.append(s);
+}
+
+/**
+ * @brief Чтение с контролем границ; при выходе за буфер ok становится false
+ */
+struct Reader {
+    const char* pos;
+    const char* end;
+    bool ok = true;
+
+    template<typename T>
+    T get() {
+        T value{};
+        if (static_cast<std::size_t>(end - pos) < sizeof(T)) {
+            ok = false;
+            return value;
+        }
+        std::memcpy(&value, pos, sizeof(T));
+        pos += sizeof(T);
+        return value;
+    }
+
+    std::string getString() {
+        auto size = get<std::uint32_t>();
+        if (!ok || static_cast<std::size_t>(end - pos) < size) {
+            ok = false;
+            return {};
+        }
+        std::string s(pos, size);
+        pos += size;
+        return s;
+    }
+};
+
+std::uint32_t checksum(const char* data, std::size_t size) {
+    std::uint32_t hash = 2166136261u;
+    for (std::size_t i = 0; i < size; ++i) {
+        hash ^= static_cast<unsigned char>(data[i]);
+        hash *= 16777619u;
+    }
+    return hash;
+}
+
+bool writeAll(int fd, const char* data, std::size_t size) {
+    while (size > 0) {
+        ssize_t written = ::write(fd, data, size);
+        if (written < 0) {
+            if (errno == EINTR) continue;
+            return false;
+        }
+        data += written;
+        size -= static_cast<std::size_t>(written);
+    }
+    return true;
+}
+
+std::shared_ptr<Account> makeAccount(const StateStore::AccountState& a) {
+    auto currency = a.currency < CURRENCY_COUNT ? static_cast<Currency>(a.currency) : Currency::RUB;
+    std::shared_ptr<Account> account;
+    switch (a.type) {
+        case 1: account = std::make_shared<CreditAccount>(a.name, a.balance, a.creditLimit, currency); break;
+        case 2: account = std::make_shared<SavingsAccount>(a.name, a.balance, currency); break;
+        default: account = std::make_shared<DebitAccount>(a.name, a.balance, currency); break;
+    }
+    account->setOpeningBalance(a.opening);
+    return account;
+}
+
+std::shared_ptr<Category> makeCategory(const StateStore::CategoryState& c, const User& user) {
+    std::shared_ptr<Category> category;
+    switch (c.type) {
+        case 1: category = std::make_shared<ExpenseCategory>(c.name, c.budget); break;
+        case 2: category = std::make_shared<IncomeCategory>(c.name); break;
+        default: category = std::make_shared<Category>(c.name); break;
+    }
+    if (!c.parent.empty()) {
+        category->setParent(user.findCategory(c.parent));
+    }
+    return category;
+}
+
+StateStore::AccountState describe(const Account& account) {
+    StateStore::AccountState a{0, static_cast<std::uint8_t>(account.getCurrency()),
+                               account.getBalance(), 0.0, account.getName(), account.getOpeningBalance()};
+    if (auto credit = dynamic_cast<const CreditAccount*>(&account)) {
+        a.type = 1;
+        a.creditLimit = credit->getCreditLimit();
+    } else if (dynamic_cast<const SavingsAccount*>(&account)) {
+        a.type = 2;
+    }
+    return a;
+}
+
+StateStore::CategoryState describe(const Category& category) {
+    StateStore::CategoryState c{0, category.getBudgetLimit(), category.getName(),
+                                category.getParent() ? category.getParent()->getName() : std::string()};
+    std::string type = category.getType();
+    if (type == "ExpenseCategory") c.type = 1;
+    else if (type == "IncomeCategory") c.type = 2;
+    return c;
+}
+
+// Старший бит типа счета: следом за именем записан начальный баланс.
+// В записях прежнего формата он равен текущему
+constexpr std::uint8_t ACCOUNT_HAS_OPENING = 0x80;
+
+void putAccount(std::string& out, const StateStore::AccountState& a) {
+    put<std::uint8_t>(out, a.type | ACCOUNT_HAS_OPENING);
+    put<std::uint8_t>(out, a.currency);
+    put<double>(out, a.balance);
+    put<double>(out, a.creditLimit);
+    putString(out, a.name);
+    put<double>(out, a.opening);
+}
+
+StateStore::AccountState readAccount(Reader& r) {
+    StateStore::AccountState a{};
+    a.type = r.get<std::uint8_t>();
+    a.currency = r.get<std::uint8_t>();
+    a.balance = r.get<double>();
+    a.creditLimit = r.get<double>();
+    a.name = r.getString();
+    a.opening = a.balance;
+    if (a.type & ACCOUNT_HAS_OPENING) {
+        a.type &= ~ACCOUNT_HAS_OPENING;
+        a.opening = r.get<double>();
+    }
+    return a;
+}
+
+// Старший бит типа: следом за именем записано имя родителя. Записи без
+// родителя совпадают с прежним форматом
+constexpr std::uint8_t CATEGORY_HAS_PARENT = 0x80;
+
+void putCategory(std::string& out, const StateStore::CategoryState& c) {
+    put<std::uint8_t>(out, c.parent.empty() ? c.type : c.type | CATEGORY_HAS_PARENT);
+    put<double>(out, c.budget);
+    putString(out, c.name);
+    if (!c.parent.empty()) {
+        putString(out, c.parent);
+    }
+}
+
+StateStore::CategoryState readCategory(Reader& r) {
+    StateStore::CategoryState c{};
+    c.type = r.get<std::uint8_t>();
+    c.budget = r.get<double>();
+    c.name = r.getString();
+    if (c.type & CATEGORY_HAS_PARENT) {
+        c.type &= ~CATEGORY_HAS_PARENT;
+        c.parent = r.getString();
+    }
+    return c;
+}
+
+// Вид транзакции в записи; суммы хранятся со знаком, как getAmount
+enum TransactionKind : std::uint8_t {
+    TRANSACTION_DEPOSIT = 0,
+    TRANSACTION_WITHDRAWAL = 1,
+    TRANSACTION_COMPOUNDING = 2
+};
+
+void putTransaction(std::string& out, const Transactions::Transaction& t) {
+    auto compounding = dynamic_cast<const Transactions::CompoundingTransaction*>(&t);
+    std::uint8_t kind = compounding ? TRANSACTION_COMPOUNDING
+        : dynamic_cast<const Transactions::WithdrawalTransaction*>(&t) ? TRANSACTION_WITHDRAWAL
+        : TRANSACTION_DEPOSIT;
+    put<std::uint8_t>(out, kind);
+    put<std::uint8_t>(out, static_cast<std::uint8_t>(t.getCurrency()));
+    put<double>(out, t.getAmount());
+    put<std::int64_t>(out, static_cast<std::int64_t>(t.getDate().time_since_epoch().count()));
+    putString(out, t.getAccount() ? t.getAccount()->getName() : std::string());
+    putString(out, t.getCategory() ? t.getCategory()->getName() : std::string());
+    putString(out, t.getDescription());
+    if (compounding) {
+        put<std::int32_t>(out, compounding->getPeriod());
+        put<double>(out, compounding->getInterestRate());
+    }
+}
+
+/**
+ * @brief Транзакция истории пользователя user; nullptr — запись повреждена или счета нет
+ */
+std::shared_ptr<Transactions::Transaction> readTransaction(Reader& r, const User& user) {
+    auto kind = r.get<std::uint8_t>();
+    auto currency = r.get<std::uint8_t>();
+    auto amount = r.get<double>();
+    auto ticks = r.get<std::int64_t>();
+    auto account = user.findAccount(r.getString());
+    auto categoryName = r.getString();
+    auto description = r.getString();
+    std::int32_t period = 0;
+    double rate = 0.0;
+    if (kind == TRANSACTION_COMPOUNDING) {
+        period = r.get<std::int32_t>();
+        rate = r.get<double>();
+    }
+    if (!r.ok || !account) {
+        return nullptr;
+    }
+
+    auto category = categoryName.empty() ? nullptr : user.findCategory(categoryName);
+    std::shared_ptr<Transactions::Transaction> trans;
+    switch (kind) {
+        case TRANSACTION_WITHDRAWAL:
+            trans = std::make_shared<Transactions::WithdrawalTransaction>(-amount, description, category, account);
+            break;
+        case TRANSACTION_COMPOUNDING:
+            trans = std::make_shared<Transactions::CompoundingTransaction>(amount, description, period, rate,
+                                                                           category, account);
+            break;
+        default:
+            trans = std::make_shared<Transactions::DepositTransaction>(amount, description, category, account);
+            break;
+    }
+    if (currency < CURRENCY_COUNT) {
+        trans->setCurrency(static_cast<Currency>(currency));
+    }
+    trans->setDate(std::chrono::system_clock::time_point(std::chrono::system_clock::duration(ticks)));
+    return trans;
+}
+
+/**
+ * @brief Номер первой записи из имени delta.<seq>.log (0 — не журнал)
+ */
+std::uint64_t logStartSeq(const std::filesystem::path& path) {
+    std::string name = path.filename().string();
+    if (name.size() < 11 || name.compare(0, 6, "delta.") != 0
+        || name.compare(name.size() - 4, 4, ".log") != 0) {
+        return 0;
+    }
+    try {
+        return std::stoull(name.substr(6, name.size() - 10));
+    } catch (...) {
+        return 0;
+    }
+}
+
+} // namespace
+
+StateStore::StateStore(const std::string& dir) : directory(dir) {}
+
+StateStore::~StateStore() {
+    waitForSnapshot();
+    std::lock_guard<std::mutex> lock(mutex);
+    flushLocked();
+    if (logFd >= 0) {
+        ::close(logFd);
+    }
+}
+
+std::vector<StateStore::UserState> StateStore::capture(Ledger& ledger) {
+    std::vector<UserState> state;
+    state.reserve(ledger.getUserCount());
+    ledger.forEachUser([&](const std::shared_ptr<User>& user) {
+        UserState u;
+        u.name = user->getName();
+        for (const auto& acc : user->getAccounts()) {
+            u.accounts.push_back(describe(*acc));
+        }
+        for (const auto& cat : user->getCategories()) {
+            u.categories.push_back(describe(*cat));
+        }
+        const auto& history = user->getTransactions();
+        u.transactions.assign(history.begin(), history.end());
+        if (user->getArchive().size() > 0) {
+            user->getArchive().encode(u.archive);
+        }
+        state.push_back(std::move(u));
+    });
+    return state;
+}
+
+void StateStore::append(std::uint8_t kind, const std::string& fields) {
+    std::lock_guard<std::mutex> lock(mutex);
+    if (logFd < 0) return;
+
+    std::string payload;
+    payload.reserve(fields.size() + 9);
+    put<std::uint8_t>(payload, kind);
+    put<std::uint64_t>(payload, nextSeq++);
+    payload += fields;
+
+    put<std::uint32_t>(buffer, static_cast<std::uint32_t>(payload.size()));
+    put<std::uint32_t>(buffer, checksum(payload.data(), payload.size()));
+    buffer += payload;
+    ++recordsSinceSnapshot;
+
+    if (buffer.size() >= FLUSH_THRESHOLD) {
+        flushLocked();
+    }
+}
+
+bool StateStore::flushLocked() {
+    if (logFd < 0 || buffer.empty()) return true;
+    bool ok = writeAll(logFd, buffer.data(), buffer.size());
+    buffer.clear();
+    if (!ok) {
+        lastError = "cannot write " + currentLog;
+    }
+    return ok;
+}
+
+bool StateStore::flush(bool durable) {
+    std::lock_guard<std::mutex> lock(mutex);
+    bool ok = flushLocked();
+    if (ok && durable && logFd >= 0) {
+        ok = ::fsync(logFd) == 0;
+    }
+    return ok;
+}
+
+std::string StateStore::logPath(std::uint64_t startSeq) const {
+    return (std::filesystem::path(directory) / ("delta." + std::to_string(startSeq) + ".log")).string();
+}
+
+bool StateStore::openLogLocked() {
+    // Файл с таким именем может остаться только без валидных записей
+    // (например, с оборванной первой записью), поэтому он перезаписывается
+    currentLog = logPath(nextSeq);
+    closedLogs.erase(std::remove(closedLogs.begin(), closedLogs.end(), currentLog), closedLogs.end());
+    logFd = ::open(currentLog.c_str(), O_WRONLY | O_CREAT | O_TRUNC | O_APPEND, 0644);
+    if (logFd < 0) {
+        lastError = "cannot open " + currentLog;
+        return false;
+    }
+    return true;
+}
+
+void StateStore::onUserAdded(const User& user) {
+    std::string fields;
+    putString(fields, user.getName());
+    append(RECORD_USER, fields);
+}
+
+void StateStore::onAccountAdded(const User& user, const Account& account) {
+    std::string fields;
+    putString(fields, user.getName());
+    putAccount(fields, describe(account));
+    append(RECORD_ACCOUNT, fields);
+}
+
+void StateStore::onCategoryAdded(const User& user, const Category& category) {
+    std::string fields;
+    putString(fields, user.getName());
+    putCategory(fields, describe(category));
+    append(RECORD_CATEGORY, fields);
+}
+
+void StateStore::onBalanceChanged(const User& user, const Account& account) {
+    std::string fields;
+    putString(fields, user.getName());
+    putString(fields, account.getName());
+    put<double>(fields, account.getBalance());
+    append(RECORD_BALANCE, fields);
+    maybeAutoSnapshot();
+}
+
+void StateStore::onTransactionAdded(const User& user, const std::shared_ptr<Transactions::Transaction>& trans) {
+    // Начальный баланс счета пишется вместе с транзакцией: историческая
+    // транзакция сдвигает его, проведенная — нет
+    std::string fields;
+    putString(fields, user.getName());
+    putTransaction(fields, *trans);
+    put<double>(fields, trans->getAccount() ? trans->getAccount()->getOpeningBalance() : 0.0);
+    append(RECORD_TRANSACTION, fields);
+    maybeAutoSnapshot();
+}
+
+void StateStore::onTransactionRemoved(const User& user, const Transactions::Transaction&) {
+    // Ledger снимает транзакции только с конца истории (отмена и откат импорта)
+    std::string fields;
+    putString(fields, user.getName());
+    append(RECORD_TRANSACTION_REMOVED, fields);
+}
+
+void StateStore::onTransactionsArchived(const User& user, std::chrono::system_clock::time_point cutoff) {
+    // Перенос детерминирован: при проигрывании история режется по той же границе
+    std::string fields;
+    putString(fields, user.getName());
+    put<std::int64_t>(fields, static_cast<std::int64_t>(cutoff.time_since_epoch().count()));
+    append(RECORD_ARCHIVE, fields);
+    maybeAutoSnapshot();
+}
+
+void StateStore::setAutoSnapshot(Ledger* ledger, std::size_t everyRecords) {
+    std::lock_guard<std::mutex> lock(mutex);
+    autoLedger = ledger;
+    autoEvery = everyRecords;
+}
+
+void StateStore::maybeAutoSnapshot() {
+    Ledger* ledger = nullptr;
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        if (!autoLedger || autoEvery == 0 || recordsSinceSnapshot < autoEvery) return;
+        ledger = autoLedger;
+    }
+    snapshot(*ledger, true);
+}
+
+bool StateStore::writeSnapshotFile(const std::vector<UserState>& state, std::uint64_t seq) {
+    std::string body;
+    put<std::uint64_t>(body, seq);
+    put<std::uint32_t>(body, static_cast<std::uint32_t>(state.size()));
+    for (const auto& u : state) {
+        putString(body, u.name);
+        put<std::uint32_t>(body, static_cast<std::uint32_t>(u.accounts.size()));
+        for (const auto& a : u.accounts) putAccount(body, a);
+        put<std::uint32_t>(body, static_cast<std::uint32_t>(u.categories.size()));
+        for (const auto& c : u.categories) putCategory(body, c);
+        put<std::uint32_t>(body, static_cast<std::uint32_t>(u.transactions.size()));
+        for (const auto& t : u.transactions) putTransaction(body, *t);
+        putString(body, u.archive);
+    }
+    std::uint32_t sum = checksum(body.data(), body.size());
+
+    auto finalPath = std::filesystem::path(directory) / "snapshot.bin";
+    auto tmpPath = std::filesystem::path(directory) / "snapshot.bin.tmp";
+    int fd = ::open(tmpPath.c_str(), O_WRONLY | O_CREAT | O_TRUNC, 0644);
+    if (fd < 0) return false;
+
+    bool ok = writeAll(fd, SNAPSHOT_MAGIC, sizeof(SNAPSHOT_MAGIC))
+        && writeAll(fd, body.data(), body.size())
+        && writeAll(fd, reinterpret_cast<const char*>(&sum), sizeof(sum))
+        && ::fsync(fd) == 0;
+    ok = ::close(fd) == 0 && ok;
+
+    std::error_code ec;
+    if (ok) {
+        std::filesystem::rename(tmpPath, finalPath, ec);
+        ok = !ec;
+    }
+    if (!ok) {
+        std::filesystem::remove(tmpPath, ec);
+    }
+    return ok;
+}
+
+bool StateStore::snapshot(Ledger& ledger, bool background) {
+    waitForSnapshot();
+
+    std::vector<UserState> state;
+    std::vector<std::string> obsolete;
+    std::uint64_t seq = 0;
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        if (logFd < 0) {
+            lastError = "state store is not open";
+            return false;
+        }
+        // Переключение на новый журнал: всё, что записано до этого момента, войдёт в снимок.
+        // Если в текущий журнал ещё ничего не записано, он остаётся текущим
+        if (!flushLocked()) return false;
+        if (currentLog != logPath(nextSeq)) {
+            ::close(logFd);
+            logFd = -1;
+            closedLogs.push_back(currentLog);
+            if (!openLogLocked()) return false;
+        }
+
+        seq = nextSeq - 1;
+        state = capture(ledger);
+        obsolete = closedLogs;
+        recordsSinceSnapshot = 0;
+    }
+
+    auto work = [this, state = std::move(state), obsolete = std::move(obsolete), seq]() {
+        bool ok = writeSnapshotFile(state, seq);
+        std::lock_guard<std::mutex> lock(mutex);
+        snapshotFailed = !ok;
+        if (!ok) {
+            lastError = "cannot write snapshot in " + directory;
+            return;
+        }
+        snapshotSeq = seq;
+        for (const auto& path : obsolete) {
+            std::error_code ec;
+            std::filesystem::remove(path, ec);
+            closedLogs.erase(std::remove(closedLogs.begin(), closedLogs.end(), path), closedLogs.end());
+        }
+    };
+
+    if (background) {
+        snapshotThread = std::thread(std::move(work));
+        return true;
+    }
+    work();
+    return waitForSnapshot();
+}
+
+bool StateStore::waitForSnapshot() {
+    if (snapshotThread.joinable()) {
+        snapshotThread.join();
+    }
+    std::lock_guard<std::mutex> lock(mutex);
+    return !snapshotFailed;
+}
+
+bool StateStore::loadSnapshot(Ledger& ledger) {
+    auto path = std::filesystem::path(directory) / "snapshot.bin";
+    int fd = ::open(path.c_str(), O_RDONLY);
+    if (fd < 0) {
+        return errno == ENOENT;
+    }
+
+    struct stat st{};
+    if (::fstat(fd, &st) != 0 || st.st_size < static_cast<off_t>(sizeof(SNAPSHOT_MAGIC) + 16)) {
+        ::close(fd);
+        lastError = "snapshot is truncated";
+        return false;
+    }
+    std::size_t size = static_cast<std::size_t>(st.st_size);
+    void* mapped = ::mmap(nullptr, size, PROT_READ, MAP_PRIVATE, fd, 0);
+    ::close(fd);
+    if (mapped == MAP_FAILED) {
+        lastError = "cannot map snapshot";
+        return false;
+    }
+
+    const char* data = static_cast<const char*>(mapped);
+    const char* body = data + sizeof(SNAPSHOT_MAGIC);
+    std::size_t bodySize = size - sizeof(SNAPSHOT_MAGIC) - sizeof(std::uint32_t);
+    std::uint32_t stored = 0;
+    std::memcpy(&stored, body + bodySize, sizeof(stored));
+
+    bool withArchive = std::memcmp(data, SNAPSHOT_MAGIC, sizeof(SNAPSHOT_MAGIC)) == 0;
+    bool withHistory = withArchive || std::memcmp(data, SNAPSHOT_MAGIC_V2, sizeof(SNAPSHOT_MAGIC_V2)) == 0;
+    bool ok = (withHistory || std::memcmp(data, SNAPSHOT_MAGIC_V1, sizeof(SNAPSHOT_MAGIC_V1)) == 0)
+        && checksum(body, bodySize) == stored;
+    if (ok) {
+        Reader r{body, body + bodySize};
+        snapshotSeq = r.get<std::uint64_t>();
+        auto userCount = r.get<std::uint32_t>();
+        for (std::uint32_t i = 0; r.ok && i < userCount; ++i) {
+            auto user = ledger.getOrCreateUser(r.getString());
+            auto accountCount = r.get<std::uint32_t>();
+            for (std::uint32_t j = 0; r.ok && j < accountCount; ++j) {
+                auto a = readAccount(r);
+                if (r.ok) ledger.addAccount(*user, makeAccount(a));
+            }
+            auto categoryCount = r.get<std::uint32_t>();
+            for (std::uint32_t j = 0; r.ok && j < categoryCount; ++j) {
+                auto c = readCategory(r);
+                if (r.ok) ledger.addCategory(*user, makeCategory(c, *user));
+            }
+            auto transactionCount = withHistory ? r.get<std::uint32_t>() : 0;
+            for (std::uint32_t j = 0; r.ok && j < transactionCount; ++j) {
+                if (auto trans = readTransaction(r, *user)) user->addTransaction(std::move(trans));
+            }
+            auto archive = withArchive ? r.getString() : std::string();
+            if (r.ok && !archive.empty()) {
+                Storage::ColdStore store;
+                if (!store.decode(archive.data(), archive.size())) {
+                    r.ok = false;
+                    break;
+                }
+                user->restoreArchive(std::move(store));
+            }
+        }
+        ok = r.ok;
+    }
+    ::munmap(mapped, size);
+
+    if (!ok) {
+        lastError = "snapshot is corrupted";
+        return false;
+    }
+    restoredSnapshot = true;
+    nextSeq = snapshotSeq + 1;
+    return true;
+}
+
+bool StateStore::applyRecord(std::uint8_t kind, const char* data, std::size_t size, Ledger& ledger) {
+    Reader r{data, data + size};
+    auto user = ledger.getOrCreateUser(r.getString());
+    switch (kind) {
+        case RECORD_USER:
+            break;
+        case RECORD_ACCOUNT: {
+            auto a = readAccount(r);
+            if (r.ok) ledger.addAccount(*user, makeAccount(a));
+            break;
+        }
+        case RECORD_CATEGORY: {
+            auto c = readCategory(r);
+            if (r.ok) ledger.addCategory(*user, makeCategory(c, *user));
+            break;
+        }
+        case RECORD_TRANSACTION: {
+            auto trans = readTransaction(r, *user);
+            auto opening = r.get<double>();
+            if (r.ok && trans) {
+                trans->getAccount()->setOpeningBalance(opening);
+                user->addTransaction(std::move(trans));
+            }
+            break;
+        }
+        case RECORD_TRANSACTION_REMOVED:
+            user->removeLastTransaction();
+            break;
+        case RECORD_ARCHIVE: {
+            auto cutoff = r.get<std::int64_t>();
+            if (r.ok) {
+                user->archiveBefore(std::chrono::system_clock::time_point(
+                    std::chrono::system_clock::duration(cutoff)));
+            }
+            break;
+        }
+        case RECORD_BALANCE: {
+            auto accountName = r.getString();
+            auto balance = r.get<double>();
+            if (r.ok) {
+                if (auto account = user->findAccount(accountName)) {
+                    account->setBalance(balance);
+                }
+            }
+            break;
+        }
+        default:
+            return false;
+    }
+    return r.ok;
+}
+
+bool StateStore::replayLog(const std::string& path, Ledger& ledger) {
+    int fd = ::open(path.c_str(), O_RDONLY);
+    if (fd < 0) {
+        lastError = "cannot open " + path;
+        return false;
+    }
+    struct stat st{};
+    if (::fstat(fd, &st) != 0) {
+        ::close(fd);
+        return false;
+    }
+    std::size_t size = static_cast<std::size_t>(st.st_size);
+    if (size == 0) {
+        ::close(fd);
+        return true;
+    }
+    void* mapped = ::mmap(nullptr, size, PROT_READ, MAP_PRIVATE, fd, 0);
+    ::close(fd);
+    if (mapped == MAP_FAILED) {
+        lastError = "cannot map " + path;
+        return false;
+    }
+
+    Reader r{static_cast<const char*>(mapped), static_cast<const char*>(mapped) + size};
+    while (true) {
+        auto length = r.get<std::uint32_t>();
+        auto sum = r.get<std::uint32_t>();
+        // Оборванная или повреждённая запись — конец журнала после сбоя
+        if (!r.ok || static_cast<std::size_t>(r.end - r.pos) < length || length < 9
+            || checksum(r.pos, length) != sum) {
+            break;
+        }
+        Reader payload{r.pos, r.pos + length};
+        auto kind = payload.get<std::uint8_t>();
+        auto seq = payload.get<std::uint64_t>();
+        r.pos += length;
+
+        if (seq <= snapshotSeq) continue;
+        if (!applyRecord(kind, payload.pos, static_cast<std::size_t>(payload.end - payload.pos), ledger)) {
+            break;
+        }
+        ++replayedRecords;
+        nextSeq = std::max(nextSeq, seq + 1);
+    }
+    ::munmap(mapped, size);
+    return true;
+}
+
+bool StateStore::restore(Ledger& ledger) {
+    std::error_code ec;
+    std::filesystem::create_directories(directory, ec);
+    if (ec) {
+        lastError = "cannot create " + directory;
+        return false;
+    }
+
+    // Во время восстановления изменения не должны попадать обратно в журнал
+    ledger.removeObserver(this);
+    if (!loadSnapshot(ledger)) {
+        return false;
+    }
+
+    std::vector<std::pair<std::uint64_t, std::string>> logs;
+    for (const auto& entry : std::filesystem::directory_iterator(directory, ec)) {
+        if (auto start = logStartSeq(entry.path())) {
+            logs.emplace_back(start, entry.path().string());
+        }
+    }
+    std::sort(logs.begin(), logs.end());
+    for (const auto& [start, path] : logs) {
+        if (!replayLog(path, ledger)) {
+            return false;
+        }
+        closedLogs.push_back(path);
+    }
+
+    std::lock_guard<std::mutex> lock(mutex);
+    if (!openLogLocked()) {
+        return false;
+    }
+    ledger.addObserver(this);
+    return true;
+}
+
+} // namespace Persistence
@@ -0,0 +1,157 @@
+#pragma once
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+#include "../ledger/Ledger.h"
+
+namespace Persistence {
+
+/**
+ * @brief Хранилище состояния пользователей: снимок + журнал изменений
+ *
+ * В каталоге хранятся компактный бинарный снимок (snapshot.bin) со счетами,
+ * категориями, балансами и историей транзакций всех пользователей и журналы изменений
+ * delta.<seq>.log с записями после снимка. Каждая запись имеет сквозной
+ * номер и контрольную сумму; оборванный хвост журнала при восстановлении
+ * отбрасывается.
+ *
+ * Перезапуск: снимок отображается в память (mmap) и разбирается, затем
+ * проигрываются записи журналов с номерами больше номера снимка.
+ *
+ * История нужна после перезапуска отсеву дубликатов импорта (DedupIndex),
+ * отчетам, поиску и прогнозу: журнал пишет добавление и снятие транзакций
+ * и границы архивации (Ledger::archiveBefore), снимок — историю целиком
+ * и холодный архив в его сжатом виде.
+ *
+ * Снимок делается копированием компактного состояния в вызывающем потоке
+ * (счета и категории, от транзакций — только указатели, архив — готовыми
+ * сжатыми блоками), после чего
+ * сериализация и fsync идут в фоновом потоке, а новые изменения уже пишутся
+ * в следующий журнал. Транзакции истории после добавления не меняются,
+ * поэтому читаются фоновым потоком без блокировки.
+ */
+class StateStore : public LedgerObserver {
+public:
+    struct AccountState {
+        std::uint8_t type;     // 0 — Debit, 1 — Credit, 2 — Savings
+        std::uint8_t currency;
+        double balance;
+        double creditLimit;
+        std::string name;
+        double opening;        // баланс до первой транзакции истории
+    };
+
+    struct CategoryState {
+        std::uint8_t type;     // 0 — Category, 1 — Expense, 2 — Income
+        double budget;
+        std::string name;
+        std::string parent;    // пусто — корень; пишется, только если задан
+    };
+
+    struct UserState {
+        std::string name;
+        std::vector<AccountState> accounts;
+        std::vector<CategoryState> categories;
+        std::vector<std::shared_ptr<const Transactions::Transaction>> transactions;
+        std::string archive;   // ColdStore::encode; пусто — архива нет
+    };
+
+private:
+    std::string directory;
+    std::string lastError;
+
+    std::mutex mutex;
+    int logFd = -1;
+    std::string currentLog;
+    std::vector<std::string> closedLogs;
+    std::string buffer;
+    std::uint64_t nextSeq = 1;
+    std::uint64_t snapshotSeq = 0;
+    std::size_t recordsSinceSnapshot = 0;
+    std::size_t replayedRecords = 0;
+    bool restoredSnapshot = false;
+
+    Ledger* autoLedger = nullptr;
+    std::size_t autoEvery = 0;
+
+    std::thread snapshotThread;
+    bool snapshotFailed = false;
+
+    void append(std::uint8_t kind, const std::string& payload);
+    bool flushLocked();
+    std::string logPath(std::uint64_t startSeq) const;
+    bool openLogLocked();
+    bool writeSnapshotFile(const std::vector<UserState>& state, std::uint64_t seq);
+    bool loadSnapshot(Ledger& ledger);
+    bool replayLog(const std::string& path, Ledger& ledger);
+    bool applyRecord(std::uint8_t kind, const char* data, std::size_t size, Ledger& ledger);
+    void maybeAutoSnapshot();
+
+public:
+    /**
+     * @param dir Каталог хранилища (создаётся при необходимости)
+     */
+    explicit StateStore(const std::string& dir);
+    /**
+     * @brief Дожидается фонового снимка и сбрасывает журнал на диск
+     */
+    ~StateStore() override;
+
+    StateStore(const StateStore&) = delete;
+    StateStore& operator=(const StateStore&) = delete;
+
+    /**
+     * @brief Восстанавливает состояние в пустой ledger и открывает журнал для записи
+     * @return false при ошибке ввода-вывода или повреждённом снимке
+     */
+    bool restore(Ledger& ledger);
+
+    /**
+     * @brief Делает снимок состояния
+     * @param background true — сериализация и запись в фоновом потоке
+     * @return false если снимок не удалось начать (или записать при background = false)
+     */
+    bool snapshot(Ledger& ledger, bool background = true);
+    /**
+     * @brief Дожидается завершения фонового снимка
+     * @return false если последний снимок не записан
+     */
+    bool waitForSnapshot();
+
+    /**
+     * @brief Автоматический снимок каждые everyRecords записей журнала (0 — выключено)
+     */
+    void setAutoSnapshot(Ledger* ledger, std::size_t everyRecords);
+
+    /**
+     * @brief Сбрасывает буфер журнала в файл
+     * @param durable true — дополнительно fsync
+     */
+    bool flush(bool durable = false);
+
+    // LedgerObserver
+    void onUserAdded(const User& user) override;
+    void onAccountAdded(const User& user, const Account& account) override;
+    void onCategoryAdded(const User& user, const Category& category) override;
+    void onBalanceChanged(const User& user, const Account& account) override;
+    void onTransactionAdded(const User& user, const std::shared_ptr<Transactions::Transaction>& trans) override;
+    void onTransactionRemoved(const User& user, const Transactions::Transaction& trans) override;
+    void onTransactionsArchived(const User& user, std::chrono::system_clock::time_point cutoff) override;
+
+    bool hasRestoredSnapshot() const { return restoredSnapshot; }
+    std::size_t getReplayedRecords() const { return replayedRecords; }
+    std::uint64_t getSequence() const { return nextSeq - 1; }
+    const std::string& getLastError() const { return lastError; }
+
+    /**
+     * @brief Компактная копия состояния пользователей
+     */
+    static std::vector<UserState> capture(Ledger& ledger);
+};
+
+} // namespace Persistence
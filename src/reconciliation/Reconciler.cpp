@@ -0,0 +1,238 @@
+/**
+ * @file Reconciler.cpp
+ * @brief Параллельная сверка балансов: группировка по счету с редукцией по потокам
+ */
+
+#include "Reconciler.h"
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cmath>
+#include <fstream>
+#include <iomanip>
+#include <iterator>
+#include <thread>
+#include <unordered_map>
+#include "../utils/Utils.h"
+
+namespace Reconciliation {
+
+namespace {
+
+constexpr std::size_t CHUNK_ROWS = 1 << 16;
+
+using TransactionList = std::vector<std::shared_ptr<Transactions::Transaction>>;
+
+struct Span {
+    const TransactionList* rows;
+    std::size_t begin;
+    std::size_t end;
+};
+
+/**
+ * @brief Частичные суммы одного потока (Ноймайер: сумма + компенсация)
+ */
+struct Partial {
+    std::vector<double> sum;
+    std::vector<double> compensation;
+    std::vector<std::size_t> count;
+    std::size_t orphans = 0;
+
+    explicit Partial(std::size_t accounts) : sum(accounts), compensation(accounts), count(accounts) {}
+
+    void add(std::size_t index, double value) {
+        double s = sum[index];
+        double t = s + value;
+        if (std::fabs(s) >= std::fabs(value)) {
+            compensation[index] += (s - t) + value;
+        } else {
+            compensation[index] += (value - t) + s;
+        }
+        sum[index] = t;
+        ++count[index];
+    }
+};
+
+struct Entry {
+    std::string user;
+    std::shared_ptr<Account> account;
+};
+
+Result reconcile(const std::vector<Entry>& entries, const std::vector<const TransactionList*>& lists,
+                 std::size_t threads, double tolerance) {
+    auto start = std::chrono::steady_clock::now();
+    Result result;
+    result.accountsChecked = entries.size();
+
+    std::unordered_map<const Account*, std::size_t> index;
+    index.reserve(entries.size());
+    for (std::size_t i = 0; i < entries.size(); ++i) {
+        index.emplace(entries[i].account.get(), i);
+    }
+
+    std::vector<Span> spans;
+    for (const auto* list : lists) {
+        result.transactionsProcessed += list->size();
+        for (std::size_t b = 0; b < list->size(); b += CHUNK_ROWS) {
+            spans.push_back(Span{list, b, std::min(b + CHUNK_ROWS, list->size())});
+        }
+    }
+
+    if (threads == 0) {
+        threads = std::max(1u, std::thread::hardware_concurrency());
+    }
+    threads = std::max<std::size_t>(1, std::min(threads, spans.size()));
+    result.threadsUsed = threads;
+
+    std::vector<Partial> partials(threads, Partial(entries.size()));
+    std::atomic<std::size_t> next{0};
+    auto worker = [&](std::size_t id) {
+        Partial& local = partials[id];
+        const Account* lastAccount = nullptr;
+        std::size_t lastIndex = 0;
+        bool lastKnown = false;
+
+        for (std::size_t s = next++; s < spans.size(); s = next++) {
+            const Span& span = spans[s];
+            for (std::size_t i = span.begin; i < span.end; ++i) {
+                const auto& trans = (*span.rows)[i];
+                const Account* account = trans->getAccount().get();
+                // История обычно идёт сериями по одному счёту — кэш последнего поиска
+                if (account != lastAccount) {
+                    auto it = account ? index.find(account) : index.end();
+                    lastAccount = account;
+                    lastKnown = it != index.end();
+                    lastIndex = lastKnown ? it->second : 0;
+                }
+                if (lastKnown) {
+                    local.add(lastIndex, trans->getAmount());
+                } else {
+                    ++local.orphans;
+                }
+            }
+        }
+    };
+
+    std::vector<std::thread> pool;
+    for (std::size_t t = 1; t < threads; ++t) {
+        pool.emplace_back(worker, t);
+    }
+    worker(0);
+    for (auto& th : pool) {
+        th.join();
+    }
+
+    for (std::size_t a = 0; a < entries.size(); ++a) {
+        double total = 0.0;
+        double compensation = 0.0;
+        std::size_t count = 0;
+        for (const auto& p : partials) {
+            total += p.sum[a];
+            compensation += p.compensation[a];
+            count += p.count[a];
+        }
+        const auto& account = entries[a].account;
+        double expected = account->getOpeningBalance() + total + compensation;
+        double actual = account->getBalance();
+        if (std::fabs(actual - expected) > tolerance) {
+            result.discrepancies.push_back(Discrepancy{entries[a].user, account, expected, actual, count});
+        }
+    }
+    for (const auto& p : partials) {
+        result.orphanTransactions += p.orphans;
+    }
+
+    std::sort(result.discrepancies.begin(), result.discrepancies.end(),
+        [](const Discrepancy& a, const Discrepancy& b) {
+            return std::fabs(a.difference()) > std::fabs(b.difference());
+        });
+    result.millis = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+    return result;
+}
+
+} // namespace
+
+Reconciler::Reconciler(std::size_t threadCount, double maxDifference)
+    : threads(threadCount), tolerance(maxDifference) {}
+
+Result Reconciler::run(Ledger& ledger) const {
+    auto start = std::chrono::steady_clock::now();
+    Result result;
+    std::vector<std::shared_ptr<User>> group;   // удерживаются от выгрузки до сверки группы
+    std::vector<Entry> entries;
+    std::vector<const TransactionList*> lists;
+    std::size_t rows = 0;
+
+    auto flush = [&] {
+        Result part = reconcile(entries, lists, threads, tolerance);
+        result.accountsChecked += part.accountsChecked;
+        result.transactionsProcessed += part.transactionsProcessed;
+        result.orphanTransactions += part.orphanTransactions;
+        result.threadsUsed = std::max(result.threadsUsed, part.threadsUsed);
+        std::move(part.discrepancies.begin(), part.discrepancies.end(), std::back_inserter(result.discrepancies));
+        group.clear();
+        entries.clear();
+        lists.clear();
+        rows = 0;
+    };
+
+    // Пользователи сверяются группами примерно по блоку строк на поток:
+    // потоки загружены, а в памяти одновременно только пользователи группы
+    std::size_t groupRows = CHUNK_ROWS * (threads ? threads : std::max(1u, std::thread::hardware_concurrency()));
+    ledger.forEachUser([&](const std::shared_ptr<User>& user) {
+        for (const auto& acc : user->getAccounts()) {
+            entries.push_back(Entry{user->getName(), acc});
+        }
+        lists.push_back(&user->getTransactions());
+        rows += user->getTransactions().size();
+        group.push_back(user);
+        if (rows >= groupRows) {
+            flush();
+        }
+    });
+    if (!group.empty() || result.threadsUsed == 0) {
+        flush();
+    }
+
+    std::sort(result.discrepancies.begin(), result.discrepancies.end(),
+        [](const Discrepancy& a, const Discrepancy& b) {
+            return std::fabs(a.difference()) > std::fabs(b.difference());
+        });
+    result.millis = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+    return result;
+}
+
+Result Reconciler::run(const std::vector<std::shared_ptr<Account>>& accounts,
+                       const TransactionList& transactions) const {
+    std::vector<Entry> entries;
+    for (const auto& acc : accounts) {
+        if (acc) entries.push_back(Entry{"", acc});
+    }
+    return reconcile(entries, {&transactions}, threads, tolerance);
+}
+
+void Reconciler::writeReport(std::ostream& os, const Result& result) {
+    os << "User,Account,Type,Currency,Expected,Actual,Difference,Transactions\n";
+    os << std::fixed << std::setprecision(2);
+    for (const auto& d : result.discrepancies) {
+        os << quoteCsvField(d.user) << ","
+           << quoteCsvField(d.account->getName()) << ","
+           << d.account->getType() << ","
+           << currencyCode(d.account->getCurrency()) << ","
+           << d.expected << ","
+           << d.actual << ","
+           << d.difference() << ","
+           << d.transactionCount << "\n";
+    }
+}
+
+bool Reconciler::saveReport(const std::string& filename, const Result& result) {
+    std::ofstream file(filename);
+    if (!file.is_open()) {
+        return false;
+    }
+    writeReport(file, result);
+    return static_cast<bool>(file);
+}
+
+} // namespace Reconciliation
@@ -0,0 +1,76 @@
+#pragma once
+#include <cstddef>
+#include <iostream>
+#include <memory>
+#include <string>
+#include <vector>
+#include "../ledger/Ledger.h"
+
+namespace Reconciliation {
+
+/**
+ * @brief Расхождение баланса счета с историей транзакций
+ */
+struct Discrepancy {
+    std::string user;
+    std::shared_ptr<Account> account;
+    double expected = 0.0;   // начальный баланс + сумма истории
+    double actual = 0.0;     // Account::getBalance()
+    std::size_t transactionCount = 0;
+
+    double difference() const { return actual - expected; }
+};
+
+struct Result {
+    std::size_t accountsChecked = 0;
+    std::size_t transactionsProcessed = 0;
+    std::size_t orphanTransactions = 0;   // транзакции без счета или со счетом вне проверки
+    std::size_t threadsUsed = 0;
+    double millis = 0.0;
+    std::vector<Discrepancy> discrepancies;
+
+    bool ok() const { return discrepancies.empty(); }
+};
+
+/**
+ * @brief Сверка балансов счетов с историей транзакций
+ *
+ * Для каждого счета пересчитывает баланс как getOpeningBalance() плюс сумма
+ * всех его транзакций и сравнивает с getBalance(). История режется на блоки,
+ * которые потоки забирают по атомарному счётчику; каждый поток копит суммы
+ * в собственном плотном массиве по номеру счета (суммирование Ноймайера),
+ * после чего массивы сводятся. Синхронизации на строку нет.
+ */
+class Reconciler {
+    std::size_t threads;
+    double tolerance;
+
+public:
+    /**
+     * @param threadCount Число потоков (0 — по числу ядер)
+     * @param maxDifference Допустимое расхождение
+     */
+    explicit Reconciler(std::size_t threadCount = 0, double maxDifference = 0.005);
+
+    /**
+     * @brief Сверка всех счетов всех пользователей журнала
+     *
+     * Пользователи обходятся через Ledger::forEachUser и сверяются группами,
+     * так что выгруженные подгружаются не все сразу.
+     */
+    Result run(Ledger& ledger) const;
+
+    /**
+     * @brief Сверка набора счетов с набором транзакций
+     */
+    Result run(const std::vector<std::shared_ptr<Account>>& accounts,
+               const std::vector<std::shared_ptr<Transactions::Transaction>>& transactions) const;
+
+    /**
+     * @brief Отчет о расхождениях в CSV
+     */
+    static void writeReport(std::ostream& os, const Result& result);
+    static bool saveReport(const std::string& filename, const Result& result);
+};
+
+} // namespace Reconciliation
@@ -0,0 +1,534 @@
+#include "ArrowReport.h"
+#include <algorithm>
+#include <array>
+#include <chrono>
+#include <cstring>
+#include <unordered_map>
+
+namespace Reports {
+
+namespace {
+
+// Значения перечислений из спецификации Arrow (format/Schema.fbs, Message.fbs)
+constexpr std::int16_t METADATA_V5 = 4;
+constexpr std::uint8_t HEADER_SCHEMA = 1;
+constexpr std::uint8_t HEADER_DICTIONARY_BATCH = 2;
+constexpr std::uint8_t HEADER_RECORD_BATCH = 3;
+constexpr std::uint8_t TYPE_FLOATING_POINT = 3;
+constexpr std::uint8_t TYPE_UTF8 = 5;
+constexpr std::uint8_t TYPE_TIMESTAMP = 10;
+constexpr std::int16_t PRECISION_DOUBLE = 2;
+constexpr std::int16_t UNIT_SECOND = 0;
+constexpr std::uint32_t CONTINUATION = 0xFFFFFFFFu;
+constexpr char MAGIC[] = "ARROW1";
+
+struct FieldSpec {
+    const char* name;
+    std::uint8_t type;
+    std::int64_t dictionary; // -1 — без словаря
+};
+
+constexpr std::size_t FIELD_COUNT = 6;
+constexpr std::size_t DICTIONARY_COUNT = 3;
+constexpr FieldSpec FIELDS[FIELD_COUNT] = {
+    {"date", TYPE_TIMESTAMP, -1},
+    {"type", TYPE_UTF8, 0},
+    {"account", TYPE_UTF8, 1},
+    {"category", TYPE_UTF8, 2},
+    {"amount", TYPE_FLOATING_POINT, -1},
+    {"description", TYPE_UTF8, -1},
+};
+
+std::size_t pad8(std::size_t n) {
+    return (n + 7) & ~std::size_t(7);
+}
+
+/**
+ * @brief Минимальный построитель FlatBuffers, пишущий от начала к концу
+ *
+ * Ссылки (uoffset) во FlatBuffers направлены только вперед, поэтому таблица
+ * пишется раньше своих детей, а ее поля-ссылки заполняются после (link).
+ * Выравнивание считается от начала буфера; буфер кладется в файл по адресу,
+ * кратному 8.
+ */
+class FlatBuilder {
+    std::string bytes;
+
+public:
+    FlatBuilder() : bytes(4, '\0') {} // смещение корневой таблицы
+
+    const std::string& data() const { return bytes; }
+    std::size_t size() const { return bytes.size(); }
+
+    void align(std::size_t a) {
+        bytes.resize((bytes.size() + a - 1) / a * a, '\0');
+    }
+
+    template <typename T>
+    void put(std::size_t pos, T value) {
+        std::memcpy(&bytes[pos], &value, sizeof(T));
+    }
+
+    template <typename T>
+    std::size_t push(T value) {
+        align(sizeof(T));
+        std::size_t pos = bytes.size();
+        bytes.resize(pos + sizeof(T));
+        put(pos, value);
+        return pos;
+    }
+
+    void link(std::size_t slot, std::size_t target) {
+        put(slot, static_cast<std::uint32_t>(target - slot));
+    }
+
+    void finish(std::size_t root) { link(0, root); }
+
+    std::size_t string(const std::string& s) {
+        std::size_t pos = push(static_cast<std::uint32_t>(s.size()));
+        bytes += s;
+        bytes += '\0';
+        return pos;
+    }
+
+    // Вектор ссылок: элемент i лежит по адресу pos + 4 + 4 * i
+    std::size_t offsets(std::size_t n) {
+        std::size_t pos = push(static_cast<std::uint32_t>(n));
+        bytes.resize(bytes.size() + 4 * n, '\0');
+        return pos;
+    }
+
+    // Вектор структур с 8-байтовыми полями: элементы выровнены на 8
+    std::size_t structs(const std::string& elements, std::size_t n) {
+        align(4);
+        if (bytes.size() % 8 == 0) {
+            bytes.resize(bytes.size() + 4, '\0');
+        }
+        std::size_t pos = push(static_cast<std::uint32_t>(n));
+        bytes += elements;
+        return pos;
+    }
+};
+
+/**
+ * @brief Описание таблицы FlatBuffers: скаляры и поля-ссылки по номерам
+ */
+class Table {
+    struct Field {
+        unsigned id;
+        std::size_t size;     // 0 — ссылка
+        std::uint64_t bits;
+    };
+    std::vector<Field> fields;
+
+public:
+    static constexpr unsigned MAX_FIELDS = 8;
+    using Slots = std::array<std::size_t, MAX_FIELDS>;
+
+    template <typename T>
+    Table& add(unsigned id, T value) {
+        std::uint64_t bits = 0;
+        std::memcpy(&bits, &value, sizeof(T));
+        fields.push_back({id, sizeof(T), bits});
+        return *this;
+    }
+
+    Table& ref(unsigned id) {
+        fields.push_back({id, 0, 0});
+        return *this;
+    }
+
+    /**
+     * @brief Пишет vtable и таблицу
+     * @param at Адреса полей по номерам (для ссылок — куда писать link)
+     * @return Адрес таблицы
+     */
+    std::size_t write(FlatBuilder& fb, Slots& at) const {
+        unsigned count = 0;
+        for (const auto& f : fields) {
+            count = std::max(count, f.id + 1);
+        }
+        fb.align(2);
+        std::size_t vtable = fb.size();
+        for (unsigned i = 0; i < count + 2; ++i) {
+            fb.push(std::uint16_t(0));
+        }
+
+        std::size_t table = fb.push(std::int32_t(0));
+        // Поля по убыванию размера — меньше байт уходит на выравнивание
+        auto ordered = fields;
+        std::stable_sort(ordered.begin(), ordered.end(), [](const Field& a, const Field& b) {
+            return (a.size ? a.size : 4) > (b.size ? b.size : 4);
+        });
+        for (const auto& f : ordered) {
+            std::size_t size = f.size ? f.size : 4;
+            fb.align(size);
+            std::size_t pos = fb.size();
+            for (std::size_t i = 0; i < size; ++i) {
+                fb.push(static_cast<std::uint8_t>(f.bits >> (8 * i)));
+            }
+            at[f.id] = pos;
+            fb.put(vtable + 4 + 2 * f.id, static_cast<std::uint16_t>(pos - table));
+        }
+        fb.put(vtable, static_cast<std::uint16_t>(4 + 2 * count));
+        fb.put(vtable + 2, static_cast<std::uint16_t>(fb.size() - table));
+        fb.put(table, static_cast<std::int32_t>(table - vtable));
+        return table;
+    }
+};
+
+/**
+ * @brief Раскладка буферов тела пакета: смещения и длины относительно начала тела
+ */
+struct BufferLayout {
+    std::vector<std::pair<std::int64_t, std::int64_t>> buffers;
+    std::size_t bodyLength = 0;
+
+    std::size_t add(std::size_t length) {
+        std::size_t offset = bodyLength;
+        buffers.emplace_back(static_cast<std::int64_t>(offset), static_cast<std::int64_t>(length));
+        bodyLength += pad8(length);
+        return offset;
+    }
+};
+
+std::string packPairs(const std::vector<std::pair<std::int64_t, std::int64_t>>& items) {
+    std::string out(items.size() * 16, '\0');
+    for (std::size_t i = 0; i < items.size(); ++i) {
+        std::memcpy(&out[i * 16], &items[i].first, 8);
+        std::memcpy(&out[i * 16 + 8], &items[i].second, 8);
+    }
+    return out;
+}
+
+/**
+ * @brief Таблица RecordBatch: длина, узлы столбцов (без null) и буферы
+ */
+std::size_t writeRecordBatch(FlatBuilder& fb, std::size_t rows, std::size_t columns, const BufferLayout& layout) {
+    Table::Slots at{};
+    std::size_t batch = Table().add<std::int64_t>(0, static_cast<std::int64_t>(rows)).ref(1).ref(2).write(fb, at);
+    std::vector<std::pair<std::int64_t, std::int64_t>> nodes(columns, {static_cast<std::int64_t>(rows), 0});
+    fb.link(at[1], fb.structs(packPairs(nodes), nodes.size()));
+    fb.link(at[2], fb.structs(packPairs(layout.buffers), layout.buffers.size()));
+    return batch;
+}
+
+std::size_t writeField(FlatBuilder& fb, const FieldSpec& spec) {
+    Table::Slots at{};
+    Table field;
+    field.ref(0).add<std::uint8_t>(1, 0).add<std::uint8_t>(2, spec.type).ref(3).ref(5);
+    if (spec.dictionary >= 0) {
+        field.ref(4);
+    }
+    std::size_t table = field.write(fb, at);
+    fb.link(at[0], fb.string(spec.name));
+
+    Table::Slots typeAt{};
+    if (spec.type == TYPE_TIMESTAMP) {
+        fb.link(at[3], Table().add<std::int16_t>(0, UNIT_SECOND).ref(1).write(fb, typeAt));
+        fb.link(typeAt[1], fb.string("UTC"));
+    } else if (spec.type == TYPE_FLOATING_POINT) {
+        fb.link(at[3], Table().add<std::int16_t>(0, PRECISION_DOUBLE).write(fb, typeAt));
+    } else {
+        fb.link(at[3], Table().write(fb, typeAt));
+    }
+
+    if (spec.dictionary >= 0) {
+        Table::Slots dictAt{};
+        fb.link(at[4], Table().add<std::int64_t>(0, spec.dictionary).ref(1).add<std::uint8_t>(2, 0).write(fb, dictAt));
+        Table::Slots indexAt{};
+        fb.link(dictAt[1], Table().add<std::int32_t>(0, 32).add<std::uint8_t>(1, 1).write(fb, indexAt));
+    }
+    fb.link(at[5], fb.offsets(0));
+    return table;
+}
+
+std::size_t writeSchema(FlatBuilder& fb, const std::string& title) {
+    Table::Slots at{};
+    std::size_t schema = Table().add<std::int16_t>(0, 0).ref(1).ref(2).write(fb, at);
+    std::size_t fields = fb.offsets(FIELD_COUNT);
+    fb.link(at[1], fields);
+    std::size_t metadata = fb.offsets(1);
+    fb.link(at[2], metadata);
+    for (std::size_t i = 0; i < FIELD_COUNT; ++i) {
+        fb.link(fields + 4 + 4 * i, writeField(fb, FIELDS[i]));
+    }
+    Table::Slots kvAt{};
+    fb.link(metadata + 4, Table().ref(0).ref(1).write(fb, kvAt));
+    fb.link(kvAt[0], fb.string("title"));
+    fb.link(kvAt[1], fb.string(title));
+    return schema;
+}
+
+/**
+ * @brief Метаданные сообщения IPC: маркер продолжения, длина, FlatBuffer Message
+ *
+ * Длина дополняется так, чтобы тело сообщения начиналось с адреса, кратного 8.
+ */
+template <typename WriteHeader>
+std::string encodeMessage(std::uint8_t headerType, std::size_t bodyLength, WriteHeader writeHeader) {
+    FlatBuilder fb;
+    Table::Slots at{};
+    std::size_t root = Table()
+        .add<std::int16_t>(0, METADATA_V5)
+        .add<std::uint8_t>(1, headerType)
+        .ref(2)
+        .add<std::int64_t>(3, static_cast<std::int64_t>(bodyLength))
+        .write(fb, at);
+    fb.finish(root);
+    fb.link(at[2], writeHeader(fb));
+
+    std::size_t length = pad8(fb.size() + 8) - 8;
+    std::string out(8, '\0');
+    std::int32_t length32 = static_cast<std::int32_t>(length);
+    std::memcpy(&out[0], &CONTINUATION, 4);
+    std::memcpy(&out[4], &length32, 4);
+    out += fb.data();
+    out.resize(8 + length, '\0');
+    return out;
+}
+
+BufferLayout batchLayout(std::size_t rows, std::size_t descriptionBytes) {
+    BufferLayout layout;
+    for (std::size_t i = 0; i < FIELD_COUNT; ++i) {
+        layout.add(0); // битовая маска null не нужна: пропусков нет
+        if (i == 0 || i == 4) {
+            layout.add(rows * 8);
+        } else if (i == 5) {
+            layout.add((rows + 1) * 4);
+            layout.add(descriptionBytes);
+        } else {
+            layout.add(rows * 4);
+        }
+    }
+    return layout;
+}
+
+std::string encodeBatchMessage(std::size_t rows, const BufferLayout& layout) {
+    return encodeMessage(HEADER_RECORD_BATCH, layout.bodyLength, [&](FlatBuilder& fb) {
+        return writeRecordBatch(fb, rows, FIELD_COUNT, layout);
+    });
+}
+
+/**
+ * @brief Словарь строк в порядке первого появления
+ */
+struct Dictionary {
+    std::vector<std::string> values;
+    std::unordered_map<std::string, std::int32_t> codes;
+
+    std::int32_t code(const std::string& value) {
+        auto it = codes.find(value);
+        if (it != codes.end()) {
+            return it->second;
+        }
+        auto c = static_cast<std::int32_t>(values.size());
+        codes.emplace(value, c);
+        values.push_back(value);
+        return c;
+    }
+};
+
+std::string encodeDictionary(std::int64_t id, const Dictionary& dict) {
+    std::vector<std::int32_t> offsets(dict.values.size() + 1, 0);
+    std::string data;
+    for (std::size_t i = 0; i < dict.values.size(); ++i) {
+        data += dict.values[i];
+        offsets[i + 1] = static_cast<std::int32_t>(data.size());
+    }
+    BufferLayout layout;
+    layout.add(0);
+    std::size_t offsetsAt = layout.add(offsets.size() * 4);
+    std::size_t dataAt = layout.add(data.size());
+
+    std::string out = encodeMessage(HEADER_DICTIONARY_BATCH, layout.bodyLength, [&](FlatBuilder& fb) {
+        Table::Slots at{};
+        std::size_t batch = Table().add<std::int64_t>(0, id).ref(1).add<std::uint8_t>(2, 0).write(fb, at);
+        fb.link(at[1], writeRecordBatch(fb, dict.values.size(), 1, layout));
+        return batch;
+    });
+    std::string body(layout.bodyLength, '\0');
+    std::memcpy(&body[offsetsAt], offsets.data(), offsets.size() * 4);
+    if (!data.empty()) {
+        std::memcpy(&body[dataAt], data.data(), data.size());
+    }
+    return out + body;
+}
+
+} // namespace
+
+/**
+ * @brief Коды словарей всех строк; пересчитываются при изменении набора транзакций
+ */
+std::shared_ptr<const ArrowReport::Columns> ArrowReport::getColumns() const {
+    sortRows();
+    std::lock_guard<std::mutex> lock(columnsMutex);
+    if (!columns || columns->revision != getRevision()) {
+        columns = buildColumns();
+    }
+    return columns;
+}
+
+std::shared_ptr<const ArrowReport::Columns> ArrowReport::buildColumns() const {
+    auto cols = std::make_shared<Columns>();
+    std::size_t n = transactions.size();
+    cols->revision = getRevision();
+    cols->rows = n;
+    cols->type.resize(n);
+    cols->account.resize(n);
+    cols->category.resize(n);
+    cols->descriptionEnd.resize(n + 1, 0);
+
+    Dictionary types, accounts, categories;
+    // Имя ищется в словаре один раз на объект счета/категории
+    std::unordered_map<const void*, std::int32_t> accountCodes, categoryCodes;
+    for (std::size_t i = 0; i < n; ++i) {
+        const auto& trans = *transactions[i];
+        cols->type[i] = types.code(trans.getType());
+
+        const void* acc = trans.getAccount().get();
+        auto a = accountCodes.find(acc);
+        if (a == accountCodes.end()) {
+            a = accountCodes.emplace(acc, accounts.code(trans.getAccountName())).first;
+        }
+        cols->account[i] = a->second;
+
+        const void* cat = trans.getCategory().get();
+        auto c = categoryCodes.find(cat);
+        if (c == categoryCodes.end()) {
+            c = categoryCodes.emplace(cat, categories.code(trans.getCategoryName())).first;
+        }
+        cols->category[i] = c->second;
+
+        cols->descriptionEnd[i + 1] = cols->descriptionEnd[i] + trans.getDescription().size();
+    }
+
+    // Заголовок файла: магия, схема и по одному словарю на словарный столбец
+    std::string& header = cols->header;
+    header.assign(MAGIC, 6);
+    header.resize(8, '\0');
+    header += encodeMessage(HEADER_SCHEMA, 0, [&](FlatBuilder& fb) { return writeSchema(fb, title); });
+    const Dictionary* dictionaries[DICTIONARY_COUNT] = {&types, &accounts, &categories};
+    for (std::size_t id = 0; id < DICTIONARY_COUNT; ++id) {
+        std::string message = encodeDictionary(static_cast<std::int64_t>(id), *dictionaries[id]);
+        std::int32_t metaLength = 0;
+        std::memcpy(&metaLength, &message[4], 4);
+        cols->dictionaryBlocks.push_back(Block{static_cast<std::int64_t>(header.size()), metaLength + 8,
+                                               static_cast<std::int64_t>(message.size()) - metaLength - 8});
+        header += message;
+    }
+    return cols;
+}
+
+void ArrowReport::writeHeader(std::ostream& os) const {
+    const auto cols = getColumns();
+    os.write(cols->header.data(), static_cast<std::streamsize>(cols->header.size()));
+}
+
+/**
+ * @brief Пакеты строк [begin, end), разрезанные по границам BATCH_ROWS
+ */
+void ArrowReport::writeRows(std::ostream& os, std::size_t begin, std::size_t end) const {
+    const auto cols = getColumns();
+    end = std::min(end, cols->rows);
+    while (begin < end) {
+        std::size_t batchEnd = std::min(end, (begin / BATCH_ROWS + 1) * BATCH_ROWS);
+        writeBatch(os, *cols, begin, batchEnd);
+        begin = batchEnd;
+    }
+}
+
+void ArrowReport::writeBatch(std::ostream& os, const Columns& cols, std::size_t begin, std::size_t end) const {
+    std::size_t rows = end - begin;
+    std::size_t descriptionBytes = cols.descriptionEnd[end] - cols.descriptionEnd[begin];
+    BufferLayout layout = batchLayout(rows, descriptionBytes);
+    std::string body(layout.bodyLength, '\0');
+    auto at = [&](std::size_t buffer) { return &body[static_cast<std::size_t>(layout.buffers[buffer].first)]; };
+
+    // Буферы: маска и данные каждого столбца, у description еще смещения
+    auto* dates = reinterpret_cast<std::int64_t*>(at(1));
+    auto* amounts = reinterpret_cast<double*>(at(9));
+    auto* offsets = reinterpret_cast<std::int32_t*>(at(11));
+    char* text = at(12);
+    std::int32_t offset = 0;
+    offsets[0] = 0;
+    for (std::size_t i = 0; i < rows; ++i) {
+        const auto& trans = *transactions[begin + i];
+        dates[i] = std::chrono::duration_cast<std::chrono::seconds>(trans.getDate().time_since_epoch()).count();
+        amounts[i] = trans.getAmount();
+        std::string description = trans.getDescription();
+        std::memcpy(text + offset, description.data(), description.size());
+        offset += static_cast<std::int32_t>(description.size());
+        offsets[i + 1] = offset;
+    }
+    std::memcpy(at(3), &cols.type[begin], rows * 4);
+    std::memcpy(at(5), &cols.account[begin], rows * 4);
+    std::memcpy(at(7), &cols.category[begin], rows * 4);
+
+    std::string meta = encodeBatchMessage(rows, layout);
+    os.write(meta.data(), static_cast<std::streamsize>(meta.size()));
+    os.write(body.data(), static_cast<std::streamsize>(body.size()));
+}
+
+/**
+ * @brief Маркер конца потока и итоговая секция файла со смещениями словарей и пакетов
+ */
+void ArrowReport::writeFooter(std::ostream& os) const {
+    const auto cols = getColumns();
+    std::vector<Block> batches;
+    std::int64_t offset = static_cast<std::int64_t>(cols->header.size());
+    for (std::size_t begin = 0; begin < cols->rows; begin += BATCH_ROWS) {
+        std::size_t end = std::min(cols->rows, begin + BATCH_ROWS);
+        BufferLayout layout = batchLayout(end - begin, cols->descriptionEnd[end] - cols->descriptionEnd[begin]);
+        std::size_t metaLength = encodeBatchMessage(end - begin, layout).size();
+        batches.push_back(Block{offset, static_cast<std::int32_t>(metaLength),
+                                static_cast<std::int64_t>(layout.bodyLength)});
+        offset += static_cast<std::int64_t>(metaLength + layout.bodyLength);
+    }
+
+    auto packBlocks = [](const std::vector<Block>& blocks) {
+        std::string out(blocks.size() * 24, '\0');
+        for (std::size_t i = 0; i < blocks.size(); ++i) {
+            std::memcpy(&out[i * 24], &blocks[i].offset, 8);
+            std::memcpy(&out[i * 24 + 8], &blocks[i].metaDataLength, 4);
+            std::memcpy(&out[i * 24 + 16], &blocks[i].bodyLength, 8);
+        }
+        return out;
+    };
+
+    FlatBuilder fb;
+    Table::Slots at{};
+    std::size_t footer = Table().add<std::int16_t>(0, METADATA_V5).ref(1).ref(2).ref(3).write(fb, at);
+    fb.finish(footer);
+    fb.link(at[1], writeSchema(fb, title));
+    fb.link(at[2], fb.structs(packBlocks(cols->dictionaryBlocks), cols->dictionaryBlocks.size()));
+    fb.link(at[3], fb.structs(packBlocks(batches), batches.size()));
+
+    std::uint32_t eos[2] = {CONTINUATION, 0};
+    std::int32_t footerLength = static_cast<std::int32_t>(fb.size());
+    os.write(reinterpret_cast<const char*>(eos), sizeof(eos));
+    os.write(fb.data().data(), static_cast<std::streamsize>(fb.size()));
+    os.write(reinterpret_cast<const char*>(&footerLength), 4);
+    os.write(MAGIC, 6);
+}
+
+/**
+ * @brief Двоичный отчет не выводится в терминал: печатается его схема и объем
+ */
+void ArrowReport::generate() const {
+    std::size_t rows = transactions.size();
+    std::cout << "=== " << title << " ===\n";
+    std::cout << "Format: " << getFormat() << " (columnar binary, use saveToFile)\n";
+    std::cout << "Transactions: " << rows << " in " << (rows + BATCH_ROWS - 1) / BATCH_ROWS << " record batches\n";
+    std::cout << "Columns:";
+    for (const auto& field : FIELDS) {
+        std::cout << " " << field.name << (field.dictionary >= 0 ? "(dictionary)" : "");
+    }
+    std::cout << "\n";
+}
+
+void ArrowReport::saveToFile(const std::string& filename) const {
+    saveWithMessage(filename, "Arrow report saved to: ");
+}
+
+} // namespace Reports
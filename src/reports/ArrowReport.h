@@ -0,0 +1,64 @@
+#pragma once
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+#include "Report.h"
+
+namespace Reports {
+
+/**
+ * @brief Двоичный столбцовый отчет в формате Arrow IPC (файл Feather v2)
+ *
+ * Столбцы: date (timestamp[s, UTC]), type, account, category (словарные,
+ * индексы int32 и словари utf8), amount (float64), description (utf8).
+ * Строки пишутся пакетами по BATCH_ROWS, итоговая секция содержит схему
+ * и смещения всех пакетов, поэтому файл читается с произвольным доступом
+ * (pyarrow.ipc.open_file, pyarrow.feather, DuckDB, Polars).
+ *
+ * Словари и коды строк строятся одним проходом при первой записи и
+ * пересчитываются, только если в отчет добавлены транзакции.
+ */
+class ArrowReport : public Report {
+public:
+    static constexpr std::size_t BATCH_ROWS = 65536;
+
+    ArrowReport(const std::string& t) : Report(t) {}
+
+    void generate() const override;
+    void saveToFile(const std::string& filename) const override;
+    std::string getFormat() const override { return "ARROW"; }
+    std::size_t getRowBlockSize() const override { return BATCH_ROWS; }
+
+    void writeHeader(std::ostream& os) const override;
+    // begin должен быть кратен BATCH_ROWS: итоговая секция ссылается на пакеты
+    // [k * BATCH_ROWS, (k + 1) * BATCH_ROWS)
+    void writeRows(std::ostream& os, std::size_t begin, std::size_t end) const override;
+    void writeFooter(std::ostream& os) const override;
+
+private:
+    struct Block {
+        std::int64_t offset;
+        std::int32_t metaDataLength;
+        std::int64_t bodyLength;
+    };
+
+    struct Columns {
+        std::uint64_t revision = 0;                        // Report::getRevision при построении
+        std::size_t rows = 0;
+        std::vector<std::int32_t> type, account, category; // коды словарей
+        std::vector<std::uint64_t> descriptionEnd;         // накопленные длины описаний
+        std::string header;                                // магия, схема и словари
+        std::vector<Block> dictionaryBlocks;
+    };
+
+    mutable std::mutex columnsMutex;
+    mutable std::shared_ptr<const Columns> columns;
+
+    std::shared_ptr<const Columns> getColumns() const;
+    std::shared_ptr<const Columns> buildColumns() const;
+    void writeBatch(std::ostream& os, const Columns& cols, std::size_t begin, std::size_t end) const;
+};
+
+} // namespace Reports
@@ -0,0 +1,216 @@
+/**
+ * @file AsyncExporter.cpp
+ * @brief Конвейер выгрузки: параллельное форматирование блоков и последовательная запись
+ */
+
+#include "AsyncExporter.h"
+#include <algorithm>
+#include <cerrno>
+#include <fcntl.h>
+#include <unistd.h>
+#include "../metrics/Metrics.h"
+
+namespace Reports {
+
+namespace {
+
+/**
+ * @brief Запись буфера целиком по смещению с повтором при частичной записи
+ */
+bool writeAll(int fd, const std::string& data, off_t& offset) {
+    const char* ptr = data.data();
+    std::size_t left = data.size();
+    while (left > 0) {
+        ssize_t written = ::pwrite(fd, ptr, left, offset);
+        if (written < 0) {
+            if (errno == EINTR) continue;
+            return false;
+        }
+        ptr += written;
+        left -= static_cast<std::size_t>(written);
+        offset += written;
+    }
+    return true;
+}
+
+} // namespace
+
+AsyncExporter::AsyncExporter(std::size_t formatThreads, std::size_t rows, std::size_t maxBufferedChunks)
+    : chunkRows(std::max<std::size_t>(rows, 1)),
+      maxBuffered(std::max<std::size_t>(maxBufferedChunks, 1)) {
+    if (formatThreads == 0) {
+        formatThreads = std::max(1u, std::thread::hardware_concurrency());
+    }
+    for (std::size_t i = 0; i < formatThreads; ++i) {
+        formatters.emplace_back(&AsyncExporter::formatLoop, this);
+    }
+    writer = std::thread(&AsyncExporter::writeLoop, this);
+}
+
+AsyncExporter::~AsyncExporter() {
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        stopping = true;
+    }
+    taskReady.notify_all();
+    chunkReady.notify_all();
+    for (auto& t : formatters) {
+        t.join();
+    }
+    writer.join();
+}
+
+std::future<bool> AsyncExporter::submit(std::shared_ptr<const Report> report,
+                                        const std::string& filename,
+                                        Callback onComplete) {
+    auto job = std::make_shared<Job>();
+    job->report = std::move(report);
+    job->filename = filename;
+    job->onComplete = std::move(onComplete);
+
+    std::size_t blockSize = job->report->getRowBlockSize();
+    job->chunkRows = (chunkRows + blockSize - 1) / blockSize * blockSize;
+    std::size_t rows = job->report->getTransactionCount();
+    std::size_t rowChunks = (rows + job->chunkRows - 1) / job->chunkRows;
+    job->chunks.resize(rowChunks + 2);
+
+    auto future = job->promise.get_future();
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        for (std::size_t i = 0; i < job->chunks.size(); ++i) {
+            tasks.push_back(Task{job, i});
+        }
+        writeQueue.push_back(job);
+    }
+    taskReady.notify_all();
+    chunkReady.notify_one();
+    return future;
+}
+
+/**
+ * @brief Форматирует один блок: 0 — заголовок, последний — итоги, остальные — строки
+ */
+void AsyncExporter::formatChunk(const Job& job, std::size_t chunk, std::string& out) const {
+    const Report& report = *job.report;
+    out.clear();
+    if (chunk == 0) {
+        report.appendHeader(out);
+    } else if (chunk + 1 == job.chunks.size()) {
+        report.appendFooter(out);
+    } else {
+        std::size_t begin = (chunk - 1) * job.chunkRows;
+        std::size_t end = std::min(begin + job.chunkRows, report.getTransactionCount());
+        report.appendRows(out, begin, end);
+    }
+}
+
+void AsyncExporter::formatLoop() {
+    while (true) {
+        Task task;
+        {
+            std::unique_lock<std::mutex> lock(mutex);
+            // Буфер занимается в порядке очереди, поэтому самый ранний
+            // незаписанный блок всегда уже взят в работу — взаимоблокировки нет
+            taskReady.wait(lock, [this] {
+                return (stopping && tasks.empty()) || (!tasks.empty() && buffered < maxBuffered);
+            });
+            if (tasks.empty()) return;
+            task = tasks.front();
+            tasks.pop_front();
+            ++buffered;
+        }
+
+        // Исключение не должно покинуть поток: блок все равно помечается
+        // готовым, иначе писатель ждал бы его вечно
+        std::string data;
+        std::exception_ptr error;
+        try {
+            formatChunk(*task.job, task.chunk, data);
+        } catch (...) {
+            data.clear();
+            error = std::current_exception();
+        }
+
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            auto& chunk = task.job->chunks[task.chunk];
+            chunk.data = std::move(data);
+            chunk.error = error;
+            chunk.ready = true;
+        }
+        chunkReady.notify_one();
+    }
+}
+
+/**
+ * @brief Записывает блоки задания по порядку
+ *
+ * Блоки забираются все, даже после ошибки, чтобы освободить буфер.
+ * @param error Первое исключение форматирования блоков задания
+ */
+bool AsyncExporter::writeJob(Job& job, std::exception_ptr& error) {
+    METRICS_TIMER(ReportExport);
+    METRICS_INC(ReportExports);
+    METRICS_ADD(ReportExportRows, job.report->getTransactionCount());
+
+    int fd = ::open(job.filename.c_str(), O_WRONLY | O_CREAT | O_TRUNC, 0644);
+    bool ok = fd >= 0;
+    off_t offset = 0;
+
+    for (std::size_t i = 0; i < job.chunks.size(); ++i) {
+        std::string data;
+        {
+            std::unique_lock<std::mutex> lock(mutex);
+            chunkReady.wait(lock, [&] { return job.chunks[i].ready; });
+            data.swap(job.chunks[i].data);
+            if (job.chunks[i].error && !error) {
+                error = job.chunks[i].error;
+            }
+            --buffered;
+        }
+        taskReady.notify_one();
+
+        if (error) {
+            ok = false;
+        } else if (ok) {
+            ok = writeAll(fd, data, offset);
+        }
+    }
+
+    if (fd >= 0 && ::close(fd) != 0) {
+        ok = false;
+    }
+    return ok;
+}
+
+void AsyncExporter::writeLoop() {
+    while (true) {
+        std::shared_ptr<Job> job;
+        {
+            std::unique_lock<std::mutex> lock(mutex);
+            chunkReady.wait(lock, [this] { return stopping || !writeQueue.empty(); });
+            if (writeQueue.empty()) return;
+            job = writeQueue.front();
+            writeQueue.pop_front();
+        }
+
+        std::exception_ptr error;
+        bool ok = writeJob(*job, error);
+        // Результат отдается до обратного вызова: исключение из него
+        // не оставит future без значения и не завершит поток-писатель
+        if (error) {
+            job->promise.set_exception(error);
+        } else {
+            job->promise.set_value(ok);
+        }
+        if (job->onComplete) {
+            try {
+                job->onComplete(ok);
+            } catch (...) {
+                // Файл уже записан, результат отдан через future
+            }
+        }
+    }
+}
+
+} // namespace Reports
@@ -0,0 +1,104 @@
+#pragma once
+#include <condition_variable>
+#include <cstddef>
+#include <deque>
+#include <exception>
+#include <functional>
+#include <future>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+#include "Report.h"
+
+namespace Reports {
+
+/**
+ * @brief Асинхронная выгрузка отчетов в файлы
+ *
+ * Строки отчета режутся на блоки, которые форматируют потоки-производители,
+ * а отдельный поток-писатель записывает готовые блоки по порядку крупными
+ * последовательными pwrite. Форматирование и запись на диск перекрываются,
+ * вызывающий поток не блокируется. Число одновременно отформатированных,
+ * но ещё не записанных блоков ограничено, поэтому память не растёт
+ * при медленном диске.
+ *
+ * Отчет не должен изменяться, пока его выгрузка не завершена.
+ */
+class AsyncExporter {
+public:
+    using Callback = std::function<void(bool)>;
+
+    /**
+     * @param formatThreads Число потоков форматирования (0 — по числу ядер)
+     * @param chunkRows Строк отчета в одном блоке (округляется вверх
+     *                  до кратного Report::getRowBlockSize)
+     * @param maxBufferedChunks Предел блоков, ожидающих записи
+     */
+    explicit AsyncExporter(std::size_t formatThreads = 0,
+                           std::size_t chunkRows = 16384,
+                           std::size_t maxBufferedChunks = 64);
+    /**
+     * @brief Дожидается завершения всех поставленных выгрузок
+     */
+    ~AsyncExporter();
+
+    AsyncExporter(const AsyncExporter&) = delete;
+    AsyncExporter& operator=(const AsyncExporter&) = delete;
+
+    /**
+     * @brief Ставит отчет в очередь на выгрузку
+     * @param report Отчет (удерживается до завершения записи)
+     * @param filename Путь к файлу
+     * @param onComplete Вызывается из потока-писателя после того, как
+     *                   future получил результат; его исключения отбрасываются
+     * @return future с результатом: true если файл полностью записан;
+     *         исключение форматирования передается через future
+     */
+    std::future<bool> submit(std::shared_ptr<const Report> report,
+                             const std::string& filename,
+                             Callback onComplete = nullptr);
+
+private:
+    struct Chunk {
+        std::string data;
+        std::exception_ptr error;  // исключение форматирования блока
+        bool ready = false;
+    };
+
+    struct Job {
+        std::shared_ptr<const Report> report;
+        std::string filename;
+        Callback onComplete;
+        std::promise<bool> promise;
+        std::vector<Chunk> chunks; // заголовок, блоки строк, итоги
+        std::size_t chunkRows;     // кратно Report::getRowBlockSize
+    };
+
+    struct Task {
+        std::shared_ptr<Job> job;
+        std::size_t chunk;
+    };
+
+    std::size_t chunkRows;
+    std::size_t maxBuffered;
+    std::size_t buffered = 0;
+    bool stopping = false;
+
+    std::mutex mutex;
+    std::condition_variable taskReady;   // есть задание для форматирования и свободный буфер
+    std::condition_variable chunkReady;  // блок отформатирован или появилось задание записи
+    std::deque<Task> tasks;
+    std::deque<std::shared_ptr<Job>> writeQueue;
+
+    std::vector<std::thread> formatters;
+    std::thread writer;
+
+    void formatLoop();
+    void writeLoop();
+    bool writeJob(Job& job, std::exception_ptr& error);
+    void formatChunk(const Job& job, std::size_t chunk, std::string& out) const;
+};
+
+} // namespace Reports
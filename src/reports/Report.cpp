@@ -1,9 +1,219 @@
 #include "Report.h"
+#include "ArrowReport.h"
+#include "../metrics/Metrics.h"
+#include "../storage/ColdStore.h"
 #include <fstream>
-#include <iomanip>
 #include <sstream>
+#include <algorithm>
+#include <cmath>
+#include <cctype>
 
 namespace Reports {
+/**
+ * @brief Обновление инкрементальной статистики по транзакции
+ * 
+ * @param transaction 
+ */
+void Report::indexTransaction(const std::shared_ptr<Transactions::Transaction>& transaction) {
+    double amount = transaction->getAmount();
+    amountSketch.update(std::fabs(amount));
+    if (amount > 0) {
+        incomeByCurrency[currencyIndex(transaction->getCurrency())] += amount;
+    } else if (amount < 0) {
+        expensesByCurrency[currencyIndex(transaction->getCurrency())] += amount;
+    }
+    if (amount < 0) {
+        largestWithdrawals.push(-amount, transaction);
+    }
+}
+
+/**
+ * @brief Добавление транзакции с учетом выборки
+ * 
+ * @param transaction 
+ */
+void Report::addTransaction(std::shared_ptr<Transactions::Transaction> transaction) {
+    if (!query.matches(*transaction)) {
+        return;
+    }
+    indexTransaction(transaction);
+    transactions.push_back(std::move(transaction));
+    if (query.sort.empty()) {
+        sortedRows = transactions.size();
+    }
+    ++revision;
+}
+
+/**
+ * @brief Упорядочивание строк, добавленных после последней сортировки
+ *
+ * Хвост сортируется устойчиво и сливается с началом: как и при вставке
+ * по upper_bound, равные строки остаются в порядке добавления.
+ */
+void Report::sortRows() const {
+    std::lock_guard<std::mutex> lock(rowsMutex);
+    if (sortedRows == transactions.size()) {
+        return;
+    }
+    auto less = [this](const auto& a, const auto& b) { return query.less(*a, *b); };
+    auto middle = transactions.begin() + static_cast<std::ptrdiff_t>(sortedRows);
+    std::stable_sort(middle, transactions.end(), less);
+    std::inplace_merge(transactions.begin(), middle, transactions.end(), less);
+    sortedRows = transactions.size();
+}
+
+/**
+ * @brief Замена списка транзакций с пересчётом статистики
+ * 
+ * Фильтры выборки применяются до сортировки и до подсчета статистики.
+ * 
+ * @param trans 
+ */
+void Report::setTransactions(const std::vector<std::shared_ptr<Transactions::Transaction>>& trans) {
+    if (query.isFiltered()) {
+        std::vector<std::shared_ptr<Transactions::Transaction>> selected;
+        for (const auto& t : trans) {
+            if (query.matches(*t)) {
+                selected.push_back(t);
+            }
+        }
+        transactions = std::move(selected);
+    } else {
+        transactions = trans;
+    }
+    if (!query.sort.empty()) {
+        std::stable_sort(transactions.begin(), transactions.end(),
+            [this](const auto& a, const auto& b) { return query.less(*a, *b); });
+    }
+    sortedRows = transactions.size();
+    ++revision;
+    largestWithdrawals.clear();
+    amountSketch.clear();
+    incomeByCurrency = {};
+    expensesByCurrency = {};
+    archivedIncome = 0.0;
+    archivedExpenses = 0.0;
+    archivedCount = 0;
+    for (const auto& t : transactions) {
+        indexTransaction(t);
+    }
+}
+
+/**
+ * @brief Итоги холодного архива за диапазон дат
+ *
+ * Суммы берутся из ColdStore::aggregate: распаковываются только блоки
+ * на границах диапазона.
+ *
+ * @return false если выборка фильтрует по типу, счету, категории или сумме
+ */
+bool Report::addArchive(const Storage::ColdStore& archive, TimePoint from, TimePoint to) {
+    ReportQuery datesOnly = query;
+    datesOnly.from = TimePoint::min();
+    datesOnly.to = TimePoint::max();
+    if (datesOnly.isFiltered()) {
+        return false;
+    }
+    auto totals = archive.aggregate(std::max(from, query.from), std::min(to, query.to));
+    if (totals.count == 0) {
+        return true;
+    }
+    archivedIncome += totals.income;
+    archivedExpenses += totals.expenses;
+    archivedCount += totals.count;
+    ++revision;
+    return true;
+}
+
+/**
+ * @brief Установка выборки строк
+ * 
+ * @param q 
+ */
+void Report::setQuery(const ReportQuery& q) {
+    query = q;
+    setTransactions(std::vector<std::shared_ptr<Transactions::Transaction>>(transactions));
+}
+
+/**
+ * @brief Доходы в целевой валюте
+ * 
+ * @param target валюта результата
+ * @param rates таблица курсов
+ * @param at момент, на который берутся курсы
+ * @param result сумма доходов
+ * @return false если для какой-либо валюты нет курса
+ */
+bool Report::getTotalIncome(Currency target, const FxRateTable& rates, FxRateTable::TimePoint at, double& result) const {
+    METRICS_TIMER(ReportAggregate);
+    METRICS_INC(ReportAggregations);
+    return rates.convertTotals(incomeByCurrency, target, at, result);
+}
+
+/**
+ * @brief Расходы в целевой валюте
+ * 
+ * @return false если для какой-либо валюты нет курса
+ */
+bool Report::getTotalExpenses(Currency target, const FxRateTable& rates, FxRateTable::TimePoint at, double& result) const {
+    METRICS_TIMER(ReportAggregate);
+    METRICS_INC(ReportAggregations);
+    return rates.convertTotals(expensesByCurrency, target, at, result);
+}
+
+/**
+ * @brief Итоговый баланс в целевой валюте
+ * 
+ * @return false если для какой-либо валюты нет курса
+ */
+bool Report::getNetBalance(Currency target, const FxRateTable& rates, FxRateTable::TimePoint at, double& result) const {
+    double income = 0.0;
+    double expenses = 0.0;
+    if (!getTotalIncome(target, rates, at, income) || !getTotalExpenses(target, rates, at, expenses)) {
+        return false;
+    }
+    result = income + expenses;
+    return true;
+}
+
+/**
+ * @brief Метод получения K крупнейших списаний
+ * 
+ * Пока k не превышает ёмкость отслеживаемого топа, ответ берётся из кучи
+ * без обхода транзакций. Иначе выполняется частичная сортировка.
+ * 
+ * @param k 
+ * @return std::vector<std::shared_ptr<Transactions::Transaction>> 
+ */
+std::vector<std::shared_ptr<Transactions::Transaction>> Report::getLargestWithdrawals(std::size_t k) const {
+    if (k <= largestWithdrawals.capacity()) {
+        return largestWithdrawals.top(k);
+    }
+
+    std::vector<std::shared_ptr<Transactions::Transaction>> withdrawals;
+    sortRows();
+    for (const auto& trans : transactions) {
+        if (trans->getAmount() < 0) {
+            withdrawals.push_back(trans);
+        }
+    }
+    k = std::min(k, withdrawals.size());
+    std::partial_sort(withdrawals.begin(), withdrawals.begin() + k, withdrawals.end(),
+        [](const auto& a, const auto& b) { return a->getAmount() < b->getAmount(); });
+    withdrawals.resize(k);
+    return withdrawals;
+}
+
+/**
+ * @brief Метод получения приближённого квантиля размера транзакции
+ * 
+ * @param q уровень квантиля, например 0.5 или 0.99
+ * @return double модуль суммы транзакции
+ */
+double Report::getAmountQuantile(double q) const {
+    return amountSketch.quantile(q);
+}
+
 /**
  * @brief Метод получения всех доходов
  * 
@@ -11,7 +221,10 @@ namespace Reports {
  * @return double 
  */
 double Report::getTotalIncome() const {
-    double total = 0;
+    METRICS_TIMER(ReportAggregate);
+    METRICS_INC(ReportAggregations);
+    double total = archivedIncome;
+    sortRows();
     for (const auto& trans : transactions) {
         if (trans->getAmount() > 0) {
             total += trans->getAmount();
@@ -26,7 +239,10 @@ double Report::getTotalIncome() const {
  * @return double 
 */
 double Report::getTotalExpenses() const {
-    double total = 0;
+    METRICS_TIMER(ReportAggregate);
+    METRICS_INC(ReportAggregations);
+    double total = archivedExpenses;
+    sortRows();
     for (const auto& trans : transactions) {
         if (trans->getAmount() < 0) {
             total += trans->getAmount();
@@ -45,172 +261,102 @@ double Report::getNetBalance() const {
 }
 
 /**
- * @brief Реализация метода вывода текстового отчета в терминал
+ * @brief Запись полного содержимого отчета в поток
  * 
+ * @param os 
  */
-void TextReport::generate() const {
-    std::cout << "=== " << title << " ===\n";
-    std::cout << "Format: " << getFormat() << "\n";
-    std::cout << "Transactions: " << transactions.size() << "\n\n";
-    
-    for (const auto& trans : transactions) {
-        std::cout << *trans << "\n";
-    }
-    
-    std::cout << "\n=== SUMMARY ===\n";
-    std::cout << "Total Income: " << std::fixed << std::setprecision(2) << getTotalIncome() << "\n";
-    std::cout << "Total Expenses: " << getTotalExpenses() << "\n";
-    std::cout << "Net Balance: " << getNetBalance() << "\n";
+void Report::writeTo(std::ostream& os) const {
+    writeHeader(os);
+    writeRows(os, 0, transactions.size());
+    writeFooter(os);
 }
 
 /**
- * @brief Реализация метода вывода текстового отчета в файл
+ * @brief Блоки отчета в строку через потоковые методы
  * 
  */
-void TextReport::saveToFile(const std::string& filename) const {
-    std::ofstream file(filename);
-    if (file.is_open()) {
-        file << "=== " << title << " ===\n";
-        file << "Format: " << getFormat() << "\n\n";
-        
-        for (const auto& trans : transactions) {
-            file << *trans << "\n";
-        }
-        
-        file << "\n=== SUMMARY ===\n";
-        file << "Total Income: " << std::fixed << std::setprecision(2) << getTotalIncome() << "\n";
-        file << "Total Expenses: " << getTotalExpenses() << "\n";
-        file << "Net Balance: " << getNetBalance() << "\n";
-        
-        file.close();
-        std::cout << "Report saved to: " << filename << std::endl;
-    }
+void Report::appendHeader(std::string& out) const {
+    std::ostringstream os;
+    writeHeader(os);
+    out += os.str();
 }
 
-/**
- * @brief Реализация метода вывода CSV отчета в терминал
- * 
- */
-void CSVReport::generate() const {
-    std::cout << "Date,Type,Account,Category,Amount,Description\n";
-    for (const auto& trans : transactions) {
-        std::cout << trans->getFormattedDate() << ","
-        << trans->getType() << ","
-        << trans->getAccountName() << ","
-        << trans->getCategoryName() << ","
-        << trans->getAmount() << ","
-        << "\"" << trans->getDescription() << "\"\n";
-    }
+void Report::appendRows(std::string& out, std::size_t begin, std::size_t end) const {
+    std::ostringstream os;
+    writeRows(os, begin, end);
+    out += os.str();
+}
+
+void Report::appendFooter(std::string& out) const {
+    std::ostringstream os;
+    writeFooter(os);
+    out += os.str();
 }
 
 /**
- * @brief Реализация метода вывода CSV отчета в файл
+ * @brief Полное содержимое отчета в строку
  * 
+ * @param out 
  */
-void CSVReport::saveToFile(const std::string& filename) const {
-    std::ofstream file(filename);
-    if (file.is_open()) {
-        file << "Date,Type,Account,Category,Amount,Description\n";
-        for (const auto& trans : transactions) {
-            file << trans->getFormattedDate() << ","
-            << trans->getType() << ","
-            << trans->getAccountName() << ","
-            << trans->getCategoryName() << ","
-            << trans->getAmount() << ","
-            << "\"" << trans->getDescription() << "\"\n";
-        }
-        file.close();
-        std::cout << "CSV report saved to: " << filename << std::endl;
-    }
+void Report::appendTo(std::string& out) const {
+    appendHeader(out);
+    appendRows(out, 0, transactions.size());
+    appendFooter(out);
 }
 
 /**
- * @brief Реализация метода экранирования служебных символов JSON
+ * @brief Сохранение отчета в файл
  * 
+ * @param filename 
+ * @param message 
  */
-std::string JSONReport::escapeJson(const std::string& str) const {
-    std::stringstream ss;
-    for (char c : str) {
-        switch (c) {
-            case '"': ss << "\\\""; break;
-            case '\\': ss << "\\\\"; break;
-            case '\b': ss << "\\b"; break;
-            case '\f': ss << "\\f"; break;
-            case '\n': ss << "\\n"; break;
-            case '\r': ss << "\\r"; break;
-            case '\t': ss << "\\t"; break;
-            default: ss << c; break;
+void Report::saveWithMessage(const std::string& filename, const char* message) const {
+    METRICS_TIMER(ReportExport);
+    METRICS_INC(ReportExports);
+    METRICS_ADD(ReportExportRows, transactions.size());
+    std::ofstream file(filename, std::ios::binary);
+    if (file.is_open()) {
+        writeTo(file);
+        file.close();
+        if (verbose) {
+            std::cout << message << filename << "\n";
         }
     }
-    return ss.str();
 }
 
+template class FormattedReport<TextFormat>;
+template class FormattedReport<CsvFormat>;
+template class FormattedReport<JsonFormat>;
+
 /**
- * @brief Реализация метода вывода JSON отчета в терминал
+ * @brief Реализация метода экранирования служебных символов JSON
  * 
  */
-void JSONReport::generate() const {
-    std::cout << "{\n";
-    std::cout << "  \"title\": \"" << escapeJson(title) << "\",\n";
-    std::cout << "  \"format\": \"" << getFormat() << "\",\n";
-    std::cout << "  \"transactions\": [\n";
-    
-    for (size_t i = 0; i < transactions.size(); ++i) {
-        const auto& trans = transactions[i];
-        std::cout << "    {\n";
-        std::cout << "      \"date\": \"" << trans->getFormattedDate() << "\",\n";
-        std::cout << "      \"type\": \"" << trans->getType() << "\",\n";
-        std::cout << "      \"account\": \"" << escapeJson(trans->getAccountName()) << "\",\n";
-        std::cout << "      \"category\": \"" << escapeJson(trans->getCategoryName()) << "\",\n";
-        std::cout << "      \"amount\": " << trans->getAmount() << ",\n";
-        std::cout << "      \"description\": \"" << escapeJson(trans->getDescription()) << "\"\n";
-        std::cout << "    }" << (i < transactions.size() - 1 ? "," : "") << "\n";
-    }
-    
-    std::cout << "  ],\n";
-    std::cout << "  \"summary\": {\n";
-    std::cout << "    \"totalIncome\": " << getTotalIncome() << ",\n";
-    std::cout << "    \"totalExpenses\": " << getTotalExpenses() << ",\n";
-    std::cout << "    \"netBalance\": " << getNetBalance() << "\n";
-    std::cout << "  }\n";
-    std::cout << "}\n";
+std::string JSONReport::escapeJson(const std::string& str) {
+    std::string result;
+    result.reserve(str.size());
+    StringSink sink(result);
+    JsonFormat::escape(sink, str);
+    return result;
 }
 
 /**
- * @brief Реализация метода вывода JSON отчета в файл
+ * @brief Фабрика отчетов по названию формата
  * 
+ * @param format 
+ * @param title 
+ * @return std::shared_ptr<Report> 
  */
-void JSONReport::saveToFile(const std::string& filename) const {
-    std::ofstream file(filename);
-    if (file.is_open()) {
-        file << "{\n";
-        file << "  \"title\": \"" << escapeJson(title) << "\",\n";
-        file << "  \"format\": \"" << getFormat() << "\",\n";
-        file << "  \"transactions\": [\n";
-        
-        for (size_t i = 0; i < transactions.size(); ++i) {
-            const auto& trans = transactions[i];
-            file << "    {\n";
-            file << "      \"date\": \"" << trans->getFormattedDate() << "\",\n";
-            file << "      \"type\": \"" << trans->getType() << "\",\n";
-            file << "      \"account\": \"" << escapeJson(trans->getAccountName()) << "\",\n";
-            file << "      \"category\": \"" << escapeJson(trans->getCategoryName()) << "\",\n";
-            file << "      \"amount\": " << std::fixed << std::setprecision(2) << trans->getAmount() << ",\n";
-            file << "      \"description\": \"" << escapeJson(trans->getDescription()) << "\"\n";
-            file << "    }" << (i < transactions.size() - 1 ? "," : "") << "\n";
-        }
-        
-        file << "  ],\n";
-        file << "  \"summary\": {\n";
-        file << "    \"totalIncome\": " << getTotalIncome() << ",\n";
-        file << "    \"totalExpenses\": " << getTotalExpenses() << ",\n";
-        file << "    \"netBalance\": " << getNetBalance() << "\n";
-        file << "  }\n";
-        file << "}\n";
-        
-        file.close();
-        std::cout << "JSON report saved to: " << filename << std::endl;
+std::shared_ptr<Report> createReport(const std::string& format, const std::string& title) {
+    std::string upper;
+    for (char c : format) {
+        upper += static_cast<char>(std::toupper(static_cast<unsigned char>(c)));
     }
+    if (upper == "TEXT" || upper == "TXT") return std::make_shared<TextReport>(title);
+    if (upper == "CSV") return std::make_shared<CSVReport>(title);
+    if (upper == "JSON") return std::make_shared<JSONReport>(title);
+    if (upper == "ARROW" || upper == "FEATHER") return std::make_shared<ArrowReport>(title);
+    return nullptr;
 }
 
 } // namespace Reports
\ No newline at end of file
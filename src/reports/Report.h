@@ -3,7 +3,17 @@
 #include <string>
 #include <vector>
 #include <memory>
+#include <mutex>
+#include <cstddef>
+#include <cstdint>
 #include "../transactions/Transaction.h"
+#include "../utils/TopK.h"
+#include "../utils/QuantileSketch.h"
+#include "../currency/FxRateTable.h"
+#include "ReportFormat.h"
+#include "ReportQuery.h"
+
+namespace Storage { class ColdStore; }
 
 namespace Reports {
 /**
@@ -11,21 +21,72 @@ namespace Reports {
  * 
  */
 class Report {
+public:
+    // Сколько крупнейших списаний отслеживается инкрементально
+    static constexpr std::size_t DEFAULT_TOP_K = 1000;
+
 protected:
     std::string title;
-    std::vector<std::shared_ptr<Transactions::Transaction>> transactions;
+    // При заданной сортировке addTransaction дописывает строки в хвост,
+    // а упорядочивает их sortRows при первом чтении — отсюда mutable
+    mutable std::vector<std::shared_ptr<Transactions::Transaction>> transactions;
+    mutable std::size_t sortedRows = 0;   // длина упорядоченного начала transactions
+    mutable std::mutex rowsMutex;
+
+    // Инкрементальная статистика, обновляется при добавлении транзакций
+    TopK<std::shared_ptr<Transactions::Transaction>> largestWithdrawals;
+    QuantileSketch amountSketch;
+    CurrencyAmounts incomeByCurrency{};
+    CurrencyAmounts expensesByCurrency{};
+
+    // Итоги холодного архива по статистике блоков (addArchive), строк не дают
+    double archivedIncome = 0.0;
+    double archivedExpenses = 0.0;
+    std::size_t archivedCount = 0;
+
+    // Печатать ли сообщение о сохранении файла
+    bool verbose = true;
+
+    // Растет при каждом изменении списка транзакций
+    std::uint64_t revision = 0;
+
+    // Столбцы, фильтры и порядок строк
+    ReportQuery query;
+
+    void indexTransaction(const std::shared_ptr<Transactions::Transaction>& transaction);
+    // Сортирует хвост и сливает его с упорядоченным началом; вызывается перед
+    // чтением строк по порядку, безопасна из нескольких потоков
+    void sortRows() const;
+    // Запись writeTo в файл с учетом метрик; message — префикс сообщения о сохранении
+    void saveWithMessage(const std::string& filename, const char* message) const;
 
 public:
-    Report(const std::string& t) : title(t) {}
+    Report(const std::string& t, std::size_t topK = DEFAULT_TOP_K)
+        : title(t), largestWithdrawals(topK) {}
     virtual ~Report() = default;
 
-    void addTransaction(std::shared_ptr<Transactions::Transaction> transaction) {
-        transactions.push_back(transaction);
-    }
+    // Транзакции, не прошедшие фильтры выборки, пропускаются; при заданной
+    // сортировке строка встает на свое место перед форматированием (O(1) на вызов,
+    // одна сортировка хвоста на пакет добавлений)
+    void addTransaction(std::shared_ptr<Transactions::Transaction> transaction);
 
-    void setTransactions(const std::vector<std::shared_ptr<Transactions::Transaction>>& trans) {
-        transactions = trans;
-    }
+    // Заменяет строки и сбрасывает итоги архива
+    void setTransactions(const std::vector<std::shared_ptr<Transactions::Transaction>>& trans);
+    // Добавляет в итоги транзакции архива за [from, to) и пересечение с датами
+    // выборки. Полностью покрытые блоки учитываются по статистике без распаковки.
+    // false — выборка фильтрует не только по датам, и блоки ее не отвечают
+    bool addArchive(const Storage::ColdStore& archive, TimePoint from, TimePoint to);
+    std::size_t getArchivedCount() const { return archivedCount; }
+
+    // Выборка строк; уже добавленные транзакции отбираются и упорядочиваются заново
+    void setQuery(const ReportQuery& q);
+    const ReportQuery& getQuery() const { return query; }
+    // Пишет ли формат только выбранные столбцы (ReportQuery::columns)
+    virtual bool supportsColumnSelection() const { return false; }
+
+    void setVerbose(bool v) { verbose = v; }
+    std::size_t getTransactionCount() const { return transactions.size(); }
+    std::uint64_t getRevision() const { return revision; }
 
     // Виртуальный метод генерации отчета
     virtual void generate() const = 0;
@@ -36,52 +97,183 @@ public:
     // Виртуальный метод получения формата
     virtual std::string getFormat() const = 0;
 
-    // Общая статистика
+    // Поблочная запись содержимого файла: заголовок, строки [begin, end), итоги.
+    // Блоки независимы, поэтому строки можно форматировать параллельно.
+    virtual void writeHeader(std::ostream& os) const = 0;
+    virtual void writeRows(std::ostream& os, std::size_t begin, std::size_t end) const = 0;
+    virtual void writeFooter(std::ostream& os) const = 0;
+    void writeTo(std::ostream& os) const;
+    // Те же блоки, дописываемые в строку (буферы AsyncExporter и ReportCache).
+    // По умолчанию идут через writeHeader/writeRows/writeFooter
+    virtual void appendHeader(std::string& out) const;
+    virtual void appendRows(std::string& out, std::size_t begin, std::size_t end) const;
+    virtual void appendFooter(std::string& out) const;
+    void appendTo(std::string& out) const;
+    // Кратность начала блока строк: двоичные форматы ссылаются из итогов
+    // на пакеты фиксированного размера, текстовые режутся где угодно
+    virtual std::size_t getRowBlockSize() const { return 1; }
+
+    // Общая статистика, вместе с итогами архива
     double getTotalIncome() const;
     double getTotalExpenses() const;
     double getNetBalance() const;
+
+    // Статистика в целевой валюте: суммы копятся по валютам и пересчитываются
+    // по одному разу на валюту по курсу на момент at. false — курс неизвестен.
+    // Итоги архива сюда не входят: статистика блоков не разбита по валютам
+    bool getTotalIncome(Currency target, const FxRateTable& rates, FxRateTable::TimePoint at, double& result) const;
+    bool getTotalExpenses(Currency target, const FxRateTable& rates, FxRateTable::TimePoint at, double& result) const;
+    bool getNetBalance(Currency target, const FxRateTable& rates, FxRateTable::TimePoint at, double& result) const;
+
+    // Ранжирование и квантили без полной сортировки
+    std::vector<std::shared_ptr<Transactions::Transaction>> getLargestWithdrawals(std::size_t k) const;
+    double getAmountQuantile(double q) const;
+};
+
+/**
+ * @brief Текстовый отчет, собранный из формата и списка столбцов (ReportFormat.h)
+ *
+ * Цикл по строкам один на все форматы и приемники: generate и writeRows
+ * пишут через буферизованный StreamSink, appendRows — сразу в строку.
+ * Поля берутся без промежуточных строк, числа форматируются std::to_chars.
+ */
+template<typename Format>
+class FormattedReport : public Report {
+public:
+    using Report::Report;
+
+    void generate() const override {
+        StreamSink sink(std::cout);
+        writeAll(sink);
+    }
+    void saveToFile(const std::string& filename) const override {
+        saveWithMessage(filename, Format::SAVED_MESSAGE);
+    }
+    std::string getFormat() const override { return std::string(Format::NAME); }
+    bool supportsColumnSelection() const override { return true; }
+
+    void writeHeader(std::ostream& os) const override {
+        StreamSink sink(os);
+        Format::header(sink, title, query.columns);
+    }
+    void writeRows(std::ostream& os, std::size_t begin, std::size_t end) const override {
+        StreamSink sink(os);
+        writeRowRange(sink, begin, end);
+    }
+    void writeFooter(std::ostream& os) const override {
+        StreamSink sink(os);
+        writeSummary(sink);
+    }
+
+    void appendHeader(std::string& out) const override {
+        StringSink sink(out);
+        Format::header(sink, title, query.columns);
+    }
+    void appendRows(std::string& out, std::size_t begin, std::size_t end) const override {
+        StringSink sink(out);
+        writeRowRange(sink, begin, end);
+    }
+    void appendFooter(std::string& out) const override {
+        StringSink sink(out);
+        writeSummary(sink);
+    }
+
+private:
+    template<typename Sink>
+    void writeAll(Sink& sink) const {
+        Format::header(sink, title, query.columns);
+        writeRowRange(sink, 0, transactions.size());
+        writeSummary(sink);
+    }
+
+    template<typename Sink>
+    void writeRowRange(Sink& sink, std::size_t begin, std::size_t end) const {
+        if (query.columns.empty()) {
+            // Все столбцы: список известен при компиляции, ячейки развернуты
+            forEachRow(sink, begin, end, [&](const Transactions::Transaction& trans) {
+                Format::ColumnList::forEach([&](auto field, auto index) {
+                    using Field = decltype(field);
+                    if constexpr (decltype(index)::value > 0) {
+                        Format::separator(sink);
+                    }
+                    Format::template cell<Field>(sink, Field::get(trans));
+                });
+            });
+        } else {
+            // Выбранные столбцы: вычисляются только их поля
+            const ColumnSelection& columns = query.columns;
+            forEachRow(sink, begin, end, [&](const Transactions::Transaction& trans) {
+                for (std::size_t c = 0; c < columns.size(); ++c) {
+                    if (c > 0) {
+                        Format::separator(sink);
+                    }
+                    Format::ColumnList::visit(static_cast<std::size_t>(columns[c]), [&](auto field) {
+                        using Field = decltype(field);
+                        Format::template cell<Field>(sink, Field::get(trans));
+                    });
+                }
+            });
+        }
+    }
+
+    template<typename Sink, typename WriteCells>
+    void forEachRow(Sink& sink, std::size_t begin, std::size_t end, WriteCells writeCells) const {
+        this->sortRows();
+        for (std::size_t i = begin; i < end; ++i) {
+            Format::beginRow(sink);
+            writeCells(*transactions[i]);
+            Format::endRow(sink, i + 1 == transactions.size());
+            sink.commit();
+        }
+    }
+
+    template<typename Sink>
+    void writeSummary(Sink& sink) const {
+        Format::footer(sink, getTotalIncome(), getTotalExpenses());
+    }
 };
 
+extern template class FormattedReport<TextFormat>;
+extern template class FormattedReport<CsvFormat>;
+extern template class FormattedReport<JsonFormat>;
+
 /**
  * @brief Интерфейс класса текстового отчета
  * 
  */
-class TextReport : public Report {
+class TextReport : public FormattedReport<TextFormat> {
 public:
-    TextReport(const std::string& t) : Report(t) {}
-
-    void generate() const override;
-    void saveToFile(const std::string& filename) const override;
-    std::string getFormat() const override { return "TEXT"; }
+    TextReport(const std::string& t) : FormattedReport(t) {}
 };
 
 /**
  * @brief Интерфейс класса CSV отчета
  * 
  */
-class CSVReport : public Report {
+class CSVReport : public FormattedReport<CsvFormat> {
 public:
-    CSVReport(const std::string& t) : Report(t) {}
-
-    void generate() const override;
-    void saveToFile(const std::string& filename) const override;
-    std::string getFormat() const override { return "CSV"; }
+    CSVReport(const std::string& t) : FormattedReport(t) {}
 };
 
 /**
  * @brief Интерфейс класса JSON отчета
  * 
  */
-class JSONReport : public Report {
-private:
-    std::string escapeJson(const std::string& str) const;
-
+class JSONReport : public FormattedReport<JsonFormat> {
 public:
-    JSONReport(const std::string& t) : Report(t) {}
+    JSONReport(const std::string& t) : FormattedReport(t) {}
 
-    void generate() const override;
-    void saveToFile(const std::string& filename) const override;
-    std::string getFormat() const override { return "JSON"; }
+    /**
+     * @brief Экранирование служебных символов строки JSON
+     */
+    static std::string escapeJson(const std::string& str);
 };
 
+/**
+ * @brief Создание отчета по названию формата (TEXT, CSV, JSON; регистр не важен)
+ * 
+ * @return Указатель на отчет или nullptr для неизвестного формата
+ */
+std::shared_ptr<Report> createReport(const std::string& format, const std::string& title);
+
 } // namespace Reports
\ No newline at end of file
@@ -0,0 +1,219 @@
+#include "ReportCache.h"
+#include <algorithm>
+#include <fstream>
+#include <sstream>
+#include "../metrics/Metrics.h"
+
+namespace Reports {
+
+namespace {
+
+bool inRange(const Transactions::Transaction& trans, ReportCache::TimePoint from, ReportCache::TimePoint to) {
+    auto date = trans.getDate();
+    return date >= from && date < to;
+}
+
+} // namespace
+
+ReportCache::ReportCache(std::size_t budgetBytes) : budget(budgetBytes) {}
+
+std::string ReportCache::makeKey(const User& user, const std::string& format, TimePoint from, TimePoint to) {
+    std::ostringstream os;
+    os << user.getName() << '\0' << format << '\0'
+       << from.time_since_epoch().count() << '\0' << to.time_since_epoch().count();
+    return os.str();
+}
+
+/**
+ * @brief Оценка памяти записи: текст, указатели на транзакции и куча крупнейших списаний
+ */
+std::size_t ReportCache::estimateBytes(const Entry& entry) {
+    std::size_t rows = entry.report ? entry.report->getTransactionCount() : 0;
+    std::size_t topK = std::min(rows, Report::DEFAULT_TOP_K);
+    return sizeof(Entry) + entry.key.size() * 2
+         + (entry.text ? entry.text->capacity() : 0)
+         + rows * sizeof(std::shared_ptr<Transactions::Transaction>)
+         + topK * (sizeof(double) + sizeof(std::shared_ptr<Transactions::Transaction>));
+}
+
+/**
+ * @brief Полное построение отчета по текущей истории
+ */
+void ReportCache::rebuild(Entry& entry, const User& user, const std::string& format,
+                          TimePoint from, TimePoint to) {
+    METRICS_INC(ReportCacheMisses);
+    entry.report = createReport(format, user.getName());
+    entry.report->setVerbose(false);
+    const auto& history = user.getTransactions();
+    for (const auto& trans : history) {
+        if (inRange(*trans, from, to)) {
+            entry.report->addTransaction(trans);
+        }
+    }
+    entry.scanned = history.size();
+    entry.report->addArchive(user.getArchive(), from, to);
+
+    writeText(entry, 0);
+}
+
+/**
+ * @brief Дописывание в запись транзакций, добавленных в конец истории
+ */
+void ReportCache::append(Entry& entry, const User& user, TimePoint from, TimePoint to) {
+    METRICS_INC(ReportCacheAppends);
+    const auto& history = user.getTransactions();
+    std::size_t oldRows = entry.report->getTransactionCount();
+    for (std::size_t i = entry.scanned; i < history.size(); ++i) {
+        if (inRange(*history[i], from, to)) {
+            entry.report->addTransaction(history[i]);
+        }
+    }
+    entry.scanned = history.size();
+
+    if (entry.report->getTransactionCount() != oldRows) {
+        writeText(entry, oldRows);
+    }
+}
+
+/**
+ * @brief Текст отчета, строки [0, keptRows - 1) берутся из прежнего текста
+ *
+ * Последняя строка пишется отдельно: в JSON после нее нет запятой, и при
+ * дописывании новых строк она перепишется. Двоичные форматы с пакетами
+ * строк (getRowBlockSize() > 1) каждый раз пишутся целиком.
+ */
+void ReportCache::writeText(Entry& entry, std::size_t keptRows) {
+    const Report& report = *entry.report;
+    std::size_t rows = report.getTransactionCount();
+    auto text = std::make_shared<std::string>();
+    if (report.getRowBlockSize() != 1) {
+        report.appendTo(*text);
+        entry.bodyEnd = 0;
+    } else {
+        std::size_t kept = keptRows ? keptRows - 1 : 0;
+        if (kept == 0) {
+            report.appendHeader(*text);
+        } else {
+            text->reserve(entry.text->size() + entry.text->size() / 2);
+            text->assign(*entry.text, 0, entry.bodyEnd);
+        }
+        report.appendRows(*text, kept, rows ? rows - 1 : 0);
+        entry.bodyEnd = text->size();
+        report.appendRows(*text, rows ? rows - 1 : 0, rows);
+        report.appendFooter(*text);
+    }
+    entry.text = std::move(text);
+}
+
+std::shared_ptr<const std::string> ReportCache::render(const User& user, const std::string& format,
+                                                       TimePoint from, TimePoint to) {
+    auto probe = createReport(format, user.getName());
+    if (!probe) {
+        return nullptr;
+    }
+    std::string key = makeKey(user, probe->getFormat(), from, to);
+
+    std::shared_ptr<Entry> entry;
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        auto it = index.find(key);
+        if (it != index.end()) {
+            lru.splice(lru.begin(), lru, it->second);
+            entry = *it->second;
+        } else {
+            entry = std::make_shared<Entry>();
+            entry->key = key;
+            lru.push_front(entry);
+            index.emplace(key, lru.begin());
+        }
+    }
+
+    std::shared_ptr<const std::string> text;
+    std::size_t entryBytes;
+    {
+        std::lock_guard<std::mutex> lock(entry->mutex);
+        std::uint64_t version = user.getHistoryVersion();
+        if (entry->report && entry->user == &user && entry->version == version) {
+            METRICS_INC(ReportCacheHits);
+            return entry->text;
+        }
+        if (entry->report && entry->user == &user && user.isAppendOnlySince(entry->version)
+            && entry->scanned <= user.getTransactions().size()) {
+            append(*entry, user, from, to);
+        } else {
+            entry->user = &user;
+            rebuild(*entry, user, probe->getFormat(), from, to);
+        }
+        entry->version = version;
+        text = entry->text;
+        entryBytes = estimateBytes(*entry);
+    }
+
+    std::lock_guard<std::mutex> lock(mutex);
+    if (entry->linked) {
+        bytes = bytes - entry->bytes + entryBytes;
+        entry->bytes = entryBytes;
+        evictLocked();
+    }
+    return text;
+}
+
+bool ReportCache::saveToFile(const User& user, const std::string& format, const std::string& filename,
+                             TimePoint from, TimePoint to) {
+    auto text = render(user, format, from, to);
+    if (!text) {
+        return false;
+    }
+    std::ofstream file(filename, std::ios::binary);
+    file.write(text->data(), static_cast<std::streamsize>(text->size()));
+    return static_cast<bool>(file);
+}
+
+/**
+ * @brief Вытеснение самых давних записей, пока размер больше бюджета
+ *
+ * Только что обновленная запись стоит в начале списка и вытесняется последней:
+ * если она одна больше бюджета, кэш после вызова пуст.
+ */
+void ReportCache::evictLocked() {
+    while (bytes > budget && !lru.empty()) {
+        auto& victim = lru.back();
+        victim->linked = false;
+        bytes -= victim->bytes;
+        index.erase(victim->key);
+        lru.pop_back();
+    }
+}
+
+void ReportCache::setBudget(std::size_t budgetBytes) {
+    std::lock_guard<std::mutex> lock(mutex);
+    budget = budgetBytes;
+    evictLocked();
+}
+
+void ReportCache::clear() {
+    std::lock_guard<std::mutex> lock(mutex);
+    for (auto& entry : lru) {
+        entry->linked = false;
+    }
+    lru.clear();
+    index.clear();
+    bytes = 0;
+}
+
+std::size_t ReportCache::getBudget() const {
+    std::lock_guard<std::mutex> lock(mutex);
+    return budget;
+}
+
+std::size_t ReportCache::getBytes() const {
+    std::lock_guard<std::mutex> lock(mutex);
+    return bytes;
+}
+
+std::size_t ReportCache::size() const {
+    std::lock_guard<std::mutex> lock(mutex);
+    return lru.size();
+}
+
+} // namespace Reports
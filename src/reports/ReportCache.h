@@ -0,0 +1,101 @@
+#pragma once
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <list>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include "Report.h"
+#include "../users/User.h"
+
+namespace Reports {
+
+/**
+ * @brief Кэш готовых отчетов
+ *
+ * Ключ — пользователь, формат и диапазон дат [from, to); запись помнит версию
+ * истории пользователя (User::getHistoryVersion), по которой построена.
+ * Совпала версия — отдается готовый текст без пересчета. Если с тех пор
+ * в историю только дописывались транзакции, запись обновляется на месте:
+ * новые транзакции добавляются в отчет (агрегаты инкрементальные), в текст
+ * дописываются только их строки, заново пишутся последняя строка и итоги.
+ * Любое другое изменение истории (отмена, откат импорта, архивация)
+ * ведет к полному пересчету. Итоги отчета включают холодный архив
+ * пользователя за тот же диапазон (Report::addArchive).
+ *
+ * Записи вытесняются в порядке LRU, когда их оценочный размер превышает бюджет.
+ * Методы потокобезопасны; разные отчеты строятся параллельно, одинаковые —
+ * по очереди. История пользователя не должна меняться во время построения.
+ */
+class ReportCache {
+public:
+    using TimePoint = std::chrono::system_clock::time_point;
+
+    static constexpr std::size_t DEFAULT_BUDGET = std::size_t(64) << 20;
+
+    /**
+     * @param budgetBytes Предел оценочного размера всех записей
+     */
+    explicit ReportCache(std::size_t budgetBytes = DEFAULT_BUDGET);
+
+    ReportCache(const ReportCache&) = delete;
+    ReportCache& operator=(const ReportCache&) = delete;
+
+    /**
+     * @brief Текст отчета в формате writeTo
+     * @param user Пользователь, заголовок отчета — его имя
+     * @param format Формат, как в createReport
+     * @param from Начало диапазона дат (включительно)
+     * @param to Конец диапазона дат (не включительно)
+     * @return Текст отчета или nullptr для неизвестного формата
+     */
+    std::shared_ptr<const std::string> render(const User& user, const std::string& format,
+                                              TimePoint from = TimePoint::min(),
+                                              TimePoint to = TimePoint::max());
+    /**
+     * @brief Сохраняет отчет из кэша в файл
+     * @return false если формат неизвестен или файл не записан
+     */
+    bool saveToFile(const User& user, const std::string& format, const std::string& filename,
+                    TimePoint from = TimePoint::min(), TimePoint to = TimePoint::max());
+
+    void setBudget(std::size_t budgetBytes);
+    void clear();
+
+    std::size_t getBudget() const;
+    std::size_t getBytes() const;
+    std::size_t size() const;
+
+private:
+    struct Entry {
+        std::mutex mutex;               // строит запись один поток
+        std::string key;
+        const User* user = nullptr;
+        std::shared_ptr<Report> report;
+        std::uint64_t version = 0;      // версия истории, по которой построена запись
+        std::size_t scanned = 0;        // сколько транзакций истории просмотрено
+        std::size_t bodyEnd = 0;        // конец строк [0, n - 1) в тексте (текстовые форматы)
+        std::shared_ptr<const std::string> text;
+        std::size_t bytes = 0;          // учтенный в кэше размер
+        bool linked = true;             // запись еще не вытеснена
+    };
+    using EntryList = std::list<std::shared_ptr<Entry>>;
+
+    mutable std::mutex mutex;
+    EntryList lru;                      // в начале — самые свежие
+    std::unordered_map<std::string, EntryList::iterator> index;
+    std::size_t budget;
+    std::size_t bytes = 0;
+
+    static std::string makeKey(const User& user, const std::string& format, TimePoint from, TimePoint to);
+    static std::size_t estimateBytes(const Entry& entry);
+
+    void rebuild(Entry& entry, const User& user, const std::string& format, TimePoint from, TimePoint to);
+    void append(Entry& entry, const User& user, TimePoint from, TimePoint to);
+    void writeText(Entry& entry, std::size_t keptRows);
+    void evictLocked();
+};
+
+} // namespace Reports
@@ -0,0 +1,432 @@
+#pragma once
+#include <array>
+#include <charconv>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <ostream>
+#include <string>
+#include <string_view>
+#include <type_traits>
+#include <utility>
+#include <vector>
+#include "../accounts/Account.h"
+#include "../categories/Category.h"
+#include "../transactions/Transaction.h"
+#include "../utils/DateUtils.h"
+
+/**
+ * @file ReportFormat.h
+ * @brief Строительные блоки текстовых отчетов: приемники, столбцы и форматы
+ *
+ * Строка отчета собирается из трех независимых частей:
+ *  - приемник (Sink) — куда пишутся байты и как форматируются числа и даты;
+ *  - список столбцов (Columns) — какие поля транзакции и в каком порядке;
+ *  - формат (TextFormat, CsvFormat, JsonFormat) — оформление ячеек и строк.
+ * FormattedReport (Report.h) соединяет их в один цикл по строкам, который
+ * компилятор разворачивает отдельно для каждой пары формат/приемник. Новый
+ * столбец — это новое поле в списке, новый формат — новая структура с тем же
+ * набором статических методов.
+ */
+
+namespace Reports {
+
+using TimePoint = std::chrono::system_clock::time_point;
+
+/**
+ * @brief Приемник, дописывающий в строку
+ *
+ * Числа пишутся через std::to_chars: number — как поток по умолчанию (%g),
+ * fixed — с фиксированным числом знаков (%.Nf). Локаль и состояние потока
+ * на результат не влияют.
+ */
+class StringSink {
+public:
+    explicit StringSink(std::string& target) : out(target) {}
+
+    void write(char c) { out.push_back(c); }
+    void write(std::string_view s) { out.append(s.data(), s.size()); }
+
+    void number(double value) {
+        char buffer[32];
+        auto result = std::to_chars(buffer, buffer + sizeof(buffer), value, std::chars_format::general, 6);
+        out.append(buffer, result.ptr);
+    }
+
+    void fixed(double value, int precision) {
+        char buffer[400]; // DBL_MAX в фиксированной записи — 309 цифр
+        auto result = std::to_chars(buffer, buffer + sizeof(buffer), value, std::chars_format::fixed, precision);
+        out.append(buffer, result.ptr);
+    }
+
+    void date(TimePoint tp) {
+        char buffer[DateUtils::FORMATTED_TIME_POINT_SIZE + 8];
+        out.append(buffer, DateUtils::formatTimePoint(tp, buffer, sizeof(buffer)));
+    }
+
+    // Граница строки отчета: здесь буферизующий приемник может сбросить данные
+    void commit() {}
+
+protected:
+    std::string& out;
+};
+
+namespace detail {
+struct SinkBuffer {
+    std::string buffer;
+};
+} // namespace detail
+
+/**
+ * @brief Приемник для std::ostream: копит байты и сбрасывает их крупными блоками
+ *
+ * Остаток сбрасывается в деструкторе.
+ */
+class StreamSink : private detail::SinkBuffer, public StringSink {
+public:
+    static constexpr std::size_t FLUSH_BYTES = std::size_t(64) << 10;
+
+    explicit StreamSink(std::ostream& target) : StringSink(buffer), os(target) {
+        buffer.reserve(FLUSH_BYTES + 4096);
+    }
+    ~StreamSink() { flush(); }
+
+    StreamSink(const StreamSink&) = delete;
+    StreamSink& operator=(const StreamSink&) = delete;
+
+    void commit() {
+        if (buffer.size() >= FLUSH_BYTES) {
+            flush();
+        }
+    }
+
+    void flush() {
+        os.write(buffer.data(), static_cast<std::streamsize>(buffer.size()));
+        buffer.clear();
+    }
+
+private:
+    std::ostream& os;
+};
+
+/**
+ * @brief Поля транзакции, доступные как столбцы отчета
+ *
+ * header — заголовок столбца (CSV), key — имя поля (JSON), quoted — значение
+ * берется в кавычки в CSV. get возвращает double, TimePoint или строку;
+ * string_view указывает на данные самой транзакции, поэтому не копирует.
+ */
+namespace Fields {
+
+struct Date {
+    static constexpr std::string_view header = "Date";
+    static constexpr std::string_view key = "date";
+    static constexpr bool quoted = false;
+    static TimePoint get(const Transactions::Transaction& t) { return t.getDate(); }
+};
+
+struct Type {
+    static constexpr std::string_view header = "Type";
+    static constexpr std::string_view key = "type";
+    static constexpr bool quoted = false;
+    static std::string get(const Transactions::Transaction& t) { return t.getType(); }
+};
+
+struct Account {
+    static constexpr std::string_view header = "Account";
+    static constexpr std::string_view key = "account";
+    static constexpr bool quoted = false;
+    static std::string_view get(const Transactions::Transaction& t) {
+        const auto& account = t.getAccount();
+        return account ? std::string_view(account->getName()) : std::string_view("No Account");
+    }
+};
+
+struct Category {
+    static constexpr std::string_view header = "Category";
+    static constexpr std::string_view key = "category";
+    static constexpr bool quoted = false;
+    static std::string_view get(const Transactions::Transaction& t) {
+        const auto& category = t.getCategory();
+        return category ? std::string_view(category->getName()) : std::string_view("Uncategorized");
+    }
+};
+
+struct Amount {
+    static constexpr std::string_view header = "Amount";
+    static constexpr std::string_view key = "amount";
+    static constexpr bool quoted = false;
+    static double get(const Transactions::Transaction& t) { return t.getAmount(); }
+};
+
+struct Description {
+    static constexpr std::string_view header = "Description";
+    static constexpr std::string_view key = "description";
+    static constexpr bool quoted = true;
+    static std::string_view get(const Transactions::Transaction& t) { return t.getDescription(); }
+};
+
+} // namespace Fields
+
+namespace detail {
+
+template<typename... Fields>
+constexpr std::size_t headerLineLength() {
+    return (Fields::header.size() + ... + 0) + sizeof...(Fields);
+}
+
+template<typename... Fields>
+constexpr std::array<char, headerLineLength<Fields...>()> makeHeaderLine() {
+    std::array<char, headerLineLength<Fields...>()> line{};
+    const std::string_view names[] = {Fields::header...};
+    std::size_t pos = 0;
+    for (std::size_t i = 0; i < sizeof...(Fields); ++i) {
+        for (char c : names[i]) {
+            line[pos++] = c;
+        }
+        line[pos++] = i + 1 < sizeof...(Fields) ? ',' : '\n';
+    }
+    return line;
+}
+
+} // namespace detail
+
+/**
+ * @brief Список столбцов, известный при компиляции
+ */
+template<typename... Fields>
+struct Columns {
+    static constexpr std::size_t count = sizeof...(Fields);
+
+    // Заголовки через запятую с переводом строки: "Date,Type,...\n"
+    static constexpr std::array<char, detail::headerLineLength<Fields...>()> headerLine =
+        detail::makeHeaderLine<Fields...>();
+
+    static constexpr std::string_view getHeaderLine() {
+        return std::string_view(headerLine.data(), headerLine.size());
+    }
+
+    /**
+     * @brief Вызывает f(Field{}, index) для каждого столбца по порядку
+     */
+    template<typename F>
+    static void forEach(F&& f) {
+        forEachImpl(f, std::make_index_sequence<count>{});
+    }
+
+    /**
+     * @brief Вызывает f(Field{}) для столбца с номером index, выбранного во время работы
+     */
+    template<typename F>
+    static void visit(std::size_t index, F&& f) {
+        visitImpl(index, f, std::make_index_sequence<count>{});
+    }
+
+private:
+    template<typename F, std::size_t... I>
+    static void forEachImpl(F& f, std::index_sequence<I...>) {
+        (f(Fields{}, std::integral_constant<std::size_t, I>{}), ...);
+    }
+
+    template<typename F, std::size_t... I>
+    static void visitImpl(std::size_t index, F& f, std::index_sequence<I...>) {
+        ((index == I ? (f(Fields{}), true) : false) || ...);
+    }
+};
+
+using TransactionColumns = Columns<Fields::Date, Fields::Type, Fields::Account,
+                                   Fields::Category, Fields::Amount, Fields::Description>;
+
+/**
+ * @brief Номер столбца в TransactionColumns, для выбора столбцов во время работы
+ */
+enum class Column : std::uint8_t { Date, Type, Account, Category, Amount, Description };
+
+static_assert(TransactionColumns::count == static_cast<std::size_t>(Column::Description) + 1,
+              "Column must list TransactionColumns in order");
+
+// Выбранные столбцы; пустой список — все столбцы TransactionColumns
+using ColumnSelection = std::vector<Column>;
+
+/**
+ * @brief Текстовый формат: строки "поле | поле | ...", итоги в конце
+ */
+struct TextFormat {
+    static constexpr std::string_view NAME = "TEXT";
+    static constexpr const char* SAVED_MESSAGE = "Report saved to: ";
+    using ColumnList = TransactionColumns;
+
+    template<typename Sink>
+    static void header(Sink& sink, std::string_view title, const ColumnSelection&) {
+        sink.write("=== ");
+        sink.write(title);
+        sink.write(" ===\nFormat: TEXT\n\n");
+    }
+
+    template<typename Sink>
+    static void beginRow(Sink&) {}
+
+    template<typename Sink>
+    static void separator(Sink& sink) { sink.write(" | "); }
+
+    template<typename Field, typename Sink, typename Value>
+    static void cell(Sink& sink, const Value& value) {
+        if constexpr (std::is_same_v<Value, double>) {
+            if (value >= 0) {
+                sink.write('+');
+            }
+            sink.number(value);
+        } else if constexpr (std::is_same_v<Value, TimePoint>) {
+            sink.date(value);
+        } else {
+            sink.write(std::string_view(value));
+        }
+    }
+
+    template<typename Sink>
+    static void endRow(Sink& sink, bool) { sink.write('\n'); }
+
+    template<typename Sink>
+    static void footer(Sink& sink, double income, double expenses) {
+        sink.write("\n=== SUMMARY ===\nTotal Income: ");
+        sink.fixed(income, 2);
+        sink.write("\nTotal Expenses: ");
+        sink.fixed(expenses, 2);
+        sink.write("\nNet Balance: ");
+        sink.fixed(income + expenses, 2);
+        sink.write('\n');
+    }
+};
+
+/**
+ * @brief CSV: строка заголовков и по строке на транзакцию, без итогов
+ */
+struct CsvFormat {
+    static constexpr std::string_view NAME = "CSV";
+    static constexpr const char* SAVED_MESSAGE = "CSV report saved to: ";
+    using ColumnList = TransactionColumns;
+
+    template<typename Sink>
+    static void header(Sink& sink, std::string_view, const ColumnSelection& columns) {
+        if (columns.empty()) {
+            sink.write(ColumnList::getHeaderLine());
+            return;
+        }
+        for (std::size_t i = 0; i < columns.size(); ++i) {
+            ColumnList::visit(static_cast<std::size_t>(columns[i]), [&](auto field) {
+                sink.write(decltype(field)::header);
+            });
+            sink.write(i + 1 < columns.size() ? ',' : '\n');
+        }
+    }
+
+    template<typename Sink>
+    static void beginRow(Sink&) {}
+
+    template<typename Sink>
+    static void separator(Sink& sink) { sink.write(','); }
+
+    template<typename Field, typename Sink, typename Value>
+    static void cell(Sink& sink, const Value& value) {
+        if constexpr (std::is_same_v<Value, double>) {
+            sink.number(value);
+        } else if constexpr (std::is_same_v<Value, TimePoint>) {
+            sink.date(value);
+        } else if constexpr (Field::quoted) {
+            sink.write('"');
+            sink.write(std::string_view(value));
+            sink.write('"');
+        } else {
+            sink.write(std::string_view(value));
+        }
+    }
+
+    template<typename Sink>
+    static void endRow(Sink& sink, bool) { sink.write('\n'); }
+
+    template<typename Sink>
+    static void footer(Sink&, double, double) {}
+};
+
+/**
+ * @brief JSON: объект с заголовком, массивом транзакций и итогами
+ *
+ * Суммы пишутся с двумя знаками после запятой, строки экранируются.
+ */
+struct JsonFormat {
+    static constexpr std::string_view NAME = "JSON";
+    static constexpr const char* SAVED_MESSAGE = "JSON report saved to: ";
+    using ColumnList = TransactionColumns;
+
+    /**
+     * @brief Экранирование служебных символов; участки без них пишутся целиком
+     */
+    template<typename Sink>
+    static void escape(Sink& sink, std::string_view s) {
+        std::size_t start = 0;
+        for (std::size_t i = 0; i < s.size(); ++i) {
+            const char* replacement = nullptr;
+            switch (s[i]) {
+                case '"': replacement = "\\\""; break;
+                case '\\': replacement = "\\\\"; break;
+                case '\b': replacement = "\\b"; break;
+                case '\f': replacement = "\\f"; break;
+                case '\n': replacement = "\\n"; break;
+                case '\r': replacement = "\\r"; break;
+                case '\t': replacement = "\\t"; break;
+                default: continue;
+            }
+            sink.write(s.substr(start, i - start));
+            sink.write(std::string_view(replacement));
+            start = i + 1;
+        }
+        sink.write(s.substr(start));
+    }
+
+    template<typename Sink>
+    static void header(Sink& sink, std::string_view title, const ColumnSelection&) {
+        sink.write("{\n  \"title\": \"");
+        escape(sink, title);
+        sink.write("\",\n  \"format\": \"JSON\",\n  \"transactions\": [\n");
+    }
+
+    template<typename Sink>
+    static void beginRow(Sink& sink) { sink.write("    {\n"); }
+
+    template<typename Sink>
+    static void separator(Sink& sink) { sink.write(",\n"); }
+
+    template<typename Field, typename Sink, typename Value>
+    static void cell(Sink& sink, const Value& value) {
+        sink.write("      \"");
+        sink.write(Field::key);
+        sink.write("\": ");
+        if constexpr (std::is_same_v<Value, double>) {
+            sink.fixed(value, 2);
+        } else if constexpr (std::is_same_v<Value, TimePoint>) {
+            sink.write('"');
+            sink.date(value);
+            sink.write('"');
+        } else {
+            sink.write('"');
+            escape(sink, std::string_view(value));
+            sink.write('"');
+        }
+    }
+
+    template<typename Sink>
+    static void endRow(Sink& sink, bool last) { sink.write(last ? "\n    }\n" : "\n    },\n"); }
+
+    template<typename Sink>
+    static void footer(Sink& sink, double income, double expenses) {
+        sink.write("  ],\n  \"summary\": {\n    \"totalIncome\": ");
+        sink.fixed(income, 2);
+        sink.write(",\n    \"totalExpenses\": ");
+        sink.fixed(expenses, 2);
+        sink.write(",\n    \"netBalance\": ");
+        sink.fixed(income + expenses, 2);
+        sink.write("\n  }\n}\n");
+    }
+};
+
+} // namespace Reports
@@ -0,0 +1,196 @@
+#include "ReportQuery.h"
+#include <algorithm>
+#include <cctype>
+#include <sstream>
+
+namespace Reports {
+
+namespace {
+
+std::vector<std::string> splitList(const std::string& value) {
+    std::vector<std::string> items;
+    std::istringstream ss(value);
+    std::string item;
+    while (std::getline(ss, item, ',')) {
+        if (!item.empty()) {
+            items.push_back(item);
+        }
+    }
+    return items;
+}
+
+std::string toUpper(std::string text) {
+    for (char& c : text) {
+        c = static_cast<char>(std::toupper(static_cast<unsigned char>(c)));
+    }
+    return text;
+}
+
+bool contains(const std::vector<std::string>& names, const std::string& name) {
+    return std::find(names.begin(), names.end(), name) != names.end();
+}
+
+bool parseColumn(const std::string& name, Column& column) {
+    bool found = false;
+    TransactionColumns::forEach([&](auto field, auto index) {
+        if (!found && name == decltype(field)::key) {
+            column = static_cast<Column>(decltype(index)::value);
+            found = true;
+        }
+    });
+    return found;
+}
+
+bool parseAmount(const std::string& text, double& amount) {
+    try {
+        std::size_t used = 0;
+        amount = std::stod(text, &used);
+        return used == text.size();
+    } catch (...) {
+        return false;
+    }
+}
+
+bool parseDate(const std::string& text, TimePoint& tp) {
+    return DateUtils::parseTimePoint(text.size() == 10 ? text + " 00:00:00" : text, tp);
+}
+
+/**
+ * @brief Сравнение по одному столбцу на сырых значениях: -1, 0 или 1
+ */
+int compareColumn(Column column, const Transactions::Transaction& a, const Transactions::Transaction& b) {
+    int result = 0;
+    TransactionColumns::visit(static_cast<std::size_t>(column), [&](auto field) {
+        using Field = decltype(field);
+        auto x = Field::get(a);
+        auto y = Field::get(b);
+        result = x < y ? -1 : (y < x ? 1 : 0);
+    });
+    return result;
+}
+
+} // namespace
+
+bool ReportQuery::isFiltered() const {
+    return !types.empty() || !accounts.empty() || !categories.empty() ||
+           minAmount > -std::numeric_limits<double>::infinity() ||
+           maxAmount < std::numeric_limits<double>::infinity() ||
+           from != TimePoint::min() || to != TimePoint::max();
+}
+
+/**
+ * @brief Проверка фильтров; сначала дешевые сравнения чисел и дат
+ */
+bool ReportQuery::matches(const Transactions::Transaction& trans) const {
+    double amount = trans.getAmount();
+    if (amount < minAmount || amount > maxAmount) {
+        return false;
+    }
+    auto date = trans.getDate();
+    if (date < from || date >= to) {
+        return false;
+    }
+    if (!types.empty() && !contains(types, trans.getType())) {
+        return false;
+    }
+    if (!accounts.empty()) {
+        const auto& account = trans.getAccount();
+        if (!account || !contains(accounts, account->getName())) {
+            return false;
+        }
+    }
+    if (!categories.empty()) {
+        const ::Category* category = trans.getCategory().get();
+        while (category && !contains(categories, category->getName())) {
+            category = category->getParent().get();
+        }
+        if (!category) {
+            return false;
+        }
+    }
+    return true;
+}
+
+bool ReportQuery::less(const Transactions::Transaction& a, const Transactions::Transaction& b) const {
+    for (const auto& key : sort) {
+        int c = compareColumn(key.column, a, b);
+        if (c != 0) {
+            return key.descending ? c > 0 : c < 0;
+        }
+    }
+    return false;
+}
+
+bool ReportQuery::set(const std::string& key, const std::string& value, std::string& error) {
+    if (key == "columns") {
+        columns.clear();
+        for (const auto& name : splitList(value)) {
+            Column column;
+            if (!parseColumn(name, column)) {
+                error = "unknown column " + name;
+                return false;
+            }
+            columns.push_back(column);
+        }
+    } else if (key == "type") {
+        types.clear();
+        for (const auto& name : splitList(value)) {
+            std::string type = toUpper(name);
+            if (type != "DEPOSIT" && type != "WITHDRAWAL" && type != "COMPOUNDING") {
+                error = "unknown transaction type " + name;
+                return false;
+            }
+            types.push_back(type);
+        }
+    } else if (key == "account") {
+        accounts = splitList(value);
+    } else if (key == "category") {
+        categories = splitList(value);
+    } else if (key == "min" || key == "max") {
+        if (!parseAmount(value, key == "min" ? minAmount : maxAmount)) {
+            error = "invalid amount " + key + "=" + value;
+            return false;
+        }
+    } else if (key == "from" || key == "to") {
+        if (!parseDate(value, key == "from" ? from : to)) {
+            error = "invalid date " + key + "=" + value + ", expected YYYY-MM-DD";
+            return false;
+        }
+    } else if (key == "sort") {
+        sort.clear();
+        for (const auto& name : splitList(value)) {
+            bool descending = name[0] == '-';
+            Column column;
+            if (!parseColumn(descending ? name.substr(1) : name, column)) {
+                error = "unknown sort column " + name;
+                return false;
+            }
+            sort.push_back(SortKey{column, descending});
+        }
+    } else {
+        error = "unknown query key " + key;
+        return false;
+    }
+    return true;
+}
+
+bool ReportQuery::parse(const std::string& text, std::string& error) {
+    std::istringstream ss(text);
+    std::string pair;
+    while (std::getline(ss, pair, '&')) {
+        if (pair.empty()) {
+            continue;
+        }
+        auto eq = pair.find('=');
+        if (eq == std::string::npos) {
+            error = "expected key=value, got " + pair;
+            return false;
+        }
+        if (!set(pair.substr(0, eq), pair.substr(eq + 1), error)) {
+            return false;
+        }
+    }
+    return true;
+}
+
+} // namespace Reports
@@ -0,0 +1,58 @@
+#pragma once
+#include <limits>
+#include <string>
+#include <vector>
+#include "ReportFormat.h"
+
+namespace Reports {
+
+/**
+ * @brief Выборка строк отчета: столбцы, фильтры и порядок
+ *
+ * Фильтры проверяются по сырым полям транзакции (сумма, дата, тип, счет
+ * и категория) до какого-либо форматирования: отброшенные строки не попадают
+ * ни в отчет, ни в его итоги. Невыбранные столбцы не вычисляются вовсе.
+ *
+ * Текстовая запись — пары key=value через '&', как в строке запроса URL:
+ *
+ *     columns=date,amount&type=withdrawal&category=Еда&min=-500&max=0
+ *         &from=2026-01-01&to=2026-02-01&sort=-amount,date
+ *
+ * Списки — через запятую. category совпадает и с подкатегориями, сумма
+ * берется из [min, max], дата — из [from, to) (YYYY-MM-DD или
+ * YYYY-MM-DD HH:MM:SS). '-' перед столбцом sort — по убыванию; строки
+ * с равными ключами сохраняют порядок истории.
+ */
+struct ReportQuery {
+    struct SortKey {
+        Column column;
+        bool descending;
+    };
+
+    ColumnSelection columns;               // пусто — все столбцы
+    std::vector<std::string> types;        // DEPOSIT, WITHDRAWAL, COMPOUNDING
+    std::vector<std::string> accounts;     // имена счетов
+    std::vector<std::string> categories;   // имена категорий вместе с подкатегориями
+    double minAmount = -std::numeric_limits<double>::infinity();
+    double maxAmount = std::numeric_limits<double>::infinity();
+    TimePoint from = TimePoint::min();
+    TimePoint to = TimePoint::max();
+    std::vector<SortKey> sort;
+
+    bool isFiltered() const;
+    bool matches(const Transactions::Transaction& trans) const;
+    // Строгий порядок по ключам sort
+    bool less(const Transactions::Transaction& a, const Transactions::Transaction& b) const;
+
+    /**
+     * @brief Задает один параметр выборки
+     * @param error Текст ошибки для неизвестного ключа или неверного значения
+     */
+    bool set(const std::string& key, const std::string& value, std::string& error);
+    /**
+     * @brief Разбор текстовой записи "key=value&key=value"
+     */
+    bool parse(const std::string& text, std::string& error);
+};
+
+} // namespace Reports
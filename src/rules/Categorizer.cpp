@@ -0,0 +1,185 @@
+/**
+ * @file Categorizer.cpp
+ * @brief Компиляция правил в автомат Ахо-Корасик и классификация транзакций
+ */
+
+#include "Categorizer.h"
+#include <fstream>
+#include "../utils/Utf8.h"
+#include "../utils/Utils.h"
+
+namespace Rules {
+
+namespace {
+
+bool parseBound(const std::string& text, double& value) {
+    if (text.empty()) {
+        return true;
+    }
+    try {
+        std::size_t pos = 0;
+        value = std::stod(text, &pos);
+        return pos == text.size();
+    } catch (...) {
+        return false;
+    }
+}
+
+} // namespace
+
+void Categorizer::addRule(Rule rule) {
+    rule.pattern = Utf8::foldCase(rule.pattern);
+    rules.push_back(std::move(rule));
+    compiled = false;
+}
+
+bool Categorizer::loadFile(const std::string& path) {
+    std::ifstream file(path);
+    if (!file.is_open()) {
+        lastError = "cannot open " + path;
+        return false;
+    }
+
+    std::string line;
+    std::size_t lineNo = 0;
+    while (std::getline(file, line)) {
+        ++lineNo;
+        if (!line.empty() && line.back() == '\r') {
+            line.pop_back();
+        }
+        if (line.empty() || line[0] == '#') {
+            continue;
+        }
+        auto fields = splitCsvLine(line);
+        Rule rule;
+        if (fields.size() < 3 || fields[0] != "rule" || fields[1].empty()) {
+            lastError = path + ":" + std::to_string(lineNo) + ": expected rule,<category>,<pattern>";
+            return false;
+        }
+        rule.category = fields[1];
+        rule.pattern = fields[2];
+        if ((fields.size() > 3 && !parseBound(fields[3], rule.minAmount)) ||
+            (fields.size() > 4 && !parseBound(fields[4], rule.maxAmount))) {
+            lastError = path + ":" + std::to_string(lineNo) + ": invalid amount bound";
+            return false;
+        }
+        if (fields.size() > 5) {
+            rule.account = fields[5];
+        }
+        addRule(std::move(rule));
+    }
+    compile();
+    return true;
+}
+
+void Categorizer::compile() {
+    // Классы байтов: 0 — байт не встречается ни в одном шаблоне
+    byteClass.fill(0);
+    classCount = 1;
+    for (const auto& rule : rules) {
+        for (unsigned char c : rule.pattern) {
+            if (!byteClass[c]) {
+                byteClass[c] = static_cast<std::uint16_t>(classCount++);
+            }
+        }
+    }
+
+    // Бор шаблонов; 0 в таблице у не-корня — перехода пока нет
+    transitions.assign(classCount, 0);
+    std::vector<std::vector<std::uint32_t>> own(1);
+    anyPatternRules.clear();
+    for (std::uint32_t r = 0; r < rules.size(); ++r) {
+        if (rules[r].pattern.empty()) {
+            anyPatternRules.push_back(r);
+            continue;
+        }
+        std::uint32_t state = 0;
+        for (unsigned char c : rules[r].pattern) {
+            std::size_t slot = state * classCount + byteClass[c];
+            if (!transitions[slot]) {
+                transitions[slot] = static_cast<std::uint32_t>(own.size());
+                own.emplace_back();
+                transitions.resize(own.size() * classCount, 0);
+            }
+            state = transitions[slot];
+        }
+        own[state].push_back(r);
+    }
+
+    // Обход в ширину: ссылки неудач и достройка переходов до полного автомата
+    std::size_t states = own.size();
+    std::vector<std::uint32_t> fail(states, 0);
+    outputLink.assign(states, 0);
+    std::vector<std::uint32_t> queue;
+    queue.reserve(states);
+    for (std::size_t c = 0; c < classCount; ++c) {
+        if (std::uint32_t child = transitions[c]) {
+            queue.push_back(child);
+        }
+    }
+    for (std::size_t head = 0; head < queue.size(); ++head) {
+        std::uint32_t state = queue[head];
+        for (std::size_t c = 0; c < classCount; ++c) {
+            std::uint32_t& next = transitions[state * classCount + c];
+            std::uint32_t viaFail = transitions[fail[state] * classCount + c];
+            if (next) {
+                fail[next] = viaFail;
+                outputLink[next] = own[viaFail].empty() ? outputLink[viaFail] : viaFail;
+                queue.push_back(next);
+            } else {
+                next = viaFail;
+            }
+        }
+    }
+
+    ruleOffsets.assign(states + 1, 0);
+    ruleIds.clear();
+    for (std::size_t s = 0; s < states; ++s) {
+        ruleOffsets[s] = static_cast<std::uint32_t>(ruleIds.size());
+        ruleIds.insert(ruleIds.end(), own[s].begin(), own[s].end());
+    }
+    ruleOffsets[states] = static_cast<std::uint32_t>(ruleIds.size());
+    compiled = true;
+}
+
+bool Categorizer::conditionsHold(std::uint32_t rule, double amount, const std::string& account) const {
+    const Rule& r = rules[rule];
+    return amount >= r.minAmount && amount <= r.maxAmount && (r.account.empty() || r.account == account);
+}
+
+int Categorizer::match(const std::string& description, double amount, const std::string& account) const {
+    if (!compiled) {
+        return -1;
+    }
+
+    std::uint32_t best = static_cast<std::uint32_t>(rules.size());
+    for (std::uint32_t r : anyPatternRules) {
+        if (conditionsHold(r, amount, account)) {
+            best = r;
+            break;
+        }
+    }
+
+    std::string text = Utf8::foldCase(description);
+    std::uint32_t state = 0;
+    for (unsigned char c : text) {
+        state = transitions[state * classCount + byteClass[c]];
+        std::uint32_t s = ruleOffsets[state] != ruleOffsets[state + 1] ? state : outputLink[state];
+        for (; s; s = outputLink[s]) {
+            for (std::uint32_t i = ruleOffsets[s]; i < ruleOffsets[s + 1] && ruleIds[i] < best; ++i) {
+                if (conditionsHold(ruleIds[i], amount, account)) {
+                    best = ruleIds[i];
+                }
+            }
+        }
+    }
+    return best < rules.size() ? static_cast<int>(best) : -1;
+}
+
+std::shared_ptr<Category> Categorizer::classify(const User& user, const std::string& description,
+                                                double amount, const std::string& account) const {
+    int rule = match(description, amount, account);
+    return rule < 0 ? nullptr : user.findCategory(rules[rule].category);
+}
+
+} // namespace Rules
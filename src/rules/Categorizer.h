@@ -0,0 +1,91 @@
+#pragma once
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <limits>
+#include <memory>
+#include <string>
+#include <vector>
+#include "../users/User.h"
+
+namespace Rules {
+
+/**
+ * @brief Правило автоматической категоризации
+ *
+ * Срабатывает, если описание содержит pattern (без учета регистра),
+ * сумма со знаком лежит в [minAmount, maxAmount] и счет совпадает с account.
+ * Пустые pattern и account означают "любое".
+ */
+struct Rule {
+    std::string category;   // имя категории пользователя
+    std::string pattern;
+    double minAmount = -std::numeric_limits<double>::infinity();
+    double maxAmount = std::numeric_limits<double>::infinity();
+    std::string account;
+};
+
+/**
+ * @brief Движок правил: назначает категорию по описанию, сумме и счету
+ *
+ * Шаблоны всех правил компилируются в один автомат Ахо-Корасик, развернутый
+ * в таблицу переходов детерминированного автомата. Байты, не встречающиеся
+ * в шаблонах, сводятся в один класс, поэтому таблица занимает
+ * (число состояний × число классов) ячеек. Классификация — один проход по
+ * описанию (O(длины)) с проверкой сумм и счета только у правил, чьи шаблоны
+ * встретились; при нескольких совпадениях выигрывает правило, добавленное раньше.
+ *
+ * Файл правил (CSV, '#' — комментарий):
+ *
+ *     rule,<category>,<pattern>[,<minAmount>,<maxAmount>[,<account>]]
+ */
+class Categorizer {
+    std::vector<Rule> rules;
+    std::string lastError;
+
+    // Скомпилированный автомат
+    std::array<std::uint16_t, 256> byteClass{};  // до 257 классов: 256 байтов и класс 0
+    std::size_t classCount = 1;
+    std::vector<std::uint32_t> transitions;   // state * classCount + class
+    std::vector<std::uint32_t> outputLink;    // ближайший суффикс с совпадениями (0 — нет)
+    std::vector<std::uint32_t> ruleOffsets;   // правила состояния: ruleIds[offsets[s]..offsets[s+1])
+    std::vector<std::uint32_t> ruleIds;
+    std::vector<std::uint32_t> anyPatternRules;
+    bool compiled = false;
+
+    bool conditionsHold(std::uint32_t rule, double amount, const std::string& account) const;
+
+public:
+    /**
+     * @brief Добавляет правило; действует после compile()
+     */
+    void addRule(Rule rule);
+    /**
+     * @brief Загружает правила из файла и компилирует автомат
+     * @return true если файл прочитан без ошибок
+     */
+    bool loadFile(const std::string& path);
+    /**
+     * @brief Строит автомат по текущему набору правил
+     */
+    void compile();
+
+    /**
+     * @brief Находит первое подходящее правило
+     * @param amount Сумма со знаком (списание отрицательно)
+     * @return Номер правила или -1
+     */
+    int match(const std::string& description, double amount, const std::string& account) const;
+    /**
+     * @brief Категория пользователя по первому подходящему правилу
+     * @return nullptr если правило не найдено или у пользователя нет такой категории
+     */
+    std::shared_ptr<Category> classify(const User& user, const std::string& description,
+                                       double amount, const std::string& account) const;
+
+    const std::vector<Rule>& getRules() const { return rules; }
+    std::size_t getStateCount() const { return outputLink.size(); }
+    const std::string& getLastError() const { return lastError; }
+};
+
+} // namespace Rules
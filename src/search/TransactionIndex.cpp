@@ -0,0 +1,250 @@
+/**
+ * @file TransactionIndex.cpp
+ * @brief Токенизация описаний и поиск по инвертированному индексу
+ */
+
+#include "TransactionIndex.h"
+#include <algorithm>
+#include "../utils/Utf8.h"
+
+namespace Search {
+
+namespace {
+
+std::int64_t toSeconds(std::chrono::system_clock::time_point tp) {
+    return std::chrono::duration_cast<std::chrono::seconds>(tp.time_since_epoch()).count();
+}
+
+/**
+ * @brief Разбиение на слова; в запросах '*' сразу после слова сохраняется как признак префикса
+ */
+std::vector<std::string> split(const std::string& text, bool keepPrefixMark) {
+    std::vector<std::string> tokens;
+    std::string current;
+    std::size_t pos = 0;
+    while (pos < text.size()) {
+        std::uint32_t cp = Utf8::decode(text, pos);
+        if (Utf8::isWordChar(cp)) {
+            Utf8::encode(Utf8::fold(cp), current);
+            continue;
+        }
+        if (!current.empty()) {
+            if (keepPrefixMark && cp == '*') {
+                current += '*';
+            }
+            tokens.push_back(std::move(current));
+            current.clear();
+        }
+    }
+    if (!current.empty()) {
+        tokens.push_back(std::move(current));
+    }
+    return tokens;
+}
+
+} // namespace
+
+std::vector<std::string> tokenize(const std::string& text) {
+    return split(text, false);
+}
+
+void TransactionIndex::add(const std::string& user, const std::shared_ptr<Transactions::Transaction>& trans) {
+    if (!trans || ids.count(trans.get())) {
+        return;
+    }
+    auto id = static_cast<std::uint32_t>(documents.size());
+    documents.push_back(trans);
+    dates.push_back(toSeconds(trans->getDate()));
+    ids.emplace(trans.get(), id);
+
+    for (const auto& token : tokenize(trans->getDescription())) {
+        terms[token].add(id);
+    }
+    byUser[user].add(id);
+    byCategory[trans->getCategory().get()].add(id);
+    live.add(id);
+}
+
+void TransactionIndex::remove(const std::string& user, const Transactions::Transaction& trans) {
+    auto it = ids.find(&trans);
+    if (it == ids.end()) {
+        return;
+    }
+    std::uint32_t id = it->second;
+    for (const auto& token : tokenize(trans.getDescription())) {
+        auto term = terms.find(token);
+        if (term != terms.end()) {
+            term->second.remove(id);
+            if (term->second.empty()) {
+                terms.erase(term);
+            }
+        }
+    }
+    // Пустые списки удаляются: ключи категорий выгруженных пользователей
+    // указывают на освобожденные объекты
+    auto owner = byUser.find(user);
+    if (owner != byUser.end()) {
+        owner->second.remove(id);
+        if (owner->second.empty()) {
+            byUser.erase(owner);
+        }
+    }
+    auto category = byCategory.find(trans.getCategory().get());
+    if (category != byCategory.end()) {
+        category->second.remove(id);
+        if (category->second.empty()) {
+            byCategory.erase(category);
+        }
+    }
+    live.remove(id);
+    documents[id].reset();
+    ids.erase(it);
+    if (++removed > ids.size() && removed >= 1024) {
+        compact();
+    }
+}
+
+void TransactionIndex::removeUser(const std::string& user) {
+    auto owner = byUser.find(user);
+    if (owner == byUser.end()) {
+        return;
+    }
+    std::vector<std::shared_ptr<Transactions::Transaction>> owned;
+    owner->second.forEach([&](std::uint32_t id) {
+        owned.push_back(documents[id]);
+    });
+    for (const auto& trans : owned) {
+        remove(user, *trans);
+    }
+}
+
+/**
+ * @brief Перенумеровывает живые документы подряд с сохранением порядка
+ */
+void TransactionIndex::compact() {
+    std::vector<const std::string*> owners(documents.size(), nullptr);
+    for (const auto& [name, postings] : byUser) {
+        postings.forEach([&](std::uint32_t id) {
+            owners[id] = &name;
+        });
+    }
+    std::vector<std::pair<std::string, std::shared_ptr<Transactions::Transaction>>> kept;
+    kept.reserve(ids.size());
+    for (std::size_t id = 0; id < documents.size(); ++id) {
+        if (documents[id] && owners[id]) {
+            kept.emplace_back(*owners[id], std::move(documents[id]));
+        }
+    }
+
+    documents.clear();
+    dates.clear();
+    ids.clear();
+    terms.clear();
+    byUser.clear();
+    byCategory.clear();
+    live = RoaringBitmap();
+    removed = 0;
+    for (const auto& [user, trans] : kept) {
+        add(user, trans);
+    }
+}
+
+void TransactionIndex::build(Ledger& ledger) {
+    ledger.forEachUser([&](const std::shared_ptr<User>& user) {
+        for (const auto& trans : user->getTransactions()) {
+            add(user->getName(), trans);
+        }
+    });
+}
+
+RoaringBitmap TransactionIndex::matchTerm(const std::string& token) const {
+    if (token.empty() || token.back() != '*') {
+        auto it = terms.find(token);
+        return it != terms.end() ? it->second : RoaringBitmap();
+    }
+    std::string prefix = token.substr(0, token.size() - 1);
+    RoaringBitmap result;
+    for (auto it = terms.lower_bound(prefix);
+         it != terms.end() && it->first.compare(0, prefix.size(), prefix) == 0; ++it) {
+        result |= it->second;
+    }
+    return result;
+}
+
+std::vector<std::shared_ptr<Transactions::Transaction>> TransactionIndex::search(const Query& query) const {
+    std::vector<std::string> tokens = split(query.text, true);
+    std::vector<RoaringBitmap> lists;
+    for (const auto& token : tokens) {
+        lists.push_back(matchTerm(token));
+    }
+    if (!query.user.empty()) {
+        auto it = byUser.find(query.user);
+        lists.push_back(it != byUser.end() ? it->second : RoaringBitmap());
+    }
+    if (query.category) {
+        auto it = byCategory.find(query.category.get());
+        lists.push_back(it != byCategory.end() ? it->second : RoaringBitmap());
+    }
+
+    std::sort(lists.begin(), lists.end(), [](const RoaringBitmap& a, const RoaringBitmap& b) {
+        return a.cardinality() < b.cardinality();
+    });
+    RoaringBitmap candidates = lists.empty() ? live : lists.front();
+    for (std::size_t i = 1; i < lists.size() && !candidates.empty(); ++i) {
+        candidates &= lists[i];
+    }
+
+    bool ranged = query.from != std::chrono::system_clock::time_point::min() ||
+                  query.to != std::chrono::system_clock::time_point::max();
+    std::int64_t from = ranged ? toSeconds(query.from) : 0;
+    std::int64_t to = ranged ? toSeconds(query.to) : 0;
+
+    std::vector<std::shared_ptr<Transactions::Transaction>> result;
+    candidates.forEach([&](std::uint32_t id) {
+        if (!documents[id]) return;
+        if (ranged && (dates[id] < from || dates[id] >= to)) return;
+        result.push_back(documents[id]);
+    });
+    return result;
+}
+
+std::size_t TransactionIndex::getPostingBytes() const {
+    std::size_t total = live.memoryBytes();
+    for (const auto& [term, postings] : terms) {
+        total += term.size() + postings.memoryBytes();
+    }
+    for (const auto& [name, postings] : byUser) {
+        total += postings.memoryBytes();
+    }
+    for (const auto& [cat, postings] : byCategory) {
+        total += postings.memoryBytes();
+    }
+    return total;
+}
+
+void TransactionIndex::onTransactionAdded(const User& user,
+                                          const std::shared_ptr<Transactions::Transaction>& trans) {
+    add(user.getName(), trans);
+}
+
+void TransactionIndex::onTransactionRemoved(const User& user, const Transactions::Transaction& trans) {
+    remove(user.getName(), trans);
+}
+
+void TransactionIndex::onUserEvicted(const User& user) {
+    removeUser(user.getName());
+}
+
+void TransactionIndex::onUserReloaded(const User& user) {
+    for (const auto& trans : user.getTransactions()) {
+        add(user.getName(), trans);
+    }
+}
+
+void TransactionIndex::onTransactionsArchived(const User& user, std::chrono::system_clock::time_point) {
+    // Индекс держит перенесенные транзакции, а история их уже отдала: пользователь индексируется заново
+    removeUser(user.getName());
+    onUserReloaded(user);
+}
+
+} // namespace Search
@@ -0,0 +1,111 @@
+#pragma once
+#include <chrono>
+#include <cstdint>
+#include <map>
+#include <memory>
+#include <string>
+#include <unordered_map>
+#include <vector>
+#include "../ledger/Ledger.h"
+#include "../utils/RoaringBitmap.h"
+
+namespace Search {
+
+/**
+ * @brief Разбивает текст в UTF-8 на слова в нижнем регистре
+ *
+ * Словом считается последовательность букв и цифр. Регистр приводится
+ * для латиницы, кириллицы и Latin-1; «ё» приводится к «е».
+ */
+std::vector<std::string> tokenize(const std::string& text);
+
+/**
+ * @brief Запрос к индексу транзакций
+ *
+ * Слова текста объединяются по И; слово с '*' на конце ищется как префикс
+ * ("прод*" найдет "продукты"). Пустой текст — все транзакции с учетом фильтров.
+ */
+struct Query {
+    std::string text;
+    std::string user;                     // пусто — все пользователи
+    std::shared_ptr<Category> category;   // nullptr — любая категория
+    // Интервал дат [from, to)
+    std::chrono::system_clock::time_point from = std::chrono::system_clock::time_point::min();
+    std::chrono::system_clock::time_point to = std::chrono::system_clock::time_point::max();
+};
+
+/**
+ * @brief Инвертированный индекс по описаниям транзакций
+ *
+ * Каждой транзакции присваивается номер документа; для каждого слова
+ * хранится список номеров в виде RoaringBitmap. Словарь упорядочен, так что
+ * префиксный запрос — объединение списков соседних слов. Фильтры по
+ * пользователю и категории — такие же списки, пересечение идет от самого
+ * короткого; интервал дат проверяется только у оставшихся кандидатов.
+ *
+ * Подписывается на журнал (Ledger::addObserver) и обновляется по мере
+ * добавления и отката транзакций. Транзакции выгруженного пользователя
+ * убираются из индекса и индексируются заново при подгрузке: поиск по
+ * пользователю, полученному через findUser, видит всю его историю, а общий
+ * поиск — только пользователей в памяти. Транзакции, перенесенные
+ * в холодный архив (Ledger::archiveBefore), из индекса уходят: поиск идет
+ * по оперативной истории. Номера удаленных документов
+ * освобождаются сжатием, когда их становится больше живых.
+ */
+class TransactionIndex : public LedgerObserver {
+    std::vector<std::shared_ptr<Transactions::Transaction>> documents; // nullptr — удален
+    std::vector<std::int64_t> dates;
+    std::unordered_map<const Transactions::Transaction*, std::uint32_t> ids;
+    std::map<std::string, RoaringBitmap, std::less<>> terms;
+    std::unordered_map<std::string, RoaringBitmap> byUser;
+    std::unordered_map<const Category*, RoaringBitmap> byCategory;
+    RoaringBitmap live;
+    std::size_t removed = 0;              // удаленных документов в documents
+
+    RoaringBitmap matchTerm(const std::string& token) const;
+    void compact();
+
+public:
+    /**
+     * @brief Добавляет транзакцию в индекс
+     * @param user Имя владельца
+     */
+    void add(const std::string& user, const std::shared_ptr<Transactions::Transaction>& trans);
+    /**
+     * @brief Удаляет транзакцию из индекса
+     */
+    void remove(const std::string& user, const Transactions::Transaction& trans);
+    /**
+     * @brief Удаляет из индекса все транзакции пользователя
+     */
+    void removeUser(const std::string& user);
+    /**
+     * @brief Индексирует всю историю журнала
+     */
+    void build(Ledger& ledger);
+
+    /**
+     * @brief Поиск транзакций
+     * @return Найденные транзакции в порядке добавления в индекс
+     */
+    std::vector<std::shared_ptr<Transactions::Transaction>> search(const Query& query) const;
+
+    std::size_t size() const { return ids.size(); }
+    std::size_t getTermCount() const { return terms.size(); }
+    /**
+     * @brief Память, занятая списками вхождений
+     */
+    std::size_t getPostingBytes() const;
+
+    void onUserAdded(const User&) override {}
+    void onAccountAdded(const User&, const Account&) override {}
+    void onCategoryAdded(const User&, const Category&) override {}
+    void onBalanceChanged(const User&, const Account&) override {}
+    void onTransactionAdded(const User& user, const std::shared_ptr<Transactions::Transaction>& trans) override;
+    void onTransactionRemoved(const User& user, const Transactions::Transaction& trans) override;
+    void onUserEvicted(const User& user) override;
+    void onUserReloaded(const User& user) override;
+    void onTransactionsArchived(const User& user, std::chrono::system_clock::time_point cutoff) override;
+};
+
+} // namespace Search
@@ -0,0 +1,632 @@
+/**
+ * @file HttpServer.cpp
+ * @brief Цикл epoll, разбор HTTP-запросов и JSON-ответы по журналу
+ */
+
+#include "HttpServer.h"
+#include <arpa/inet.h>
+#include <cctype>
+#include <cerrno>
+#include <cstring>
+#include <iomanip>
+#include <netinet/in.h>
+#include <sstream>
+#include <sys/epoll.h>
+#include <sys/eventfd.h>
+#include <sys/socket.h>
+#include <unistd.h>
+#include "../metrics/Metrics.h"
+#include "../reports/Report.h"
+#include "../utils/DateUtils.h"
+
+namespace Server {
+
+namespace {
+
+constexpr std::size_t MAX_HEADER_BYTES = 16 * 1024;
+// Непрочитанный ввод соединения: заголовок и очередь конвейерных запросов,
+// пока предыдущий ответ формируется или отправляется
+constexpr std::size_t MAX_INPUT_BYTES = 4 * MAX_HEADER_BYTES;
+constexpr int MAX_EVENTS = 64;
+
+const char* statusText(int status) {
+    switch (status) {
+        case 200: return "OK";
+        case 400: return "Bad Request";
+        case 404: return "Not Found";
+        case 405: return "Method Not Allowed";
+        case 431: return "Request Header Fields Too Large";
+        default: return "Internal Server Error";
+    }
+}
+
+std::string urlDecode(const std::string& text) {
+    std::string out;
+    for (std::size_t i = 0; i < text.size(); ++i) {
+        if (text[i] == '%' && i + 2 < text.size() && std::isxdigit(static_cast<unsigned char>(text[i + 1])) &&
+            std::isxdigit(static_cast<unsigned char>(text[i + 2]))) {
+            out += static_cast<char>(std::stoi(text.substr(i + 1, 2), nullptr, 16));
+            i += 2;
+        } else {
+            out += text[i] == '+' ? ' ' : text[i];
+        }
+    }
+    return out;
+}
+
+std::string queryParam(const std::string& query, const std::string& name) {
+    std::istringstream ss(query);
+    std::string pair;
+    while (std::getline(ss, pair, '&')) {
+        auto eq = pair.find('=');
+        if (pair.substr(0, eq) == name) {
+            return eq == std::string::npos ? "" : urlDecode(pair.substr(eq + 1));
+        }
+    }
+    return "";
+}
+
+std::vector<std::string> splitPath(const std::string& path) {
+    std::vector<std::string> parts;
+    std::istringstream ss(path);
+    std::string part;
+    while (std::getline(ss, part, '/')) {
+        if (!part.empty()) {
+            parts.push_back(urlDecode(part));
+        }
+    }
+    return parts;
+}
+
+HttpServer::Response error(int status, const std::string& message) {
+    HttpServer::Response r;
+    r.status = status;
+    r.body = "{\"error\": \"" + Reports::JSONReport::escapeJson(message) + "\"}\n";
+    return r;
+}
+
+std::string quote(const std::string& text) {
+    return "\"" + Reports::JSONReport::escapeJson(text) + "\"";
+}
+
+HttpServer::Response accountsJson(const User& user) {
+    std::ostringstream os;
+    os << std::fixed << std::setprecision(2) << "[";
+    bool first = true;
+    for (const auto& acc : user.getAccounts()) {
+        os << (first ? "\n" : ",\n") << "  {\"name\": " << quote(acc->getName())
+           << ", \"type\": " << quote(acc->getType())
+           << ", \"currency\": " << quote(currencyCode(acc->getCurrency()))
+           << ", \"balance\": " << acc->getBalance()
+           << ", \"available\": " << acc->getAvailable()
+           << ", \"held\": " << acc->getHeld() << "}";
+        first = false;
+    }
+    os << "\n]\n";
+    return HttpServer::Response{200, "application/json; charset=utf-8", os.str()};
+}
+
+HttpServer::Response categoriesJson(const User& user) {
+    const auto& tree = user.getCategoryTree();
+    std::ostringstream os;
+    os << std::fixed << std::setprecision(2) << "[";
+    bool first = true;
+    for (const auto& cat : user.getCategories()) {
+        double budget = cat->getBudgetLimit();
+        auto own = tree.getOwnTotals(*cat);
+        auto total = tree.getTotals(*cat);
+        os << (first ? "\n" : ",\n") << "  {\"name\": " << quote(cat->getName())
+           << ", \"path\": " << quote(cat->getPath())
+           << ", \"type\": " << quote(cat->getType())
+           << ", \"budget\": " << budget
+           << ", \"spent\": " << total.spent
+           << ", \"ownSpent\": " << own.spent
+           << ", \"income\": " << total.income
+           << ", \"remaining\": " << (budget > 0.0 ? budget - total.spent : 0.0) << "}";
+        first = false;
+    }
+    os << "\n]\n";
+    return HttpServer::Response{200, "application/json; charset=utf-8", os.str()};
+}
+
+bool parseDateParam(const std::string& text, Reports::ReportCache::TimePoint& tp) {
+    return DateUtils::parseTimePoint(text.size() == 10 ? text + " 00:00:00" : text, tp);
+}
+
+/**
+ * @brief Отчет целиком из кэша или, при выборке строк и столбцов, построенный заново
+ * @param selection Выборка или nullptr, если заданы только формат и даты
+ */
+HttpServer::Response renderReport(Reports::ReportCache& cache, const User& user, const std::string& format,
+                                  const std::string& fromText, const std::string& toText,
+                                  const Reports::ReportQuery* selection) {
+    auto from = Reports::ReportCache::TimePoint::min();
+    auto to = Reports::ReportCache::TimePoint::max();
+    if ((!fromText.empty() && !parseDateParam(fromText, from)) || (!toText.empty() && !parseDateParam(toText, to))) {
+        return error(400, "bad date range, expected YYYY-MM-DD");
+    }
+    auto report = Reports::createReport(format.empty() ? "json" : format, user.getName());
+    if (!report) {
+        return error(400, "unknown report format " + format);
+    }
+    HttpServer::Response r;
+    if (selection) {
+        if (!selection->columns.empty() && !report->supportsColumnSelection()) {
+            return error(400, report->getFormat() + " reports always contain all columns");
+        }
+        Reports::ReportQuery query = *selection;
+        query.from = from;
+        query.to = to;
+        report->setQuery(query);
+        report->setTransactions(user.getTransactions());
+        report->appendTo(r.body);
+    } else {
+        r.body = *cache.render(user, report->getFormat(), from, to);
+    }
+    std::string kind = report->getFormat();
+    r.contentType = kind == "JSON" ? "application/json; charset=utf-8"
+                  : kind == "CSV" ? "text/csv; charset=utf-8"
+                  : kind == "ARROW" ? "application/vnd.apache.arrow.file" : "text/plain; charset=utf-8";
+    return r;
+}
+
+} // namespace
+
+HttpServer::HttpServer(Ledger& source, std::size_t threads, const Search::TransactionIndex* searchIndex)
+    : ledger(source), index(searchIndex),
+      workerCount(threads ? threads : std::max(1u, std::thread::hardware_concurrency())) {}
+
+HttpServer::~HttpServer() {
+    {
+        std::lock_guard<std::mutex> lock(taskMutex);
+        stopping = true;
+    }
+    taskReady.notify_all();
+    for (auto& th : workers) {
+        th.join();
+    }
+    for (auto& [fd, conn] : connections) {
+        ::close(fd);
+    }
+    for (int fd : {listenFd, epollFd, wakeFd}) {
+        if (fd >= 0) ::close(fd);
+    }
+}
+
+bool HttpServer::listen(std::uint16_t listenPort) {
+    listenFd = ::socket(AF_INET, SOCK_STREAM | SOCK_NONBLOCK | SOCK_CLOEXEC, 0);
+    if (listenFd < 0) {
+        lastError = std::string("socket: ") + std::strerror(errno);
+        return false;
+    }
+    int yes = 1;
+    ::setsockopt(listenFd, SOL_SOCKET, SO_REUSEADDR, &yes, sizeof(yes));
+
+    sockaddr_in addr{};
+    addr.sin_family = AF_INET;
+    addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+    addr.sin_port = htons(listenPort);
+    if (::bind(listenFd, reinterpret_cast<sockaddr*>(&addr), sizeof(addr)) < 0 || ::listen(listenFd, 128) < 0) {
+        lastError = "bind 127.0.0.1:" + std::to_string(listenPort) + ": " + std::strerror(errno);
+        return false;
+    }
+    socklen_t len = sizeof(addr);
+    ::getsockname(listenFd, reinterpret_cast<sockaddr*>(&addr), &len);
+    port = ntohs(addr.sin_port);
+
+    epollFd = ::epoll_create1(EPOLL_CLOEXEC);
+    wakeFd = ::eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+    if (epollFd < 0 || wakeFd < 0) {
+        lastError = std::string("epoll: ") + std::strerror(errno);
+        return false;
+    }
+    epoll_event ev{};
+    ev.events = EPOLLIN;
+    ev.data.fd = listenFd;
+    ::epoll_ctl(epollFd, EPOLL_CTL_ADD, listenFd, &ev);
+    ev.data.fd = wakeFd;
+    ::epoll_ctl(epollFd, EPOLL_CTL_ADD, wakeFd, &ev);
+
+    for (std::size_t i = 0; i < workerCount; ++i) {
+        workers.emplace_back([this]() {
+            while (true) {
+                std::function<void()> task;
+                {
+                    std::unique_lock<std::mutex> lock(taskMutex);
+                    taskReady.wait(lock, [this]() { return stopping || !tasks.empty(); });
+                    if (tasks.empty()) return;
+                    task = std::move(tasks.front());
+                    tasks.pop_front();
+                }
+                task();
+            }
+        });
+    }
+    return true;
+}
+
+void HttpServer::stop() {
+    stopRequested = true;
+    std::uint64_t one = 1;
+    if (wakeFd >= 0) {
+        ssize_t ignored = ::write(wakeFd, &one, sizeof(one));
+        (void)ignored;
+    }
+}
+
+void HttpServer::run() {
+    epoll_event events[MAX_EVENTS];
+    while (!stopRequested) {
+        int n = ::epoll_wait(epollFd, events, MAX_EVENTS, -1);
+        if (n < 0) {
+            if (errno == EINTR) continue;
+            lastError = std::string("epoll_wait: ") + std::strerror(errno);
+            return;
+        }
+        for (int i = 0; i < n; ++i) {
+            int fd = events[i].data.fd;
+            if (fd == listenFd) {
+                accept();
+            } else if (fd == wakeFd) {
+                std::uint64_t count;
+                while (::read(wakeFd, &count, sizeof(count)) > 0) {
+                }
+                deliverCompleted();
+            } else if (events[i].events & (EPOLLERR | EPOLLHUP)) {
+                close(fd);
+            } else {
+                if (events[i].events & EPOLLOUT) flush(fd);
+                if ((events[i].events & EPOLLIN) && connections.count(fd)) readFrom(fd);
+            }
+        }
+    }
+}
+
+void HttpServer::accept() {
+    while (true) {
+        int fd = ::accept4(listenFd, nullptr, nullptr, SOCK_NONBLOCK | SOCK_CLOEXEC);
+        if (fd < 0) {
+            return; // EAGAIN или временная ошибка
+        }
+        epoll_event ev{};
+        ev.events = EPOLLIN | EPOLLRDHUP;
+        ev.data.fd = fd;
+        ::epoll_ctl(epollFd, EPOLL_CTL_ADD, fd, &ev);
+        Connection& conn = connections[fd];
+        conn = Connection();
+        conn.generation = nextGeneration++;
+    }
+}
+
+void HttpServer::readFrom(int fd) {
+    Connection& conn = connections[fd];
+    char buffer[16 * 1024];
+    while (true) {
+        ssize_t n = ::read(fd, buffer, sizeof(buffer));
+        if (n > 0) {
+            conn.input.append(buffer, static_cast<std::size_t>(n));
+            if (conn.input.size() > MAX_INPUT_BYTES) {
+                rejectOversized(fd);
+                return;
+            }
+            continue;
+        }
+        if (n == 0 || (errno != EAGAIN && errno != EWOULDBLOCK && errno != EINTR)) {
+            close(fd);
+            return;
+        }
+        if (errno == EAGAIN || errno == EWOULDBLOCK) break;
+    }
+    processRequests(fd);
+}
+
+/**
+ * @brief Отвечает 431 и закрывает соединение, переполнившее буфер ввода
+ *
+ * Если предыдущий ответ еще отправляется, соединение закрывается сразу:
+ * новый ответ испортил бы недописанный. Ответ фонового задания для такого
+ * соединения уже не отправляется (deliverCompleted).
+ */
+void HttpServer::rejectOversized(int fd) {
+    Connection& conn = connections[fd];
+    if (conn.written < conn.output.size()) {
+        close(fd);
+        return;
+    }
+    conn.input.clear();
+    send(fd, error(431, "request header too large"), false);
+}
+
+void HttpServer::processRequests(int fd) {
+    auto it = connections.find(fd);
+    if (it == connections.end()) return;
+    Connection& conn = it->second;
+    // По одному запросу за раз: следующий ждет, пока не уйдет ответ на предыдущий
+    if (conn.busy || conn.written < conn.output.size()) return;
+
+    std::size_t end = conn.input.find("\r\n\r\n");
+    if (end == std::string::npos) {
+        if (conn.input.size() > MAX_HEADER_BYTES) {
+            rejectOversized(fd);
+        }
+        return;
+    }
+    std::string head = conn.input.substr(0, end);
+    conn.input.erase(0, end + 4);
+
+    std::istringstream lines(head);
+    std::string method, target, version;
+    lines >> method >> target >> version;
+    bool keepAlive = version == "HTTP/1.1";
+    std::string line;
+    std::getline(lines, line);
+    while (std::getline(lines, line)) {
+        std::string lower;
+        for (char c : line) lower += static_cast<char>(std::tolower(static_cast<unsigned char>(c)));
+        if (lower.rfind("connection:", 0) == 0) {
+            keepAlive = lower.find("close") == std::string::npos &&
+                        (keepAlive || lower.find("keep-alive") != std::string::npos);
+        } else if (lower.rfind("content-length:", 0) == 0 && std::atol(lower.c_str() + 15) > 0) {
+            send(fd, error(400, "request body is not supported"), false);
+            return;
+        }
+    }
+
+    if (method.empty() || target.empty() || version.rfind("HTTP/", 0) != 0) {
+        send(fd, error(400, "malformed request line"), false);
+        return;
+    }
+    if (method != "GET") {
+        send(fd, error(405, "only GET is supported"), keepAlive);
+        return;
+    }
+
+    auto q = target.find('?');
+    std::string path = target.substr(0, q);
+    std::string query = q == std::string::npos ? "" : target.substr(q + 1);
+    Response response;
+    if (route(path, query, fd, keepAlive, response)) {
+        send(fd, response, keepAlive);
+    } else {
+        conn.busy = true;
+    }
+}
+
+bool HttpServer::route(const std::string& path, const std::string& query, int fd, bool keepAlive,
+                       Response& response) {
+    auto parts = splitPath(path);
+    if (parts.size() == 1 && parts[0] == "health") {
+        response.body = "{\"status\": \"ok\"}\n";
+        return true;
+    }
+    if (parts.size() == 1 && parts[0] == "metrics") {
+        std::ostringstream os;
+        Metrics::writePrometheus(os, Metrics::snapshot());
+        response.contentType = "text/plain; version=0.0.4";
+        response.body = os.str();
+        return true;
+    }
+    if (parts.size() == 1 && parts[0] == "memory") {
+        auto stats = ledger.getMemoryStats();
+        std::ostringstream os;
+        os << "{\"residentUsers\": " << stats.residentUsers << ", \"evictedUsers\": " << stats.evictedUsers
+           << ", \"bytes\": {\"accounts\": " << stats.resident.accounts
+           << ", \"categories\": " << stats.resident.categories
+           << ", \"transactions\": " << stats.resident.transactions
+           << ", \"caches\": " << stats.resident.caches
+           << ", \"archive\": " << stats.resident.archive
+           << ", \"total\": " << stats.resident.total() << "}"
+           << ", \"peakBytes\": " << stats.peakBytes << ", \"evictions\": " << stats.evictions
+           << ", \"reloads\": " << stats.reloads << "}\n";
+        response.body = os.str();
+        return true;
+    }
+    if (parts.size() == 1 && parts[0] == "users") {
+        std::ostringstream os;
+        os << "[";
+        bool first = true;
+        ledger.forEachUser([&](const std::shared_ptr<User>& user) {
+            os << (first ? "\n" : ",\n") << "  {\"name\": " << quote(user->getName())
+               << ", \"accounts\": " << user->getAccounts().size()
+               << ", \"categories\": " << user->getCategories().size()
+               << ", \"transactions\": " << user->getTransactions().size() << "}";
+            first = false;
+        });
+        os << "\n]\n";
+        response.body = os.str();
+        return true;
+    }
+    if (parts.size() != 3 || parts[0] != "users") {
+        response = error(404, "not found: " + path);
+        return true;
+    }
+
+    auto user = ledger.findUser(parts[1]);
+    if (!user) {
+        response = error(404, "unknown user " + parts[1]);
+        return true;
+    }
+    if (parts[2] == "accounts") {
+        response = accountsJson(*user);
+        return true;
+    }
+    // Итоги категорий берутся из дерева пользователя без прохода по истории
+    if (parts[2] == "categories") {
+        response = categoriesJson(*user);
+        return true;
+    }
+    if (parts[2] == "search") {
+        return search(*user, query, fd, keepAlive, response);
+    }
+    if (parts[2] != "report") {
+        response = error(404, "not found: " + path);
+        return true;
+    }
+
+    // Отчет — в пуле потоков, ответ вернется через eventfd
+    std::string format = queryParam(query, "format");
+    std::string from = queryParam(query, "from");
+    std::string to = queryParam(query, "to");
+    // Выборка строк и столбцов строится мимо кэша
+    std::shared_ptr<Reports::ReportQuery> selection;
+    for (const char* key : {"columns", "type", "account", "category", "min", "max", "sort"}) {
+        std::string value = queryParam(query, key);
+        if (value.empty()) {
+            continue;
+        }
+        if (!selection) {
+            selection = std::make_shared<Reports::ReportQuery>();
+        }
+        std::string message;
+        if (!selection->set(key, value, message)) {
+            response = error(400, message);
+            return true;
+        }
+    }
+    respondLater(fd, keepAlive, [this, user, format, from, to, selection]() {
+        return renderReport(reportCache, *user, format, from, to, selection.get());
+    });
+    return false;
+}
+
+bool HttpServer::search(const User& user, const std::string& query, int fd, bool keepAlive,
+                        Response& response) {
+    if (!index) {
+        response = error(404, "search index is not enabled");
+        return true;
+    }
+    Search::Query request;
+    request.text = queryParam(query, "q");
+    request.user = user.getName();
+    std::string from = queryParam(query, "from");
+    std::string to = queryParam(query, "to");
+    if ((!from.empty() && !parseDateParam(from, request.from)) || (!to.empty() && !parseDateParam(to, request.to))) {
+        response = error(400, "bad date range, expected YYYY-MM-DD");
+        return true;
+    }
+    std::string category = queryParam(query, "category");
+    if (!category.empty()) {
+        request.category = user.findCategory(category);
+        if (!request.category) {
+            response = error(404, "unknown category " + category);
+            return true;
+        }
+    }
+
+    // Найденные транзакции удерживаются копиями указателей: вывод не
+    // зависит от индекса, который может измениться до его завершения
+    auto found = index->search(request);
+    respondLater(fd, keepAlive, [name = user.getName(), found = std::move(found)]() {
+        auto report = Reports::createReport("json", name);
+        report->setTransactions(found);
+        Response r;
+        report->appendTo(r.body);
+        return r;
+    });
+    return false;
+}
+
+/**
+ * @brief Формирует ответ в пуле потоков и возвращает его в цикл epoll через eventfd
+ */
+void HttpServer::respondLater(int fd, bool keepAlive, std::function<Response()> render) {
+    std::uint64_t generation = connections[fd].generation;
+    submit([this, fd, generation, keepAlive, render = std::move(render)]() {
+        Completion completion{fd, generation, keepAlive, render()};
+        {
+            std::lock_guard<std::mutex> lock(doneMutex);
+            done.push_back(std::move(completion));
+        }
+        std::uint64_t one = 1;
+        ssize_t ignored = ::write(wakeFd, &one, sizeof(one));
+        (void)ignored;
+    });
+}
+
+void HttpServer::submit(std::function<void()> task) {
+    {
+        std::lock_guard<std::mutex> lock(taskMutex);
+        tasks.push_back(std::move(task));
+    }
+    taskReady.notify_one();
+}
+
+void HttpServer::deliverCompleted() {
+    std::vector<Completion> ready;
+    {
+        std::lock_guard<std::mutex> lock(doneMutex);
+        ready.swap(done);
+    }
+    for (auto& c : ready) {
+        auto it = connections.find(c.fd);
+        // Соединение могло закрыться, а дескриптор — достаться новому клиенту
+        if (it == connections.end() || it->second.generation != c.generation) {
+            continue;
+        }
+        it->second.busy = false;
+        if (it->second.closeAfterWrite) {
+            continue;   // уже отвечено ошибкой, соединение закрывается
+        }
+        send(c.fd, c.response, c.keepAlive);
+    }
+}
+
+void HttpServer::send(int fd, const Response& response, bool keepAlive) {
+    Connection& conn = connections[fd];
+    std::ostringstream head;
+    head << "HTTP/1.1 " << response.status << " " << statusText(response.status) << "\r\n"
+         << "Content-Type: " << response.contentType << "\r\n"
+         << "Content-Length: " << response.body.size() << "\r\n"
+         << "Connection: " << (keepAlive ? "keep-alive" : "close") << "\r\n\r\n";
+    conn.output = head.str();
+    conn.output += response.body;
+    conn.written = 0;
+    conn.closeAfterWrite = !keepAlive;
+    flush(fd);
+}
+
+void HttpServer::flush(int fd) {
+    auto it = connections.find(fd);
+    if (it == connections.end()) return;
+    Connection& conn = it->second;
+    while (conn.written < conn.output.size()) {
+        ssize_t n = ::send(fd, conn.output.data() + conn.written, conn.output.size() - conn.written, MSG_NOSIGNAL);
+        if (n > 0) {
+            conn.written += static_cast<std::size_t>(n);
+            continue;
+        }
+        if (n < 0 && (errno == EAGAIN || errno == EWOULDBLOCK)) {
+            epoll_event ev{};
+            ev.events = EPOLLIN | EPOLLOUT | EPOLLRDHUP;
+            ev.data.fd = fd;
+            ::epoll_ctl(epollFd, EPOLL_CTL_MOD, fd, &ev);
+            return;
+        }
+        if (n < 0 && errno == EINTR) continue;
+        close(fd);
+        return;
+    }
+
+    conn.output.clear();
+    conn.written = 0;
+    if (conn.closeAfterWrite) {
+        close(fd);
+        return;
+    }
+    epoll_event ev{};
+    ev.events = EPOLLIN | EPOLLRDHUP;
+    ev.data.fd = fd;
+    ::epoll_ctl(epollFd, EPOLL_CTL_MOD, fd, &ev);
+    // Запрос мог прийти, пока ответ еще писался
+    if (!conn.input.empty()) {
+        processRequests(fd);
+    }
+}
+
+void HttpServer::close(int fd) {
+    ::epoll_ctl(epollFd, EPOLL_CTL_DEL, fd, nullptr);
+    ::close(fd);
+    connections.erase(fd);
+}
+
+} // namespace Server
@@ -0,0 +1,145 @@
+#pragma once
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+#include "../ledger/Ledger.h"
+#include "../reports/ReportCache.h"
+#include "../search/TransactionIndex.h"
+
+namespace Server {
+
+/**
+ * @brief Встроенный HTTP/JSON-сервис чтения журнала (только localhost)
+ *
+ * Один поток обслуживает все соединения через epoll на неблокирующих
+ * сокетах (HTTP/1.1 keep-alive, только GET). Дешевые ответы (пользователи,
+ * счета, бюджеты категорий по дереву итогов) формируются сразу, а отчеты,
+ * требующие прохода по истории, — в пуле потоков; готовый ответ
+ * возвращается в цикл epoll через eventfd.
+ *
+ *     GET /health
+ *     GET /users
+ *     GET /users/<name>/accounts
+ *     GET /users/<name>/categories
+ *     GET /users/<name>/report?format=json|csv|text|arrow&from=YYYY-MM-DD&to=YYYY-MM-DD
+ *         [&columns=...&type=...&account=...&category=...&min=...&max=...&sort=...]
+ *     GET /users/<name>/search?q=прод*&from=YYYY-MM-DD&to=YYYY-MM-DD&category=<name>
+ *     GET /metrics
+ *     GET /memory
+ *
+ * Готовые отчеты хранятся в Reports::ReportCache: повторный запрос того же
+ * отчета отдается без прохода по истории. Запросы с выборкой строк или
+ * столбцов (Reports::ReportQuery) строятся заново и в кэш не попадают.
+ *
+ * /search ищет по описаниям в Search::TransactionIndex (если индекс передан)
+ * в потоке epoll — индекс меняется при подгрузке пользователей в этом же
+ * потоке; найденные транзакции выводятся JSON-отчетом в пуле потоков.
+ *
+ * /memory — оценка памяти пользователей (Ledger::getMemoryStats). Если
+ * в журнале включена выгрузка, запрос пользователя может подгрузить его
+ * с диска, а /users обходит всех по одному (Ledger::forEachUser).
+ *
+ * Журнал во время работы сервера не должен изменяться.
+ */
+class HttpServer {
+public:
+    struct Response {
+        int status = 200;
+        std::string contentType = "application/json; charset=utf-8";
+        std::string body;
+    };
+
+private:
+    struct Connection {
+        std::uint64_t generation = 0;
+        std::string input;
+        std::string output;
+        std::size_t written = 0;
+        bool busy = false;          // запрос в пуле потоков
+        bool closeAfterWrite = false;
+    };
+
+    struct Completion {
+        int fd;
+        std::uint64_t generation;
+        bool keepAlive;
+        Response response;
+    };
+
+    Ledger& ledger;
+    const Search::TransactionIndex* index;
+    std::string lastError;
+    int listenFd = -1;
+    int epollFd = -1;
+    int wakeFd = -1;
+    std::uint16_t port = 0;
+    std::atomic<bool> stopRequested{false};
+    std::uint64_t nextGeneration = 1;
+    std::unordered_map<int, Connection> connections;
+
+    std::size_t workerCount;
+    std::vector<std::thread> workers;
+    std::mutex taskMutex;
+    std::condition_variable taskReady;
+    std::deque<std::function<void()>> tasks;
+    bool stopping = false;
+
+    std::mutex doneMutex;
+    std::vector<Completion> done;
+
+    Reports::ReportCache reportCache;
+
+    void accept();
+    void readFrom(int fd);
+    void processRequests(int fd);
+    void rejectOversized(int fd);
+    void send(int fd, const Response& response, bool keepAlive);
+    void flush(int fd);
+    void close(int fd);
+    void deliverCompleted();
+    void submit(std::function<void()> task);
+    void respondLater(int fd, bool keepAlive, std::function<Response()> render);
+
+    bool route(const std::string& path, const std::string& query, int fd, bool keepAlive, Response& response);
+    bool search(const User& user, const std::string& query, int fd, bool keepAlive, Response& response);
+
+public:
+    /**
+     * @param source Журнал; сервер его не изменяет, но обращения к пользователям
+     *               подгружают и выгружают их, поэтому журнал используется
+     *               только из потока run, а в пул уходят shared_ptr на пользователей
+     * @param threads Потоки для отчетов (0 — по числу ядер)
+     * @param searchIndex Индекс транзакций журнала для /search (nullptr — поиск недоступен);
+     *                    должен быть подписан на журнал
+     */
+    explicit HttpServer(Ledger& source, std::size_t threads = 0,
+                        const Search::TransactionIndex* searchIndex = nullptr);
+    ~HttpServer();
+
+    /**
+     * @brief Открывает сокет на 127.0.0.1
+     * @param listenPort Порт (0 — выбрать свободный, см. getPort)
+     */
+    bool listen(std::uint16_t listenPort);
+    /**
+     * @brief Цикл обработки соединений до вызова stop()
+     */
+    void run();
+    /**
+     * @brief Останавливает run(); можно вызывать из другого потока и обработчика сигнала
+     */
+    void stop();
+
+    std::uint16_t getPort() const { return port; }
+    const std::string& getLastError() const { return lastError; }
+};
+
+} // namespace Server
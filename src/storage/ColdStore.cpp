@@ -0,0 +1,428 @@
+/**
+ * @file ColdStore.cpp
+ * @brief Столбцовое сжатие блоков транзакций и агрегаты по статистике блоков
+ */
+
+#include "ColdStore.h"
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <fstream>
+#include <iterator>
+#include "../users/User.h"
+#include "../utils/Varint.h"
+
+namespace Storage {
+
+namespace {
+
+constexpr char COLD_MAGIC[8] = {'F', 'T', 'C', 'O', 'L', 'D', '0', '1'};
+constexpr std::uint8_t AMOUNTS_CENTS = 0;
+constexpr std::uint8_t AMOUNTS_RAW = 1;
+
+std::int64_t ticks(ColdStore::TimePoint tp) {
+    return static_cast<std::int64_t>(tp.time_since_epoch().count());
+}
+
+ColdStore::TimePoint fromTicks(std::int64_t value) {
+    return ColdStore::TimePoint(ColdStore::TimePoint::duration(value));
+}
+
+void putDouble(std::string& out, double value) {
+    out.append(reinterpret_cast<const char*>(&value), sizeof(value));
+}
+
+bool getDouble(const char*& pos, const char* end, double& value) {
+    if (static_cast<std::size_t>(end - pos) < sizeof(value)) return false;
+    std::memcpy(&value, pos, sizeof(value));
+    pos += sizeof(value);
+    return true;
+}
+
+bool inRange(std::int64_t t, std::int64_t from, std::int64_t to) {
+    return t >= from && t < to;
+}
+
+} // namespace
+
+ColdStore::ColdStore(std::size_t rowsPerBlock) : blockRows(std::max<std::size_t>(rowsPerBlock, 1)) {}
+
+std::uint32_t ColdStore::intern(const std::string& value) {
+    auto it = dictionaryIndex.find(value);
+    if (it != dictionaryIndex.end()) {
+        return it->second;
+    }
+    auto id = static_cast<std::uint32_t>(dictionary.size());
+    dictionary.push_back(value);
+    dictionaryIndex.emplace(value, id);
+    return id;
+}
+
+void ColdStore::accumulate(BlockStats& stats, const ColdRow& row) {
+    std::int64_t t = ticks(row.date);
+    if (stats.count == 0) {
+        stats.minTime = stats.maxTime = t;
+        stats.minAmount = stats.maxAmount = row.amount;
+    } else {
+        stats.minTime = std::min(stats.minTime, t);
+        stats.maxTime = std::max(stats.maxTime, t);
+        stats.minAmount = std::min(stats.minAmount, row.amount);
+        stats.maxAmount = std::max(stats.maxAmount, row.amount);
+    }
+    ++stats.count;
+    if (row.amount > 0) stats.income += row.amount;
+    else if (row.amount < 0) stats.expenses += row.amount;
+}
+
+void ColdStore::append(const Transactions::Transaction& trans) {
+    ColdRow row;
+    row.date = trans.getDate();
+    std::string type = trans.getType();
+    row.type = type == "WITHDRAWAL" ? 1 : type == "COMPOUNDING" ? 2 : 0;
+    row.account = trans.getAccountName();
+    row.category = trans.getCategoryName() == "Uncategorized" ? "" : trans.getCategoryName();
+    row.description = trans.getDescription();
+    row.amount = trans.getAmount();
+    row.currency = trans.getCurrency();
+    if (auto compounding = dynamic_cast<const Transactions::CompoundingTransaction*>(&trans)) {
+        row.period = compounding->getPeriod();
+        row.interestRate = compounding->getInterestRate();
+    }
+
+    openRows.push_back(std::move(row));
+    if (openRows.size() >= blockRows) {
+        sealBlock();
+    }
+}
+
+void ColdStore::flush() {
+    if (!openRows.empty()) {
+        sealBlock();
+    }
+}
+
+/**
+ * @brief Кодирует открытые строки в сжатый блок по столбцам
+ */
+void ColdStore::sealBlock() {
+    Block block;
+    std::string& out = block.data;
+    Varint::put(out, openRows.size());
+
+    std::int64_t prev = 0;
+    for (const auto& row : openRows) {
+        accumulate(block.stats, row);
+        std::int64_t t = ticks(row.date);
+        Varint::putSigned(out, t - prev);
+        prev = t;
+    }
+    for (const auto& row : openRows) {
+        out += static_cast<char>(row.type);
+        out += static_cast<char>(row.currency);
+    }
+    for (const auto& row : openRows) Varint::put(out, intern(row.account));
+    for (const auto& row : openRows) Varint::put(out, row.category.empty() ? 0 : intern(row.category) + 1);
+    for (const auto& row : openRows) Varint::put(out, intern(row.description));
+
+    // Суммы в копейках относительно минимума блока, если все представимы точно
+    bool cents = true;
+    std::int64_t base = 0;
+    std::vector<std::int64_t> values;
+    values.reserve(openRows.size());
+    for (const auto& row : openRows) {
+        double scaled = row.amount * 100.0;
+        if (!(std::fabs(scaled) < 9e15) || static_cast<double>(std::llround(scaled)) / 100.0 != row.amount) {
+            cents = false;
+            break;
+        }
+        values.push_back(std::llround(scaled));
+    }
+    if (cents) {
+        base = *std::min_element(values.begin(), values.end());
+        out += static_cast<char>(AMOUNTS_CENTS);
+        Varint::putSigned(out, base);
+        for (auto v : values) Varint::put(out, static_cast<std::uint64_t>(v - base));
+    } else {
+        out += static_cast<char>(AMOUNTS_RAW);
+        for (const auto& row : openRows) putDouble(out, row.amount);
+    }
+
+    for (const auto& row : openRows) {
+        if (row.type == 2) {
+            Varint::putSigned(out, row.period);
+            putDouble(out, row.interestRate);
+        }
+    }
+
+    out.shrink_to_fit();
+    blocks.push_back(std::move(block));
+    openRows.clear();
+}
+
+bool ColdStore::decodeBlock(const Block& block, std::vector<ColdRow>& rows) const {
+    const char* pos = block.data.data();
+    const char* end = pos + block.data.size();
+
+    std::uint64_t count = 0;
+    if (!Varint::get(pos, end, count)) return false;
+    // Счетчик приходит из файла: каждая строка занимает хотя бы байт в столбце
+    // времени, так что больший счетчик — признак повреждения, а не повод для resize
+    if (count != block.stats.count || count > static_cast<std::uint64_t>(end - pos)) return false;
+    std::size_t first = rows.size();
+    rows.resize(first + count);
+    ColdRow* r = rows.data() + first;
+
+    std::int64_t t = 0;
+    for (std::uint64_t i = 0; i < count; ++i) {
+        std::int64_t delta = 0;
+        if (!Varint::getSigned(pos, end, delta)) return false;
+        t += delta;
+        r[i].date = fromTicks(t);
+    }
+    if (static_cast<std::uint64_t>(end - pos) < count * 2) return false;
+    for (std::uint64_t i = 0; i < count; ++i) {
+        r[i].type = static_cast<std::uint8_t>(*pos++);
+        auto currency = static_cast<std::uint8_t>(*pos++);
+        r[i].currency = currency < CURRENCY_COUNT ? static_cast<Currency>(currency) : Currency::RUB;
+    }
+
+    auto lookup = [&](std::uint64_t id, std::string& target) {
+        if (id >= dictionary.size()) return false;
+        target = dictionary[id];
+        return true;
+    };
+    std::uint64_t id = 0;
+    for (std::uint64_t i = 0; i < count; ++i) {
+        if (!Varint::get(pos, end, id) || !lookup(id, r[i].account)) return false;
+    }
+    for (std::uint64_t i = 0; i < count; ++i) {
+        if (!Varint::get(pos, end, id)) return false;
+        if (id != 0 && !lookup(id - 1, r[i].category)) return false;
+    }
+    for (std::uint64_t i = 0; i < count; ++i) {
+        if (!Varint::get(pos, end, id) || !lookup(id, r[i].description)) return false;
+    }
+
+    if (pos >= end) return false;
+    auto encoding = static_cast<std::uint8_t>(*pos++);
+    if (encoding == AMOUNTS_CENTS) {
+        std::int64_t base = 0;
+        if (!Varint::getSigned(pos, end, base)) return false;
+        for (std::uint64_t i = 0; i < count; ++i) {
+            std::uint64_t offset = 0;
+            if (!Varint::get(pos, end, offset)) return false;
+            r[i].amount = static_cast<double>(base + static_cast<std::int64_t>(offset)) / 100.0;
+        }
+    } else {
+        for (std::uint64_t i = 0; i < count; ++i) {
+            if (!getDouble(pos, end, r[i].amount)) return false;
+        }
+    }
+
+    for (std::uint64_t i = 0; i < count; ++i) {
+        if (r[i].type != 2) continue;
+        std::int64_t period = 0;
+        if (!Varint::getSigned(pos, end, period) || !getDouble(pos, end, r[i].interestRate)) return false;
+        r[i].period = static_cast<int>(period);
+    }
+    return true;
+}
+
+Aggregate ColdStore::aggregate(TimePoint from, TimePoint to) const {
+    Aggregate result;
+    std::int64_t lo = ticks(from);
+    std::int64_t hi = ticks(to);
+
+    auto addRow = [&](const ColdRow& row) {
+        if (!inRange(ticks(row.date), lo, hi)) return;
+        ++result.count;
+        if (row.amount > 0) result.income += row.amount;
+        else if (row.amount < 0) result.expenses += row.amount;
+    };
+
+    std::vector<ColdRow> rows;
+    for (const auto& block : blocks) {
+        const auto& s = block.stats;
+        if (s.count == 0 || s.maxTime < lo || s.minTime >= hi) {
+            continue;
+        }
+        if (s.minTime >= lo && s.maxTime < hi) {
+            result.count += s.count;
+            result.income += s.income;
+            result.expenses += s.expenses;
+            ++result.blocksFromStats;
+            continue;
+        }
+        rows.clear();
+        if (decodeBlock(block, rows)) {
+            for (const auto& row : rows) addRow(row);
+        }
+        ++result.blocksDecoded;
+    }
+    for (const auto& row : openRows) {
+        addRow(row);
+    }
+    return result;
+}
+
+std::vector<ColdRow> ColdStore::scan(TimePoint from, TimePoint to) const {
+    std::int64_t lo = ticks(from);
+    std::int64_t hi = ticks(to);
+    std::vector<ColdRow> result;
+    std::vector<ColdRow> rows;
+    for (const auto& block : blocks) {
+        if (block.stats.count == 0 || block.stats.maxTime < lo || block.stats.minTime >= hi) {
+            continue;
+        }
+        rows.clear();
+        if (!decodeBlock(block, rows)) continue;
+        for (auto& row : rows) {
+            if (inRange(ticks(row.date), lo, hi)) result.push_back(std::move(row));
+        }
+    }
+    for (const auto& row : openRows) {
+        if (inRange(ticks(row.date), lo, hi)) result.push_back(row);
+    }
+    return result;
+}
+
+std::vector<std::shared_ptr<Transactions::Transaction>> ColdStore::materialize(
+    TimePoint from, TimePoint to, const User& owner) const {
+    std::vector<std::shared_ptr<Transactions::Transaction>> result;
+    for (const auto& row : scan(from, to)) {
+        auto account = owner.findAccount(row.account);
+        auto category = row.category.empty() ? nullptr : owner.findCategory(row.category);
+
+        std::shared_ptr<Transactions::Transaction> trans;
+        switch (row.type) {
+            case 1:
+                trans = std::make_shared<Transactions::WithdrawalTransaction>(-row.amount, row.description, category, account);
+                break;
+            case 2:
+                trans = std::make_shared<Transactions::CompoundingTransaction>(
+                    row.amount, row.description, row.period, row.interestRate, category, account);
+                break;
+            default:
+                trans = std::make_shared<Transactions::DepositTransaction>(row.amount, row.description, category, account);
+                break;
+        }
+        trans->setDate(row.date);
+        trans->setCurrency(row.currency);
+        result.push_back(std::move(trans));
+    }
+    return result;
+}
+
+std::size_t ColdStore::size() const {
+    std::size_t total = openRows.size();
+    for (const auto& block : blocks) {
+        total += block.stats.count;
+    }
+    return total;
+}
+
+std::size_t ColdStore::getCompressedBytes() const {
+    std::size_t total = 0;
+    for (const auto& block : blocks) {
+        total += sizeof(Block) + block.data.capacity();
+    }
+    for (const auto& word : dictionary) {
+        total += sizeof(std::string) + word.capacity();
+    }
+    return total;
+}
+
+bool ColdStore::saveToFile(const std::string& filename) const {
+    std::ofstream file(filename, std::ios::binary);
+    if (!file.is_open()) {
+        return false;
+    }
+    std::string out;
+    encode(out);
+    file.write(out.data(), static_cast<std::streamsize>(out.size()));
+    return static_cast<bool>(file);
+}
+
+void ColdStore::encode(std::string& out) const {
+    // Открытые строки сохраняются отдельным блоком во временной копии
+    ColdStore pending(blockRows);
+    pending.dictionary = dictionary;
+    pending.dictionaryIndex = dictionaryIndex;
+    pending.openRows = openRows;
+    pending.flush();
+
+    out.append(COLD_MAGIC, sizeof(COLD_MAGIC));
+    Varint::put(out, blockRows);
+    Varint::put(out, pending.dictionary.size());
+    for (const auto& word : pending.dictionary) {
+        Varint::put(out, word.size());
+        out += word;
+    }
+    Varint::put(out, blocks.size() + pending.blocks.size());
+    auto writeBlock = [&out](const Block& block) {
+        out.append(reinterpret_cast<const char*>(&block.stats), sizeof(BlockStats));
+        Varint::put(out, block.data.size());
+        out += block.data;
+    };
+    for (const auto& block : blocks) writeBlock(block);
+    for (const auto& block : pending.blocks) writeBlock(block);
+}
+
+bool ColdStore::loadFromFile(const std::string& filename) {
+    std::ifstream file(filename, std::ios::binary);
+    if (!file.is_open()) {
+        lastError = "cannot open " + filename;
+        return false;
+    }
+    std::string in((std::istreambuf_iterator<char>(file)), std::istreambuf_iterator<char>());
+    if (!decode(in.data(), in.size())) {
+        lastError = filename + ": " + lastError;
+        return false;
+    }
+    return true;
+}
+
+bool ColdStore::decode(const char* data, std::size_t size) {
+    const char* pos = data;
+    const char* end = data + size;
+
+    auto fail = [&]() {
+        lastError = "corrupted cold store";
+        return false;
+    };
+    if (size < sizeof(COLD_MAGIC) || std::memcmp(pos, COLD_MAGIC, sizeof(COLD_MAGIC)) != 0) {
+        return fail();
+    }
+    pos += sizeof(COLD_MAGIC);
+
+    ColdStore loaded;
+    std::uint64_t value = 0;
+    if (!Varint::get(pos, end, value)) return fail();
+    loaded.blockRows = std::max<std::size_t>(value, 1);
+
+    std::uint64_t words = 0;
+    if (!Varint::get(pos, end, words)) return fail();
+    for (std::uint64_t i = 0; i < words; ++i) {
+        if (!Varint::get(pos, end, value) || static_cast<std::uint64_t>(end - pos) < value) return fail();
+        loaded.intern(std::string(pos, value));
+        pos += value;
+    }
+
+    std::uint64_t blockCount = 0;
+    if (!Varint::get(pos, end, blockCount)) return fail();
+    for (std::uint64_t i = 0; i < blockCount; ++i) {
+        Block block;
+        if (static_cast<std::size_t>(end - pos) < sizeof(BlockStats)) return fail();
+        std::memcpy(&block.stats, pos, sizeof(BlockStats));
+        pos += sizeof(BlockStats);
+        if (!Varint::get(pos, end, value) || static_cast<std::uint64_t>(end - pos) < value) return fail();
+        block.data.assign(pos, value);
+        pos += value;
+        loaded.blocks.push_back(std::move(block));
+    }
+
+    *this = std::move(loaded);
+    return true;
+}
+
+} // namespace Storage
@@ -0,0 +1,138 @@
+#pragma once
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <unordered_map>
+#include <vector>
+#include "../transactions/Transaction.h"
+#include "../currency/Currency.h"
+
+class User;
+
+namespace Storage {
+
+/**
+ * @brief Статистика блока, по которой агрегаты считаются без распаковки
+ */
+struct BlockStats {
+    std::int64_t minTime = 0;   // тики system_clock
+    std::int64_t maxTime = 0;
+    std::uint32_t count = 0;
+    double income = 0.0;        // сумма положительных сумм
+    double expenses = 0.0;      // сумма отрицательных сумм
+    double minAmount = 0.0;
+    double maxAmount = 0.0;
+};
+
+/**
+ * @brief Итог агрегации по диапазону времени
+ */
+struct Aggregate {
+    std::size_t count = 0;
+    double income = 0.0;
+    double expenses = 0.0;
+    std::size_t blocksFromStats = 0;   // блоков, учтённых только по статистике
+    std::size_t blocksDecoded = 0;     // блоков, которые пришлось распаковать
+
+    double net() const { return income + expenses; }
+};
+
+/**
+ * @brief Распакованная строка холодного хранилища
+ */
+struct ColdRow {
+    std::chrono::system_clock::time_point date;
+    std::uint8_t type = 0;          // 0 — DEPOSIT, 1 — WITHDRAWAL, 2 — COMPOUNDING
+    std::string account;
+    std::string category;           // пусто — без категории
+    std::string description;
+    double amount = 0.0;            // со знаком, как Transaction::getAmount()
+    Currency currency = Currency::RUB;
+    int period = 0;
+    double interestRate = 0.0;
+};
+
+/**
+ * @brief Холодное хранилище исторических транзакций
+ *
+ * Транзакции копятся в открытом блоке, а по заполнении блок сжимается
+ * по столбцам: время — дельты zigzag-varint, счета/категории/описания —
+ * номера в общих словарях, суммы — копейки с опорным значением блока
+ * (frame-of-reference) в varint. Если сумма не представима в копейках,
+ * блок хранит суммы как double. Для каждого блока хранится min/max/sum,
+ * поэтому агрегаты по диапазону, целиком покрывающему блок, считаются
+ * без распаковки.
+ */
+class ColdStore {
+public:
+    using TimePoint = std::chrono::system_clock::time_point;
+
+private:
+    struct Block {
+        BlockStats stats;
+        std::string data;
+    };
+
+    std::size_t blockRows;
+    std::vector<Block> blocks;
+    std::vector<ColdRow> openRows;
+
+    std::vector<std::string> dictionary;
+    std::unordered_map<std::string, std::uint32_t> dictionaryIndex;
+    std::string lastError;
+
+    std::uint32_t intern(const std::string& value);
+    void sealBlock();
+    bool decodeBlock(const Block& block, std::vector<ColdRow>& rows) const;
+    static void accumulate(BlockStats& stats, const ColdRow& row);
+
+public:
+    explicit ColdStore(std::size_t rowsPerBlock = 4096);
+
+    /**
+     * @brief Добавляет транзакцию в хранилище
+     */
+    void append(const Transactions::Transaction& trans);
+    /**
+     * @brief Сжимает открытый блок, даже если он не заполнен
+     */
+    void flush();
+
+    /**
+     * @brief Агрегаты по диапазону [from, to)
+     */
+    Aggregate aggregate(TimePoint from, TimePoint to) const;
+    double getTotalIncome(TimePoint from, TimePoint to) const { return aggregate(from, to).income; }
+    double getTotalExpenses(TimePoint from, TimePoint to) const { return aggregate(from, to).expenses; }
+    double getNetBalance(TimePoint from, TimePoint to) const { return aggregate(from, to).net(); }
+
+    /**
+     * @brief Распаковывает строки диапазона [from, to)
+     */
+    std::vector<ColdRow> scan(TimePoint from, TimePoint to) const;
+    /**
+     * @brief Восстанавливает транзакции диапазона, связывая их со счетами и категориями пользователя
+     */
+    std::vector<std::shared_ptr<Transactions::Transaction>> materialize(
+        TimePoint from, TimePoint to, const User& owner) const;
+
+    bool saveToFile(const std::string& filename) const;
+    bool loadFromFile(const std::string& filename);
+    /**
+     * @brief Тот же формат в памяти (выгрузка пользователя, снимок состояния)
+     */
+    void encode(std::string& out) const;
+    bool decode(const char* data, std::size_t size);
+
+    std::size_t size() const;
+    std::size_t getBlockCount() const { return blocks.size(); }
+    /**
+     * @brief Приблизительный объём памяти сжатых данных и словаря в байтах
+     */
+    std::size_t getCompressedBytes() const;
+    const std::string& getLastError() const { return lastError; }
+};
+
+} // namespace Storage
@@ -15,7 +15,8 @@ Transaction::Transaction(
     std::shared_ptr<Category> cat,
     std::shared_ptr<Account> acc
 )
-    : amount(amt), description(desc), category(cat), account(acc) {
+    : amount(amt), description(desc), category(cat), account(acc),
+      currency(acc ? acc->getCurrency() : Currency::RUB) {
     date = std::chrono::system_clock::now();
 }
 
@@ -81,7 +82,7 @@ DepositTransaction::DepositTransaction(
  */
 void DepositTransaction::execute() {
     std::cout << "Deposit executed: +" << amount << " to " 
-    << getAccountName() << std::endl;
+    << getAccountName() << "\n";
 }
 
 /**
@@ -90,7 +91,7 @@ void DepositTransaction::execute() {
  */
 void DepositTransaction::undo() {
     std::cout << "Deposit undone: -" << amount << " from " 
-    << getAccountName() << std::endl;
+    << getAccountName() << "\n";
 }
 
 
@@ -114,7 +115,7 @@ WithdrawalTransaction::WithdrawalTransaction(
  */
 void WithdrawalTransaction::execute() {
     std::cout << "Withdrawal executed: " << amount << " from " 
-    << getAccountName() << std::endl;
+    << getAccountName() << "\n";
 }
 
 /**
@@ -123,7 +124,7 @@ void WithdrawalTransaction::execute() {
  */
 void WithdrawalTransaction::undo() {
     std::cout << "Withdrawal undone: +" << -amount << " to " 
-    << getAccountName() << std::endl;
+    << getAccountName() << "\n";
 }
 
 /**
@@ -151,7 +152,7 @@ CompoundingTransaction::CompoundingTransaction(
 void CompoundingTransaction::execute() {
     double interest = calculateCompoundInterest();
     std::cout << "Compounding executed: " << interest << " interest for " 
-    << period << " days on " << getAccountName() << std::endl;
+    << period << " days on " << getAccountName() << "\n";
 }
 
 /**
@@ -159,7 +160,7 @@ void CompoundingTransaction::execute() {
  * 
  */
 void CompoundingTransaction::undo() {
-    std::cout << "Compounding undone on " << getAccountName() << std::endl;
+    std::cout << "Compounding undone on " << getAccountName() << "\n";
 }
 
 /**
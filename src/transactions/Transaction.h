@@ -4,7 +4,7 @@
 #include <memory>
 #include <chrono>
 #include <vector>
-
+#include "../currency/Currency.h"
 
 class Category;
 class Account;
@@ -22,6 +22,7 @@ protected:
     std::chrono::system_clock::time_point date;
     std::shared_ptr<Category> category;
     std::shared_ptr<Account> account;
+    Currency currency; // валюта суммы, по умолчанию — валюта счета
 
 public:
     Transaction(
@@ -37,8 +38,13 @@ public:
 
 
     double getAmount() const { return amount; }
-    std::string getDescription() const { return description; }
+    const std::string& getDescription() const { return description; }
+    Currency getCurrency() const { return currency; }
+    void setCurrency(Currency c) { currency = c; }
     auto getDate() const { return date; }
+    void setDate(std::chrono::system_clock::time_point d) { date = d; }
+    const std::shared_ptr<Account>& getAccount() const { return account; }
+    const std::shared_ptr<Category>& getCategory() const { return category; }
     std::string getCategoryName() const;
     std::string getAccountName() const;
     std::string getFormattedDate() const;
@@ -101,6 +107,8 @@ public:
     std::string getType() const override { return "COMPOUNDING"; }
     
     double calculateCompoundInterest() const;
+    int getPeriod() const { return period; }
+    double getInterestRate() const { return interestRate; }
 };
 
 }
\ No newline at end of file
@@ -4,12 +4,39 @@
  */
 
 #include "User.h"
+#include <atomic>
+#include "../metrics/Metrics.h"
+
+namespace {
+// Общие для всех пользователей часы версий: версии разных объектов User
+// не совпадают, даже если новый объект занял адрес удаленного
+std::atomic<std::uint64_t> historyClock{0};
+
+// Блок счетчиков ссылок, размещенный make_shared вместе с объектом
+constexpr std::size_t SHARED_BLOCK_BYTES = 2 * sizeof(long);
+
+// Строка вне встроенного буфера (SSO) занимает capacity + 1 байт в куче
+std::size_t heapBytes(const std::string& text) {
+    return text.capacity() >= sizeof(std::string) ? text.capacity() + 1 : 0;
+}
+
+std::size_t accountBytes(const Account& account) {
+    std::size_t object = dynamic_cast<const CreditAccount*>(&account) ? sizeof(CreditAccount) : sizeof(DebitAccount);
+    return object + SHARED_BLOCK_BYTES + heapBytes(account.getName());
+}
+
+std::size_t categoryBytes(const Category& category) {
+    std::size_t object = dynamic_cast<const ExpenseCategory*>(&category) ? sizeof(ExpenseCategory) : sizeof(Category);
+    return object + SHARED_BLOCK_BYTES + heapBytes(category.getName());
+}
+}
 
 /**
  * @brief Конструктор класса User
  * @param username Имя пользователя
  */
-User::User(const std::string& username) : name(username) {}
+User::User(const std::string& username)
+    : name(username), historyVersion(++historyClock), lastRewrite(historyVersion) {}
 
 /**
  * @brief Добавляет новый счет пользователю
@@ -25,6 +52,169 @@ void User::addAccount(std::shared_ptr<Account> acc) {
  */
 void User::addCategory(std::shared_ptr<Category> cat) {
     categories.push_back(cat);
+    categoryTree.addCategory(cat);
+}
+
+/**
+ * @brief Переносит категорию под другого родителя; раскладка дерева итогов перестроится при запросе
+ * @param cat Категория пользователя
+ * @param parent Новый родитель или nullptr
+ */
+bool User::setCategoryParent(const std::shared_ptr<Category>& cat, std::shared_ptr<Category> parent) {
+    if (!cat->setParent(std::move(parent))) {
+        return false;
+    }
+    categoryTree.invalidateLayout();
+    return true;
+}
+
+/**
+ * @brief Добавляет транзакцию в историю пользователя
+ * @param trans Умный указатель на транзакцию
+ */
+void User::addTransaction(std::shared_ptr<Transactions::Transaction> trans) {
+    // undo снимает с конца истории транзакцию последней операции журнала;
+    // после дописывания мимо журнала это была бы другая транзакция
+    commands.clear();
+    clearUndone();
+    categoryTree.addTransaction(*trans);
+    transactionBytes += getTransactionBytes(*trans);
+    transactions.push_back(trans);
+    touchHistory(true);
+}
+
+/**
+ * @brief Снимает последнюю транзакцию истории
+ * @return false если история пуста
+ */
+bool User::removeLastTransaction() {
+    if (transactions.empty()) {
+        return false;
+    }
+    commands.clear();
+    clearUndone();
+    categoryTree.removeTransaction(*transactions.back());
+    transactionBytes -= getTransactionBytes(*transactions.back());
+    transactions.pop_back();
+    touchHistory(false);
+    return true;
+}
+
+/**
+ * @brief Увеличивает версию истории
+ * @param appendOnly true если транзакции только добавлены в конец
+ */
+void User::touchHistory(bool appendOnly) {
+    historyVersion = ++historyClock;
+    if (!appendOnly) {
+        lastRewrite = historyVersion;
+    }
+}
+
+/**
+ * @brief Проводит транзакцию по счету с записью в журнал команд
+ * @param trans Транзакция со счетом этого пользователя
+ * @return false если счет чужой или списание отклонено; тогда ничего не меняется
+ */
+bool User::post(std::shared_ptr<Transactions::Transaction> trans) {
+    METRICS_TIMER(TransactionExecute);
+    const auto& account = trans->getAccount();
+    std::size_t index = 0;
+    while (index < accounts.size() && accounts[index] != account) {
+        ++index;
+    }
+    if (index == accounts.size()) {
+        return false;
+    }
+
+    // Нулевая сумма проводится без изменения баланса
+    double before = account->getBalance();
+    double amount = trans->getAmount();
+    if ((amount > 0 && !account->deposit(amount)) || (amount < 0 && !account->withdraw(-amount))) {
+        return false;
+    }
+    commands.record(static_cast<std::uint32_t>(index), account->getBalance() - before,
+                    History::CommandLog::WITH_TRANSACTION);
+    clearUndone();
+    categoryTree.addTransaction(*trans);
+    transactionBytes += getTransactionBytes(*trans);
+    transactions.push_back(std::move(trans));
+    touchHistory(true);
+    METRICS_INC(TransactionExecuted);
+    return true;
+}
+
+/**
+ * @brief Сбрасывает отмененные транзакции: после новой проводки их не повторить
+ */
+void User::clearUndone() {
+    for (const auto& trans : undoneTransactions) {
+        transactionBytes -= getTransactionBytes(*trans);
+    }
+    undoneTransactions.clear();
+}
+
+/**
+ * @brief Изменяет баланс напрямую: отмена и повтор не проверяют лимиты счета
+ */
+void User::applyDelta(std::uint32_t account, double delta) {
+    if (account < accounts.size()) {
+        accounts[account]->setBalance(accounts[account]->getBalance() + delta);
+    }
+}
+
+/**
+ * @brief Отменяет последнюю операцию журнала команд
+ */
+bool User::undo() {
+    METRICS_TIMER(TransactionUndo);
+    const auto* rec = commands.undo();
+    if (!rec) {
+        return false;
+    }
+    applyDelta(rec->account, -rec->delta);
+    if ((rec->flags & History::CommandLog::WITH_TRANSACTION) && !transactions.empty()) {
+        categoryTree.removeTransaction(*transactions.back());
+        undoneTransactions.push_back(std::move(transactions.back()));
+        transactions.pop_back();
+        touchHistory(false);
+    }
+    METRICS_INC(TransactionUndone);
+    return true;
+}
+
+/**
+ * @brief Повторяет последнюю отмененную операцию
+ */
+bool User::redo() {
+    METRICS_TIMER(TransactionExecute);
+    const auto* rec = commands.redo();
+    if (!rec) {
+        return false;
+    }
+    applyDelta(rec->account, rec->delta);
+    if ((rec->flags & History::CommandLog::WITH_TRANSACTION) && !undoneTransactions.empty()) {
+        categoryTree.addTransaction(*undoneTransactions.back());
+        transactions.push_back(std::move(undoneTransactions.back()));
+        undoneTransactions.pop_back();
+        touchHistory(true);
+    }
+    METRICS_INC(TransactionExecuted);
+    return true;
+}
+
+/**
+ * @brief Откатывает все операции после контрольной точки
+ * @param point Значение checkpoint()
+ */
+bool User::rollbackTo(std::uint64_t point) {
+    if (point < commands.getOldest() || point > commands.getPosition()) {
+        return false;
+    }
+    while (commands.getPosition() > point) {
+        undo();
+    }
+    return true;
 }
 
 /**
@@ -43,6 +233,123 @@ const std::vector<std::shared_ptr<Category>>& User::getCategories() const {
     return categories;
 }
 
+/**
+ * @brief Получает историю транзакций пользователя
+ * @return Константная ссылка на вектор умных указателей на транзакции
+ */
+const std::vector<std::shared_ptr<Transactions::Transaction>>& User::getTransactions() const {
+    return transactions;
+}
+
+/**
+ * @brief Оценка памяти: счета, категории, транзакции и служебные структуры
+ */
+UserMemory User::getMemoryUsage() const {
+    UserMemory usage;
+    usage.accounts = accounts.capacity() * sizeof(std::shared_ptr<Account>);
+    for (const auto& acc : accounts) {
+        usage.accounts += accountBytes(*acc);
+    }
+    usage.categories = categories.capacity() * sizeof(std::shared_ptr<Category>);
+    for (const auto& cat : categories) {
+        usage.categories += categoryBytes(*cat);
+    }
+    usage.transactions = transactionBytes +
+        (transactions.capacity() + undoneTransactions.capacity()) * sizeof(std::shared_ptr<Transactions::Transaction>);
+    usage.caches = sizeof(User) + heapBytes(name) + categoryTree.memoryBytes() + commands.memoryBytes();
+    usage.archive = archive.getCompressedBytes();
+    return usage;
+}
+
+std::size_t User::getTransactionBytes(const Transactions::Transaction& trans) {
+    std::size_t object = dynamic_cast<const Transactions::CompoundingTransaction*>(&trans)
+        ? sizeof(Transactions::CompoundingTransaction) : sizeof(Transactions::DepositTransaction);
+    return object + SHARED_BLOCK_BYTES + heapBytes(trans.getDescription());
+}
+
+/**
+ * @brief Извлекает из истории транзакции с датой раньше cutoff
+ * @param cutoff Граница по времени
+ * @return Извлеченные транзакции в исходном порядке
+ */
+std::vector<std::shared_ptr<Transactions::Transaction>> User::extractTransactionsBefore(
+    std::chrono::system_clock::time_point cutoff) {
+    std::vector<std::shared_ptr<Transactions::Transaction>> extracted;
+    std::vector<std::shared_ptr<Transactions::Transaction>> kept;
+    for (auto& trans : transactions) {
+        if (trans->getDate() < cutoff) {
+            categoryTree.removeTransaction(*trans);
+            extracted.push_back(std::move(trans));
+        } else {
+            kept.push_back(std::move(trans));
+        }
+    }
+    transactions = std::move(kept);
+    if (!extracted.empty()) {
+        touchHistory(false);
+    }
+    for (const auto& trans : extracted) {
+        transactionBytes -= getTransactionBytes(*trans);
+    }
+    // Журнал команд ссылается на хвост истории, после выемки он недействителен
+    commands.clear();
+    clearUndone();
+    return extracted;
+}
+
+std::size_t User::archiveBefore(std::chrono::system_clock::time_point cutoff) {
+    auto old = extractTransactionsBefore(cutoff);
+    for (const auto& trans : old) {
+        categoryTree.addTransaction(*trans);
+        if (const auto& acc = trans->getAccount()) {
+            acc->setOpeningBalance(acc->getOpeningBalance() + trans->getAmount());
+        }
+        archive.append(*trans);
+    }
+    archive.flush();
+    return old.size();
+}
+
+void User::restoreArchive(Storage::ColdStore store) {
+    for (const auto& trans : archive.materialize(Storage::ColdStore::TimePoint::min(),
+                                                 Storage::ColdStore::TimePoint::max(), *this)) {
+        categoryTree.removeTransaction(*trans);
+    }
+    archive = std::move(store);
+    for (const auto& trans : archive.materialize(Storage::ColdStore::TimePoint::min(),
+                                                 Storage::ColdStore::TimePoint::max(), *this)) {
+        categoryTree.addTransaction(*trans);
+    }
+}
+
+/**
+ * @brief Ищет счет по названию
+ * @param accName Название счета
+ * @return Указатель на счет или nullptr
+ */
+std::shared_ptr<Account> User::findAccount(const std::string& accName) const {
+    for (const auto& acc : accounts) {
+        if (acc->getName() == accName) {
+            return acc;
+        }
+    }
+    return nullptr;
+}
+
+/**
+ * @brief Ищет категорию по названию
+ * @param categoryName Название категории
+ * @return Указатель на категорию или nullptr
+ */
+std::shared_ptr<Category> User::findCategory(const std::string& categoryName) const {
+    for (const auto& cat : categories) {
+        if (cat->getName() == categoryName) {
+            return cat;
+        }
+    }
+    return nullptr;
+}
+
 /**
  * @brief Получает имя пользователя
  * @return Строка с именем пользователя
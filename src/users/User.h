@@ -1,9 +1,39 @@
 #pragma once
+#include <cstddef>
 #include <string>
 #include <vector>
 #include <memory>
 #include "../accounts/Account.h"
 #include "../categories/Category.h"
+#include "../categories/CategoryTree.h"
+#include "../transactions/Transaction.h"
+#include "../history/CommandLog.h"
+#include "../storage/ColdStore.h"
+
+/**
+ * @brief Оценка памяти пользователя в байтах по видам данных
+ *
+ * Учитываются объекты, строки вне встроенного буфера, емкость векторов
+ * и блоки счетчиков shared_ptr; накладные расходы распределителя — нет.
+ */
+struct UserMemory {
+    std::size_t accounts = 0;
+    std::size_t categories = 0;
+    std::size_t transactions = 0;  // история и отмененные транзакции, ждущие redo
+    std::size_t caches = 0;        // дерево итогов, журнал команд, индексы, сам объект User
+    std::size_t archive = 0;       // сжатые блоки и словарь холодного хранилища
+
+    std::size_t total() const { return accounts + categories + transactions + caches + archive; }
+
+    UserMemory& operator+=(const UserMemory& other) {
+        accounts += other.accounts;
+        categories += other.categories;
+        transactions += other.transactions;
+        caches += other.caches;
+        archive += other.archive;
+        return *this;
+    }
+};
 
 /**
  * @brief Класс пользователя системы
@@ -16,6 +46,38 @@ class User {
     std::string name;
     std::vector<std::shared_ptr<Account>> accounts;
     std::vector<std::shared_ptr<Category>> categories;
+    CategoryTree categoryTree;  // иерархия категорий и итоги по поддеревьям
+    std::vector<std::shared_ptr<Transactions::Transaction>> transactions;
+    History::CommandLog commands;
+    std::vector<std::shared_ptr<Transactions::Transaction>> undoneTransactions; // ожидают redo
+    std::uint64_t historyVersion;   // растет при любом изменении истории
+    std::uint64_t lastRewrite;      // версия последнего изменения, кроме дописывания в конец
+    std::size_t transactionBytes = 0; // объекты транзакций истории и undoneTransactions
+    Storage::ColdStore archive;     // транзакции, перенесенные из истории archiveBefore
+
+    void touchHistory(bool appendOnly);
+    void clearUndone();
+
+    void applyDelta(std::uint32_t account, double delta);
+
+    // Отмена, повтор и откат не уведомляют наблюдателей журнала: снаружи
+    // они доступны через Ledger::undo/redo и откат импорта
+    friend class Ledger;
+    /**
+     * @brief Отменяет последнюю операцию журнала команд
+     * @return false если отменять нечего
+     */
+    bool undo();
+    /**
+     * @brief Повторяет последнюю отмененную операцию
+     * @return false если повторять нечего
+     */
+    bool redo();
+    /**
+     * @brief Откатывает все операции после контрольной точки
+     * @return false если точка уже вытеснена из журнала или лежит впереди
+     */
+    bool rollbackTo(std::uint64_t point);
 
 public:
     /**
@@ -34,6 +96,43 @@ public:
      * @param cat Умный указатель на категорию
      */
     void addCategory(std::shared_ptr<Category> cat);
+    /**
+     * @brief Переносит категорию пользователя под другого родителя
+     * @param cat Категория пользователя
+     * @param parent Новый родитель (nullptr — сделать корнем)
+     * @return false если перенос образует цикл
+     */
+    bool setCategoryParent(const std::shared_ptr<Category>& cat, std::shared_ptr<Category> parent);
+    /**
+     * @brief Добавляет транзакцию в историю пользователя без проводки по счету
+     *
+     * Журнал команд и отмененные транзакции сбрасываются: операции журнала
+     * больше не соответствуют концу истории.
+     * @param trans Умный указатель на транзакцию
+     */
+    void addTransaction(std::shared_ptr<Transactions::Transaction> trans);
+    /**
+     * @brief Снимает последнюю транзакцию истории без изменения балансов
+     *
+     * Обратное к addTransaction; нужно при проигрывании журнала изменений
+     * (Persistence::StateStore), где отмены записаны отдельными записями.
+     * @return false если история пуста
+     */
+    bool removeLastTransaction();
+
+    /**
+     * @brief Проводит транзакцию по ее счету и добавляет в историю с записью в журнал команд
+     * @param trans Транзакция со счетом этого пользователя
+     * @return false если счета нет у пользователя или списание отклонено;
+     *         тогда транзакция не проводится и в историю не попадает
+     */
+    bool post(std::shared_ptr<Transactions::Transaction> trans);
+    /**
+     * @brief Контрольная точка для отката группы операций
+     */
+    std::uint64_t checkpoint() const { return commands.getPosition(); }
+    History::CommandLog& getCommandLog() { return commands; }
+    const History::CommandLog& getCommandLog() const { return commands; }
 
     /**
      * @brief Получает список всех счетов пользователя
@@ -45,6 +144,79 @@ public:
      * @return Константная ссылка на вектор умных указателей на категории
      */
     const std::vector<std::shared_ptr<Category>>& getCategories() const;
+    /**
+     * @brief Иерархия категорий с итогами истории по поддеревьям
+     */
+    const CategoryTree& getCategoryTree() const { return categoryTree; }
+    /**
+     * @brief Получает историю транзакций пользователя
+     * @return Константная ссылка на вектор умных указателей на транзакции
+     */
+    const std::vector<std::shared_ptr<Transactions::Transaction>>& getTransactions() const;
+    /**
+     * @brief Версия истории транзакций, растет при каждом ее изменении
+     *
+     * Версии берутся из общего счетчика и не повторяются у разных пользователей.
+     */
+    std::uint64_t getHistoryVersion() const { return historyVersion; }
+    /**
+     * @brief Менялась ли история после версии version только дописыванием в конец
+     *
+     * Если да, первые транзакции истории совпадают с теми, что были в версии version.
+     */
+    bool isAppendOnlySince(std::uint64_t version) const {
+        return lastRewrite <= version && version <= historyVersion;
+    }
+    /**
+     * @brief Оценка занятой пользователем памяти
+     *
+     * O(число счетов и категорий): размер транзакций копится при изменении истории.
+     */
+    UserMemory getMemoryUsage() const;
+    /**
+     * @brief Оценка памяти одной транзакции вместе с ее описанием
+     */
+    static std::size_t getTransactionBytes(const Transactions::Transaction& trans);
+    /**
+     * @brief Извлекает из истории транзакции с датой раньше cutoff (для архивации)
+     *
+     * Журнал команд при этом очищается.
+     * @param cutoff Граница по времени
+     * @return Извлеченные транзакции в исходном порядке
+     */
+    std::vector<std::shared_ptr<Transactions::Transaction>> extractTransactionsBefore(
+        std::chrono::system_clock::time_point cutoff);
+    /**
+     * @brief Переносит транзакции старше cutoff из истории в холодное хранилище
+     *
+     * Начальные балансы счетов сдвигаются на суммы перенесенных транзакций,
+     * а итоги CategoryTree их по-прежнему учитывают, так что сверка и отчеты
+     * по категориям не меняются. Журнал команд очищается.
+     * @return Число перенесенных транзакций
+     */
+    std::size_t archiveBefore(std::chrono::system_clock::time_point cutoff);
+    /**
+     * @brief Холодное хранилище перенесенных транзакций
+     */
+    const Storage::ColdStore& getArchive() const { return archive; }
+    /**
+     * @brief Подставляет сохраненное хранилище (перезагрузка, снимок состояния)
+     *
+     * Начальные балансы уже учитывают архив, поэтому меняются только итоги CategoryTree.
+     */
+    void restoreArchive(Storage::ColdStore store);
+    /**
+     * @brief Ищет счет по названию
+     * @param accName Название счета
+     * @return Указатель на счет или nullptr
+     */
+    std::shared_ptr<Account> findAccount(const std::string& accName) const;
+    /**
+     * @brief Ищет категорию по названию
+     * @param categoryName Название категории
+     * @return Указатель на категорию или nullptr
+     */
+    std::shared_ptr<Category> findCategory(const std::string& categoryName) const;
     /**
      * @brief Получает имя пользователя
      * @return Строка с именем пользователя
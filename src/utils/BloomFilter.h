@@ -0,0 +1,73 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+/**
+ * @brief Блочный фильтр Блума по готовым 64-битным хешам
+ *
+ * Все биты ключа лежат в одном блоке из 512 бит (строка кэша), поэтому
+ * проверка стоит одного промаха кэша. При 10 битах на ключ доля ложных
+ * срабатываний — около 1%; ложных отказов не бывает. Хеш должен быть
+ * хорошо перемешан: блок и позиции битов берутся из разных его частей.
+ */
+class BloomFilter {
+    static constexpr std::size_t BLOCK_WORDS = 8; // 512 бит
+    static constexpr unsigned PROBES = 6;
+
+    std::vector<std::uint64_t> words;
+    std::size_t blocks = 0;
+    std::size_t capacity = 0;
+    std::size_t count = 0;
+
+    std::uint64_t* block(std::uint64_t hash) {
+        return &words[static_cast<std::size_t>((static_cast<unsigned __int128>(hash) * blocks) >> 64) * BLOCK_WORDS];
+    }
+    const std::uint64_t* block(std::uint64_t hash) const {
+        return const_cast<BloomFilter*>(this)->block(hash);
+    }
+
+public:
+    static constexpr std::size_t BITS_PER_KEY = 10;
+
+    explicit BloomFilter(std::size_t expected = 0) { reset(expected); }
+
+    /**
+     * @brief Очищает фильтр и рассчитывает его на expected ключей
+     */
+    void reset(std::size_t expected) {
+        capacity = expected < 64 ? 64 : expected;
+        blocks = (capacity * BITS_PER_KEY + BLOCK_WORDS * 64 - 1) / (BLOCK_WORDS * 64);
+        words.assign(blocks * BLOCK_WORDS, 0);
+        count = 0;
+    }
+
+    void add(std::uint64_t hash) {
+        std::uint64_t* b = block(hash);
+        // Позиции битов — 9-битные куски младшей половины хеша
+        std::uint64_t bits = hash;
+        for (unsigned i = 0; i < PROBES; ++i, bits >>= 9) {
+            unsigned bit = static_cast<unsigned>(bits & 511);
+            b[bit >> 6] |= std::uint64_t(1) << (bit & 63);
+        }
+        ++count;
+    }
+
+    bool mayContain(std::uint64_t hash) const {
+        const std::uint64_t* b = block(hash);
+        std::uint64_t bits = hash;
+        for (unsigned i = 0; i < PROBES; ++i, bits >>= 9) {
+            unsigned bit = static_cast<unsigned>(bits & 511);
+            if (!(b[bit >> 6] & (std::uint64_t(1) << (bit & 63)))) {
+                return false;
+            }
+        }
+        return true;
+    }
+
+    // Добавлено больше ключей, чем рассчитано: доля ложных срабатываний растет
+    bool isSaturated() const { return count > capacity; }
+    std::size_t size() const { return count; }
+    std::size_t getCapacity() const { return capacity; }
+    std::size_t getMemoryBytes() const { return words.capacity() * sizeof(std::uint64_t); }
+};
@@ -3,14 +3,54 @@
 #include <string>
 #include <iomanip>
 #include <sstream>
+#include <ctime>
+#include <cstddef>
 
 namespace DateUtils {
 
+// Длина строки formatTimePoint: "YYYY-MM-DD HH:MM:SS"
+constexpr std::size_t FORMATTED_TIME_POINT_SIZE = 19;
+
+/**
+ * @brief Форматирование в буфер без выделения памяти (потокобезопасно)
+ * @param out Буфер не короче FORMATTED_TIME_POINT_SIZE + 1
+ * @return Длина записанной строки
+ */
+inline std::size_t formatTimePoint(const std::chrono::system_clock::time_point& tp, char* out, std::size_t size) {
+    std::time_t time = std::chrono::system_clock::to_time_t(tp);
+    std::tm tm{};
+    localtime_r(&time, &tm);
+    return std::strftime(out, size, "%Y-%m-%d %H:%M:%S", &tm);
+}
+
 inline std::string formatTimePoint(const std::chrono::system_clock::time_point& tp) {
-    auto time_t = std::chrono::system_clock::to_time_t(tp);
-    std::stringstream ss;
-    ss << std::put_time(std::localtime(&time_t), "%Y-%m-%d %H:%M:%S");
-    return ss.str();
+    char buffer[FORMATTED_TIME_POINT_SIZE + 8];
+    return std::string(buffer, formatTimePoint(tp, buffer, sizeof(buffer)));
+}
+
+/**
+ * @brief Разбор даты в формате formatTimePoint ("%Y-%m-%d %H:%M:%S", локальное время)
+ * @return true если строка разобрана полностью
+ */
+inline bool parseTimePoint(const std::string& text, std::chrono::system_clock::time_point& tp) {
+    std::tm tm{};
+    std::istringstream ss(text);
+    ss >> std::get_time(&tm, "%Y-%m-%d %H:%M:%S");
+    if (ss.fail()) {
+        return false;
+    }
+    // Допускаются только пробелы после даты
+    ss >> std::ws;
+    if (!ss.eof()) {
+        return false;
+    }
+    tm.tm_isdst = -1;
+    std::time_t time = std::mktime(&tm);
+    if (time == static_cast<std::time_t>(-1)) {
+        return false;
+    }
+    tp = std::chrono::system_clock::from_time_t(time);
+    return true;
 }
 
 } // namespace DateUtils
\ No newline at end of file
@@ -0,0 +1,55 @@
+#pragma once
+#include <vector>
+#include <cstddef>
+
+/**
+ * @brief Дерево Фенвика: сумма на префиксе и точечное изменение за O(log n)
+ *
+ * Позиции нумеруются с нуля; сумма на отрезке [begin, end) — разность
+ * двух префиксов. Построение по готовому массиву — O(n).
+ */
+template<typename T>
+class FenwickTree {
+    std::vector<T> tree; // tree[i] — сумма (i - lowbit(i), i], нумерация с 1
+
+public:
+    explicit FenwickTree(std::size_t n = 0) : tree(n + 1, T{}) {}
+
+    /**
+     * @brief Перестраивает дерево по значениям позиций
+     */
+    void assign(const std::vector<T>& values) {
+        tree.assign(values.size() + 1, T{});
+        for (std::size_t i = 1; i <= values.size(); ++i) {
+            tree[i] += values[i - 1];
+            std::size_t up = i + (i & (~i + 1));
+            if (up <= values.size()) {
+                tree[up] += tree[i];
+            }
+        }
+    }
+
+    void add(std::size_t pos, T delta) {
+        for (std::size_t i = pos + 1; i < tree.size(); i += i & (~i + 1)) {
+            tree[i] += delta;
+        }
+    }
+
+    /**
+     * @brief Сумма позиций [0, end)
+     */
+    T prefix(std::size_t end) const {
+        T sum{};
+        for (std::size_t i = end; i > 0; i -= i & (~i + 1)) {
+            sum += tree[i];
+        }
+        return sum;
+    }
+
+    T range(std::size_t begin, std::size_t end) const {
+        return prefix(end) - prefix(begin);
+    }
+
+    std::size_t size() const { return tree.size() - 1; }
+    std::size_t memoryBytes() const { return tree.capacity() * sizeof(T); }
+};
@@ -0,0 +1,134 @@
+/**
+ * @file QuantileSketch.cpp
+ * @brief Реализация KLL-скетча квантилей
+ */
+
+#include "QuantileSketch.h"
+#include <algorithm>
+#include <cmath>
+#include <utility>
+
+/**
+ * @brief Конструктор скетча
+ * @param accuracy Параметр точности k
+ */
+QuantileSketch::QuantileSketch(std::size_t accuracy)
+    : k(std::max<std::size_t>(accuracy, 8)), rngState(0x9E3779B97F4A7C15ULL) {
+    grow();
+}
+
+/**
+ * @brief Ёмкость уровня: верхние уровни хранят k элементов, нижние — геометрически меньше
+ */
+std::size_t QuantileSketch::levelCapacity(std::size_t level) const {
+    std::size_t depth = compactors.size() - level - 1;
+    return static_cast<std::size_t>(std::ceil(std::pow(2.0 / 3.0, depth) * k)) + 1;
+}
+
+void QuantileSketch::grow() {
+    compactors.emplace_back();
+    maxStored = 0;
+    for (std::size_t h = 0; h < compactors.size(); ++h) {
+        maxStored += levelCapacity(h);
+    }
+}
+
+/**
+ * @brief Детерминированный xorshift — результат не зависит от глобального состояния
+ */
+bool QuantileSketch::coinFlip() {
+    rngState ^= rngState << 13;
+    rngState ^= rngState >> 7;
+    rngState ^= rngState << 17;
+    return rngState & 1;
+}
+
+void QuantileSketch::compress() {
+    for (std::size_t h = 0; h < compactors.size(); ++h) {
+        if (compactors[h].size() < levelCapacity(h)) continue;
+        if (h + 1 >= compactors.size()) grow();
+
+        auto& level = compactors[h];
+        std::sort(level.begin(), level.end());
+
+        // Нечётный хвост остаётся на уровне, пары сжимаются в один элемент
+        double leftover = 0.0;
+        bool hasLeftover = level.size() % 2 == 1;
+        if (hasLeftover) {
+            leftover = level.back();
+            level.pop_back();
+        }
+
+        auto& next = compactors[h + 1];
+        for (std::size_t i = coinFlip() ? 1 : 0; i < level.size(); i += 2) {
+            next.push_back(level[i]);
+        }
+        stored -= level.size() / 2;
+        level.clear();
+        if (hasLeftover) level.push_back(leftover);
+
+        if (stored < maxStored) break;
+    }
+}
+
+/**
+ * @brief Добавляет значение в скетч
+ * @param value Значение
+ */
+void QuantileSketch::update(double value) {
+    if (count == 0) {
+        minValue = maxValue = value;
+    } else {
+        minValue = std::min(minValue, value);
+        maxValue = std::max(maxValue, value);
+    }
+    ++count;
+
+    compactors[0].push_back(value);
+    if (++stored >= maxStored) {
+        compress();
+    }
+}
+
+/**
+ * @brief Оценка квантиля по взвешенным элементам всех уровней
+ * @param q Уровень квантиля в диапазоне [0, 1]
+ * @return Приближённое значение квантиля
+ */
+double QuantileSketch::quantile(double q) const {
+    if (count == 0) return 0.0;
+    if (q <= 0.0) return minValue;
+    if (q >= 1.0) return maxValue;
+
+    std::vector<std::pair<double, std::uint64_t>> weighted;
+    weighted.reserve(stored);
+    std::uint64_t totalWeight = 0;
+    for (std::size_t h = 0; h < compactors.size(); ++h) {
+        std::uint64_t weight = std::uint64_t(1) << h;
+        for (double v : compactors[h]) {
+            weighted.emplace_back(v, weight);
+            totalWeight += weight;
+        }
+    }
+    std::sort(weighted.begin(), weighted.end());
+
+    double target = q * static_cast<double>(totalWeight);
+    std::uint64_t cumulative = 0;
+    for (const auto& [value, weight] : weighted) {
+        cumulative += weight;
+        if (static_cast<double>(cumulative) >= target) {
+            return value;
+        }
+    }
+    return maxValue;
+}
+
+/**
+ * @brief Сбрасывает скетч в пустое состояние
+ */
+void QuantileSketch::clear() {
+    compactors.clear();
+    count = 0;
+    stored = 0;
+    grow();
+}
@@ -0,0 +1,52 @@
+#pragma once
+#include <vector>
+#include <cstddef>
+#include <cstdint>
+
+/**
+ * @brief Приближённый потоковый расчёт квантилей (KLL-скетч)
+ *
+ * Значения складываются в иерархию компакторов: когда уровень
+ * переполняется, он сортируется и половина элементов переносится
+ * на следующий уровень с удвоенным весом. Память — O(k log(n/k)),
+ * ошибка ранга — порядка 1/k. Минимум и максимум хранятся точно.
+ */
+class QuantileSketch {
+    std::size_t k;
+    std::size_t count = 0;
+    std::size_t stored = 0;
+    std::size_t maxStored = 0;
+    double minValue = 0.0;
+    double maxValue = 0.0;
+    std::uint64_t rngState;
+    std::vector<std::vector<double>> compactors;
+
+    std::size_t levelCapacity(std::size_t level) const;
+    void grow();
+    void compress();
+    bool coinFlip();
+
+public:
+    /**
+     * @brief Конструктор скетча
+     * @param accuracy Параметр точности k (больше — точнее и больше памяти)
+     */
+    explicit QuantileSketch(std::size_t accuracy = 200);
+
+    /**
+     * @brief Добавляет значение в скетч
+     * @param value Значение
+     */
+    void update(double value);
+
+    /**
+     * @brief Оценка квантиля
+     * @param q Уровень квантиля в диапазоне [0, 1]
+     * @return Приближённое значение квантиля (0 для пустого скетча)
+     */
+    double quantile(double q) const;
+
+    std::size_t size() const { return count; }
+    bool empty() const { return count == 0; }
+    void clear();
+};
@@ -0,0 +1,234 @@
+/**
+ * @file RoaringBitmap.cpp
+ * @brief Реализация сжатого множества номеров
+ */
+
+#include "RoaringBitmap.h"
+#include <algorithm>
+
+bool RoaringBitmap::Container::contains(std::uint16_t low) const {
+    if (isBitmap()) {
+        return (bits[low >> 6] >> (low & 63)) & 1;
+    }
+    return std::binary_search(values.begin(), values.end(), low);
+}
+
+bool RoaringBitmap::Container::add(std::uint16_t low) {
+    if (isBitmap()) {
+        std::uint64_t mask = std::uint64_t(1) << (low & 63);
+        if (bits[low >> 6] & mask) return false;
+        bits[low >> 6] |= mask;
+    } else if (values.empty() || values.back() < low) {
+        values.push_back(low);
+    } else {
+        auto it = std::lower_bound(values.begin(), values.end(), low);
+        if (*it == low) return false;
+        values.insert(it, low);
+    }
+    ++cardinality;
+    if (!isBitmap() && values.size() > ARRAY_LIMIT) {
+        toBitmap();
+    }
+    return true;
+}
+
+bool RoaringBitmap::Container::remove(std::uint16_t low) {
+    if (isBitmap()) {
+        std::uint64_t mask = std::uint64_t(1) << (low & 63);
+        if (!(bits[low >> 6] & mask)) return false;
+        bits[low >> 6] &= ~mask;
+        if (--cardinality <= ARRAY_LIMIT) {
+            toArray();
+        }
+        return true;
+    }
+    auto it = std::lower_bound(values.begin(), values.end(), low);
+    if (it == values.end() || *it != low) return false;
+    values.erase(it);
+    --cardinality;
+    return true;
+}
+
+void RoaringBitmap::Container::toBitmap() {
+    bits.assign(BITMAP_WORDS, 0);
+    for (auto low : values) {
+        bits[low >> 6] |= std::uint64_t(1) << (low & 63);
+    }
+    std::vector<std::uint16_t>().swap(values);
+}
+
+void RoaringBitmap::Container::toArray() {
+    values.clear();
+    values.reserve(cardinality);
+    for (std::size_t w = 0; w < BITMAP_WORDS; ++w) {
+        std::uint64_t word = bits[w];
+        while (word) {
+            values.push_back(static_cast<std::uint16_t>(w * 64 + __builtin_ctzll(word)));
+            word &= word - 1;
+        }
+    }
+    std::vector<std::uint64_t>().swap(bits);
+}
+
+RoaringBitmap::Container* RoaringBitmap::find(std::uint16_t key) {
+    return const_cast<Container*>(static_cast<const RoaringBitmap*>(this)->find(key));
+}
+
+const RoaringBitmap::Container* RoaringBitmap::find(std::uint16_t key) const {
+    auto it = std::lower_bound(containers.begin(), containers.end(), key,
+        [](const Container& c, std::uint16_t k) { return c.key < k; });
+    return it != containers.end() && it->key == key ? &*it : nullptr;
+}
+
+void RoaringBitmap::add(std::uint32_t value) {
+    auto key = static_cast<std::uint16_t>(value >> 16);
+    auto low = static_cast<std::uint16_t>(value & 0xFFFF);
+    if (containers.empty() || containers.back().key < key) {
+        containers.emplace_back();
+        containers.back().key = key;
+        containers.back().add(low);
+        return;
+    }
+    auto it = std::lower_bound(containers.begin(), containers.end(), key,
+        [](const Container& c, std::uint16_t k) { return c.key < k; });
+    if (it == containers.end() || it->key != key) {
+        it = containers.insert(it, Container());
+        it->key = key;
+    }
+    it->add(low);
+}
+
+void RoaringBitmap::remove(std::uint32_t value) {
+    auto key = static_cast<std::uint16_t>(value >> 16);
+    Container* c = find(key);
+    if (c && c->remove(static_cast<std::uint16_t>(value & 0xFFFF)) && c->cardinality == 0) {
+        containers.erase(containers.begin() + (c - containers.data()));
+    }
+}
+
+bool RoaringBitmap::contains(std::uint32_t value) const {
+    const Container* c = find(static_cast<std::uint16_t>(value >> 16));
+    return c && c->contains(static_cast<std::uint16_t>(value & 0xFFFF));
+}
+
+std::size_t RoaringBitmap::cardinality() const {
+    std::size_t total = 0;
+    for (const auto& c : containers) {
+        total += c.cardinality;
+    }
+    return total;
+}
+
+RoaringBitmap::Container RoaringBitmap::intersect(const Container& a, const Container& b) {
+    Container out;
+    out.key = a.key;
+    if (a.isBitmap() && b.isBitmap()) {
+        out.bits.resize(BITMAP_WORDS);
+        for (std::size_t w = 0; w < BITMAP_WORDS; ++w) {
+            out.bits[w] = a.bits[w] & b.bits[w];
+            out.cardinality += static_cast<std::uint32_t>(__builtin_popcountll(out.bits[w]));
+        }
+        if (out.cardinality <= ARRAY_LIMIT) {
+            out.toArray();
+        }
+    } else if (a.isBitmap() || b.isBitmap()) {
+        const Container& array = a.isBitmap() ? b : a;
+        const Container& bitmap = a.isBitmap() ? a : b;
+        for (auto low : array.values) {
+            if (bitmap.contains(low)) {
+                out.values.push_back(low);
+            }
+        }
+        out.cardinality = static_cast<std::uint32_t>(out.values.size());
+    } else {
+        std::set_intersection(a.values.begin(), a.values.end(), b.values.begin(), b.values.end(),
+                              std::back_inserter(out.values));
+        out.cardinality = static_cast<std::uint32_t>(out.values.size());
+    }
+    return out;
+}
+
+RoaringBitmap::Container RoaringBitmap::unite(const Container& a, const Container& b) {
+    Container out;
+    out.key = a.key;
+    if (!a.isBitmap() && !b.isBitmap()) {
+        std::set_union(a.values.begin(), a.values.end(), b.values.begin(), b.values.end(),
+                       std::back_inserter(out.values));
+        out.cardinality = static_cast<std::uint32_t>(out.values.size());
+        if (out.values.size() > ARRAY_LIMIT) {
+            out.toBitmap();
+        }
+        return out;
+    }
+    out.bits.assign(BITMAP_WORDS, 0);
+    for (const Container* c : {&a, &b}) {
+        if (c->isBitmap()) {
+            for (std::size_t w = 0; w < BITMAP_WORDS; ++w) out.bits[w] |= c->bits[w];
+        } else {
+            for (auto low : c->values) out.bits[low >> 6] |= std::uint64_t(1) << (low & 63);
+        }
+    }
+    for (auto word : out.bits) {
+        out.cardinality += static_cast<std::uint32_t>(__builtin_popcountll(word));
+    }
+    return out;
+}
+
+RoaringBitmap RoaringBitmap::operator&(const RoaringBitmap& other) const {
+    RoaringBitmap result;
+    auto a = containers.begin();
+    auto b = other.containers.begin();
+    while (a != containers.end() && b != other.containers.end()) {
+        if (a->key < b->key) {
+            ++a;
+        } else if (b->key < a->key) {
+            ++b;
+        } else {
+            Container c = intersect(*a, *b);
+            if (c.cardinality) {
+                result.containers.push_back(std::move(c));
+            }
+            ++a;
+            ++b;
+        }
+    }
+    return result;
+}
+
+RoaringBitmap& RoaringBitmap::operator&=(const RoaringBitmap& other) {
+    *this = *this & other;
+    return *this;
+}
+
+RoaringBitmap& RoaringBitmap::operator|=(const RoaringBitmap& other) {
+    std::vector<Container> merged;
+    merged.reserve(containers.size() + other.containers.size());
+    auto a = containers.begin();
+    auto b = other.containers.begin();
+    while (a != containers.end() || b != other.containers.end()) {
+        if (b == other.containers.end() || (a != containers.end() && a->key < b->key)) {
+            merged.push_back(std::move(*a++));
+        } else if (a == containers.end() || b->key < a->key) {
+            merged.push_back(*b++);
+        } else {
+            merged.push_back(unite(*a++, *b++));
+        }
+    }
+    containers = std::move(merged);
+    return *this;
+}
+
+std::vector<std::uint32_t> RoaringBitmap::toVector() const {
+    std::vector<std::uint32_t> out;
+    out.reserve(cardinality());
+    forEach([&](std::uint32_t v) { out.push_back(v); });
+    return out;
+}
+
+std::size_t RoaringBitmap::memoryBytes() const {
+    std::size_t total = containers.capacity() * sizeof(Container);
+    for (const auto& c : containers) {
+        total += c.values.capacity() * sizeof(std::uint16_t) + c.bits.capacity() * sizeof(std::uint64_t);
+    }
+    return total;
+}
@@ -0,0 +1,90 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+/**
+ * @brief Сжатое множество 32-битных номеров (roaring bitmap)
+ *
+ * Номера делятся на блоки по старшим 16 битам. Разреженный блок хранит
+ * отсортированный массив младших 16 бит (до 4096 значений, 2 байта на номер),
+ * плотный — битовую карту на 65536 бит (8 КиБ). Блок сам переключается между
+ * представлениями при добавлении и удалении, поэтому память пропорциональна
+ * min(число номеров, диапазон), а пересечение идет поблочно.
+ *
+ * Добавление возрастающих номеров (обычный случай для списков вхождений)
+ * работает за амортизированное O(1).
+ */
+class RoaringBitmap {
+    static constexpr std::size_t ARRAY_LIMIT = 4096;
+    static constexpr std::size_t BITMAP_WORDS = 1024;
+
+    struct Container {
+        std::uint16_t key = 0;
+        std::uint32_t cardinality = 0;
+        std::vector<std::uint16_t> values; // разреженное представление
+        std::vector<std::uint64_t> bits;   // плотное представление
+
+        bool isBitmap() const { return !bits.empty(); }
+        bool contains(std::uint16_t low) const;
+        bool add(std::uint16_t low);
+        bool remove(std::uint16_t low);
+        void toBitmap();
+        void toArray();
+    };
+
+    std::vector<Container> containers;
+
+    Container* find(std::uint16_t key);
+    const Container* find(std::uint16_t key) const;
+    static Container intersect(const Container& a, const Container& b);
+    static Container unite(const Container& a, const Container& b);
+
+public:
+    void add(std::uint32_t value);
+    void remove(std::uint32_t value);
+    bool contains(std::uint32_t value) const;
+
+    std::size_t cardinality() const;
+    bool empty() const { return containers.empty(); }
+    void clear() { containers.clear(); }
+
+    /**
+     * @brief Пересечение множеств
+     */
+    RoaringBitmap operator&(const RoaringBitmap& other) const;
+    RoaringBitmap& operator&=(const RoaringBitmap& other);
+    /**
+     * @brief Объединение множеств
+     */
+    RoaringBitmap& operator|=(const RoaringBitmap& other);
+
+    /**
+     * @brief Обход номеров по возрастанию
+     */
+    template<typename F>
+    void forEach(F&& f) const {
+        for (const auto& c : containers) {
+            std::uint32_t high = static_cast<std::uint32_t>(c.key) << 16;
+            if (c.isBitmap()) {
+                for (std::size_t w = 0; w < BITMAP_WORDS; ++w) {
+                    std::uint64_t word = c.bits[w];
+                    while (word) {
+                        f(high | static_cast<std::uint32_t>(w * 64 + __builtin_ctzll(word)));
+                        word &= word - 1;
+                    }
+                }
+            } else {
+                for (auto low : c.values) {
+                    f(high | low);
+                }
+            }
+        }
+    }
+
+    std::vector<std::uint32_t> toVector() const;
+    /**
+     * @brief Приблизительный объем занятой памяти в байтах
+     */
+    std::size_t memoryBytes() const;
+};
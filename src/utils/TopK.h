@@ -0,0 +1,65 @@
+#pragma once
+#include <vector>
+#include <algorithm>
+#include <utility>
+#include <cstddef>
+
+/**
+ * @brief Потоковый отбор K элементов с наибольшим ключом
+ *
+ * Хранит не более capacity элементов в min-куче по ключу, поэтому
+ * добавление стоит O(log K), а память не зависит от длины потока.
+ * Позволяет получать "топ-N" без полной сортировки исходных данных.
+ */
+template<typename T, typename Key = double>
+class TopK {
+    using Entry = std::pair<Key, T>;
+
+    std::size_t limit;
+    std::vector<Entry> heap;
+
+    static bool greaterKey(const Entry& a, const Entry& b) {
+        return a.first > b.first;
+    }
+
+public:
+    explicit TopK(std::size_t k) : limit(k) {}
+
+    /**
+     * @brief Добавляет элемент в выборку
+     * @param key Ключ ранжирования
+     * @param item Элемент
+     */
+    void push(Key key, T item) {
+        if (limit == 0) return;
+        if (heap.size() < limit) {
+            heap.emplace_back(key, std::move(item));
+            std::push_heap(heap.begin(), heap.end(), greaterKey);
+        } else if (key > heap.front().first) {
+            std::pop_heap(heap.begin(), heap.end(), greaterKey);
+            heap.back() = Entry(key, std::move(item));
+            std::push_heap(heap.begin(), heap.end(), greaterKey);
+        }
+    }
+
+    /**
+     * @brief Возвращает элементы в порядке убывания ключа
+     * @param k Сколько элементов вернуть (не больше текущего размера)
+     */
+    std::vector<T> top(std::size_t k) const {
+        std::vector<Entry> sorted(heap);
+        std::sort(sorted.begin(), sorted.end(), greaterKey);
+        if (sorted.size() > k) sorted.resize(k);
+
+        std::vector<T> result;
+        result.reserve(sorted.size());
+        for (auto& entry : sorted) {
+            result.push_back(std::move(entry.second));
+        }
+        return result;
+    }
+
+    std::size_t size() const { return heap.size(); }
+    std::size_t capacity() const { return limit; }
+    void clear() { heap.clear(); }
+};
@@ -0,0 +1,83 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+// Разбор UTF-8 и приведение регистра для латиницы, Latin-1 и кириллицы
+namespace Utf8 {
+
+/**
+ * @brief Декодирует один символ UTF-8; некорректный байт возвращается как есть
+ */
+inline std::uint32_t decode(const std::string& text, std::size_t& pos) {
+    auto byte = [&](std::size_t i) { return static_cast<unsigned char>(text[i]); };
+    std::uint32_t c = byte(pos);
+    std::size_t extra = c >= 0xF0 ? 3 : c >= 0xE0 ? 2 : c >= 0xC0 ? 1 : 0;
+    if (extra == 0 || pos + extra >= text.size()) {
+        ++pos;
+        return c;
+    }
+    std::uint32_t cp = c & (0x3F >> extra);
+    for (std::size_t i = 1; i <= extra; ++i) {
+        if ((byte(pos + i) & 0xC0) != 0x80) {
+            ++pos;
+            return c;
+        }
+        cp = (cp << 6) | (byte(pos + i) & 0x3F);
+    }
+    pos += extra + 1;
+    return cp;
+}
+
+inline void encode(std::uint32_t cp, std::string& out) {
+    if (cp < 0x80) {
+        out += static_cast<char>(cp);
+    } else if (cp < 0x800) {
+        out += static_cast<char>(0xC0 | (cp >> 6));
+        out += static_cast<char>(0x80 | (cp & 0x3F));
+    } else if (cp < 0x10000) {
+        out += static_cast<char>(0xE0 | (cp >> 12));
+        out += static_cast<char>(0x80 | ((cp >> 6) & 0x3F));
+        out += static_cast<char>(0x80 | (cp & 0x3F));
+    } else {
+        out += static_cast<char>(0xF0 | (cp >> 18));
+        out += static_cast<char>(0x80 | ((cp >> 12) & 0x3F));
+        out += static_cast<char>(0x80 | ((cp >> 6) & 0x3F));
+        out += static_cast<char>(0x80 | (cp & 0x3F));
+    }
+}
+
+inline bool isWordChar(std::uint32_t cp) {
+    if (cp < 0x80) {
+        return (cp >= '0' && cp <= '9') || (cp >= 'a' && cp <= 'z') || (cp >= 'A' && cp <= 'Z');
+    }
+    // Пробелы, знаки и символы Latin-1, общая пунктуация
+    if (cp < 0xC0 || cp == 0xD7 || cp == 0xF7 || (cp >= 0x2000 && cp <= 0x206F) || cp == 0x3000) {
+        return false;
+    }
+    return true;
+}
+
+inline std::uint32_t fold(std::uint32_t cp) {
+    if (cp >= 'A' && cp <= 'Z') return cp + 0x20;
+    if (cp >= 0xC0 && cp <= 0xDE && cp != 0xD7) return cp + 0x20;
+    if (cp >= 0x410 && cp <= 0x42F) return cp + 0x20;            // А-Я
+    if (cp >= 0x400 && cp <= 0x40F) cp += 0x50;                  // Ѐ-Џ, включая Ё
+    if (cp == 0x451) return 0x435;                               // ё -> е
+    return cp;
+}
+
+/**
+ * @brief Приводит регистр всего текста (см. fold), остальные символы не меняются
+ */
+inline std::string foldCase(const std::string& text) {
+    std::string out;
+    out.reserve(text.size());
+    std::size_t pos = 0;
+    while (pos < text.size()) {
+        encode(fold(decode(text, pos)), out);
+    }
+    return out;
+}
+
+} // namespace Utf8
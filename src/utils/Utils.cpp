@@ -0,0 +1,59 @@
+/**
+ * @file Utils.cpp
+ * @brief Реализация нешаблонных вспомогательных функций
+ */
+
+#include "Utils.h"
+
+/**
+ * @brief Разбирает строку CSV на поля
+ * @param line Строка без завершающего перевода строки
+ * @return Список полей; удвоенная кавычка внутри кавычек означает символ "
+ */
+std::vector<std::string> splitCsvLine(const std::string& line) {
+    std::vector<std::string> fields;
+    std::string field;
+    bool quoted = false;
+
+    for (std::size_t i = 0; i < line.size(); ++i) {
+        char c = line[i];
+        if (quoted) {
+            if (c == '"' && i + 1 < line.size() && line[i + 1] == '"') {
+                field += '"';
+                ++i;
+            } else if (c == '"') {
+                quoted = false;
+            } else {
+                field += c;
+            }
+        } else if (c == '"') {
+            quoted = true;
+        } else if (c == ',') {
+            fields.push_back(field);
+            field.clear();
+        } else if (c != '\r') {
+            field += c;
+        }
+    }
+    fields.push_back(field);
+    return fields;
+}
+
+/**
+ * @brief Поле CSV, которое splitCsvLine разберет обратно в value
+ * @param value Значение без перевода строки
+ */
+std::string quoteCsvField(const std::string& value) {
+    if (value.find_first_of(",\"\r") == std::string::npos) {
+        return value;
+    }
+    std::string quoted = "\"";
+    for (char c : value) {
+        if (c == '"') {
+            quoted += '"';
+        }
+        quoted += c;
+    }
+    quoted += '"';
+    return quoted;
+}
@@ -1,6 +1,10 @@
 #pragma once
 #include <vector>
 #include <memory>
+#include <cstddef>
+#include <string>
+#include "TopK.h"
+#include "../currency/FxRateTable.h"
 
 // Шаблонная функция для поиска максимального элемента
 template<typename T>
@@ -26,4 +30,35 @@ double calculateTotalBalance(const std::vector<std::shared_ptr<T>>& items) {
         }
     }
     return total;
-}
\ No newline at end of file
+}
+
+// Шаблонная функция для вычисления общего баланса в целевой валюте:
+// балансы суммируются по валютам и пересчитываются один раз на валюту
+template<typename T>
+bool calculateTotalBalance(const std::vector<std::shared_ptr<T>>& items, Currency target,
+                           const FxRateTable& rates, FxRateTable::TimePoint at, double& result) {
+    CurrencyAmounts totals{};
+    for (const auto& item : items) {
+        if (item) {
+            totals[currencyIndex(item->getCurrency())] += item->getBalance();
+        }
+    }
+    return rates.convertTotals(totals, target, at, result);
+}
+
+// Шаблонная функция для поиска K элементов с наибольшим балансом
+template<typename T>
+std::vector<std::shared_ptr<T>> findTopBalances(const std::vector<std::shared_ptr<T>>& items, std::size_t k) {
+    TopK<std::shared_ptr<T>> top(k);
+    for (const auto& item : items) {
+        if (item) {
+            top.push(item->getBalance(), item);
+        }
+    }
+    return top.top(k);
+}
+
+// Разбор строки CSV: поля через запятую, кавычки допускают запятые внутри
+std::vector<std::string> splitCsvLine(const std::string& line);
+// Поле CSV для splitCsvLine: в кавычках, если содержит запятую, кавычку или \r
+std::string quoteCsvField(const std::string& value);
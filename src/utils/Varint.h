@@ -0,0 +1,54 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+// Кодирование целых чисел переменной длины (LEB128) и zigzag для знаковых
+namespace Varint {
+
+inline void put(std::string& out, std::uint64_t value) {
+    while (value >= 0x80) {
+        out += static_cast<char>((value & 0x7F) | 0x80);
+        value >>= 7;
+    }
+    out += static_cast<char>(value);
+}
+
+inline std::uint64_t zigzag(std::int64_t value) {
+    return (static_cast<std::uint64_t>(value) << 1) ^ static_cast<std::uint64_t>(value >> 63);
+}
+
+inline std::int64_t unzigzag(std::uint64_t value) {
+    return static_cast<std::int64_t>(value >> 1) ^ -static_cast<std::int64_t>(value & 1);
+}
+
+inline void putSigned(std::string& out, std::int64_t value) {
+    put(out, zigzag(value));
+}
+
+/**
+ * @brief Чтение varint с контролем границ
+ * @return false если буфер закончился раньше конца числа
+ */
+inline bool get(const char*& pos, const char* end, std::uint64_t& value) {
+    value = 0;
+    for (unsigned shift = 0; pos < end && shift < 64; shift += 7) {
+        auto byte = static_cast<unsigned char>(*pos++);
+        value |= static_cast<std::uint64_t>(byte & 0x7F) << shift;
+        if (!(byte & 0x80)) {
+            return true;
+        }
+    }
+    return false;
+}
+
+inline bool getSigned(const char*& pos, const char* end, std::int64_t& value) {
+    std::uint64_t raw = 0;
+    if (!get(pos, end, raw)) {
+        return false;
+    }
+    value = unzigzag(raw);
+    return true;
+}
+
+} // namespace Varint